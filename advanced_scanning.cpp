@@ -1,245 +1,1020 @@
-#include <windows.h>
+#include "platform.h"
 #include <immintrin.h>
+#include <cpuid.h>
+#include <float.h>
 #include <cmath>
 #include <vector>
 #include <memory>
+#include <algorithm>
 #include "logging.h"
 #include "settings.h"
+#include "advanced_scanning.h"
 
-typedef enum {
-    VALUE_TYPE_INT,
-    VALUE_TYPE_FLOAT,
-    VALUE_TYPE_DOUBLE,
-    VALUE_TYPE_SHORT,
-    VALUE_TYPE_BYTE,
-    VALUE_TYPE_AUTO
-} ValueType;
+// Offset-emitting match kernels
+//
+// Every kernel turns one block of WIDTH positions (the vector width in
+// bytes) into a bitmask where bit i means a match starts at block + i.
+// Unaligned scans compare the block once per byte phase and shift each
+// phase's lane mask into place; aligned scans use phase 0 only. Set bits
+// are then turned into offsets with ctz.
 
+#define KERNEL_SSE2 __attribute__((target("sse2")))
+#define KERNEL_AVX2 __attribute__((target("avx2")))
+#define KERNEL_AVX512 __attribute__((target("avx512f,avx512bw,bmi2")))
+#define KERNEL_INLINE inline __attribute__((always_inline))
 
-inline __m128 _mm_abs_ps(__m128 x) {
-    static const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
-    return _mm_andnot_ps(sign_mask, x);
+enum {
+    PRED_EQ8,
+    PRED_EQ16,
+    PRED_EQ32,
+    PRED_EQ64,
+    PRED_APPROX_F32,
+    PRED_APPROX_F64,
+    PRED_AUTO,
+    PRED_AUTO_REAL,     // Auto scan for a value with a fraction
+    PRED_RANGE8,
+    PRED_RANGE16,
+    PRED_RANGE32,
+    PRED_RANGE64,
+    PRED_RANGE_F32,
+    PRED_RANGE_F64
+};
+
+static size_t KernelTypeSize(ValueType type) {
+    switch (type) {
+        case VALUE_TYPE_DOUBLE:
+        case VALUE_TYPE_INT64:
+        case VALUE_TYPE_UINT64: return 8;
+        case VALUE_TYPE_SHORT:
+        case VALUE_TYPE_UINT16: return 2;
+        case VALUE_TYPE_BYTE: return 1;
+        default: return 4;
+    }
 }
 
-bool ScanForIntValueSIMD(const BYTE* buffer, size_t bufferSize, int valueToFind) {
-    if (bufferSize < 16) {
-        for (size_t i = 0; i <= bufferSize - sizeof(int); i += sizeof(int)) {
-            int value;
-            memcpy(&value, &buffer[i], sizeof(int));
-            if (value == valueToFind)
-                return true;
-        }
-        return false;
+static bool IsUnsignedType(ValueType type) {
+    return type == VALUE_TYPE_BYTE || type == VALUE_TYPE_UINT16 || type == VALUE_TYPE_UINT32 ||
+           type == VALUE_TYPE_UINT64;
+}
+
+// Range kernels only have signed compares; flipping the sign bit of both
+// the data and the bounds orders unsigned values the same way.
+static int64_t RangeKey(int64_t value, int bits, bool flip) {
+    return flip ? (int64_t)((uint64_t)value ^ ((uint64_t)1 << (bits - 1))) : value;
+}
+
+static bool HasFraction(const ScanValue& value) {
+    return value.f != std::floor(value.f);
+}
+
+// Integers compare as raw bits of their width, so one unsigned type
+// serves both signednesses.
+template<typename T>
+static inline bool ScalarMatchAs(const BYTE* p, const ScanValue& value, double) {
+    T v;
+    memcpy(&v, p, sizeof(v));
+    return v == (T)value.i;
+}
+
+template<>
+inline bool ScalarMatchAs<float>(const BYTE* p, const ScanValue& value, double epsilon) {
+    float v;
+    memcpy(&v, p, sizeof(v));
+    return std::fabs(v - (float)value.f) < (float)epsilon;
+}
+
+template<>
+inline bool ScalarMatchAs<double>(const BYTE* p, const ScanValue& value, double epsilon) {
+    double v;
+    memcpy(&v, p, sizeof(v));
+    return std::fabs(v - value.f) < epsilon;
+}
+
+// Auto scans accept int, short and byte hits plus normal (non-denormal)
+// float and double hits; doubles only when 8 bytes are available.
+static bool ScalarAutoMatch(const BYTE* p, size_t available, const ScanValue& value, double epsilon) {
+    if (!HasFraction(value) &&
+        (ScalarMatchAs<uint32_t>(p, value, epsilon) || ScalarMatchAs<uint16_t>(p, value, epsilon) ||
+         ScalarMatchAs<uint8_t>(p, value, epsilon))) {
+        return true;
+    }
+    float f;
+    memcpy(&f, p, sizeof(f));
+    if (std::fabs(f) >= FLT_MIN && ScalarMatchAs<float>(p, value, epsilon)) {
+        return true;
+    }
+    if (available >= sizeof(double)) {
+        double d;
+        memcpy(&d, p, sizeof(d));
+        return std::fabs(d) >= DBL_MIN && ScalarMatchAs<double>(p, value, epsilon);
     }
-    
-    __m128i searchValue = _mm_set1_epi32(valueToFind);
-    
-    size_t simdLimit = bufferSize - (bufferSize % 16);
-    for (size_t i = 0; i < simdLimit; i += 16) {
-        __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&buffer[i]));
-        __m128i cmp = _mm_cmpeq_epi32(data, searchValue);
-        int mask = _mm_movemask_epi8(cmp);
-        if (mask != 0) {
-            return true;
-        }
-    }
-	
-    for (size_t i = simdLimit; i <= bufferSize - sizeof(int); i += sizeof(int)) {
-        int value;
-        memcpy(&value, &buffer[i], sizeof(int));
-        if (value == valueToFind)
-            return true;
-    }
-    
     return false;
 }
 
-bool ScanForFloatValueSIMD(const BYTE* buffer, size_t bufferSize, float valueToFind) {
-    if (bufferSize < 16) {
-        for (size_t i = 0; i <= bufferSize - sizeof(float); i += sizeof(float)) {
-            float value;
-            memcpy(&value, &buffer[i], sizeof(float));
-            if (!std::isnan(value) && !std::isinf(value) && 
-                std::abs(value - valueToFind) < 0.0001f)
-                return true;
+template<typename T>
+static size_t ScalarRun(const BYTE* buffer, size_t bufferSize, size_t start, size_t limit,
+                        const ScanValue& value, size_t stride, double epsilon, uint32_t* offsets) {
+    size_t count = 0;
+    for (size_t i = start; i < limit && i + sizeof(T) <= bufferSize; i += stride) {
+        if (ScalarMatchAs<T>(&buffer[i], value, epsilon)) {
+            offsets[count++] = (uint32_t)i;
         }
-        return false;
     }
-    
-    __m128 searchValue = _mm_set1_ps(valueToFind);
-    
-    size_t simdLimit = bufferSize - (bufferSize % 16);
-    for (size_t i = 0; i < simdLimit; i += 16) {
-        __m128 data = _mm_loadu_ps(reinterpret_cast<const float*>(&buffer[i]));
-        __m128 diff = _mm_sub_ps(data, searchValue);
-        __m128 absDiff = _mm_abs_ps(diff);
-        __m128 epsilon = _mm_set1_ps(0.0001f);
-        __m128 cmp = _mm_cmplt_ps(absDiff, epsilon);
-        
-        int mask = _mm_movemask_ps(cmp);
-        if (mask != 0) {
-            for (int j = 0; j < 4; j++) {
-                if (mask & (1 << j)) {
-                    float value;
-                    memcpy(&value, &buffer[i + j * sizeof(float)], sizeof(float));
-                    if (!std::isnan(value) && !std::isinf(value))
-                        return true;
+    return count;
+}
+
+template<typename T> static inline T RangeBound(const ScanValue& value) { return (T)value.i; }
+template<> inline float RangeBound<float>(const ScanValue& value) { return (float)value.f; }
+template<> inline double RangeBound<double>(const ScanValue& value) { return value.f; }
+
+template<typename T>
+static size_t ScalarRangeRun(const BYTE* buffer, size_t bufferSize, size_t start, size_t limit,
+                             const ScanRange& range, size_t stride, uint32_t* offsets) {
+    const T low = RangeBound<T>(range.low);
+    const T high = RangeBound<T>(range.high);
+    size_t count = 0;
+    for (size_t i = start; i < limit && i + sizeof(T) <= bufferSize; i += stride) {
+        T v;
+        memcpy(&v, &buffer[i], sizeof(v));
+        if (v >= low && v <= high) {
+            offsets[count++] = (uint32_t)i;
+        }
+    }
+    return count;
+}
+
+static size_t FindRangeOffsetsScalar(const BYTE* buffer, size_t bufferSize, size_t start, size_t limit,
+                                     const ScanRange& range, ValueType type, size_t stride, uint32_t* offsets) {
+    switch (type) {
+        case VALUE_TYPE_BYTE:
+            return ScalarRangeRun<uint8_t>(buffer, bufferSize, start, limit, range, stride, offsets);
+        case VALUE_TYPE_SHORT:
+            return ScalarRangeRun<int16_t>(buffer, bufferSize, start, limit, range, stride, offsets);
+        case VALUE_TYPE_UINT16:
+            return ScalarRangeRun<uint16_t>(buffer, bufferSize, start, limit, range, stride, offsets);
+        case VALUE_TYPE_UINT32:
+            return ScalarRangeRun<uint32_t>(buffer, bufferSize, start, limit, range, stride, offsets);
+        case VALUE_TYPE_INT64:
+            return ScalarRangeRun<int64_t>(buffer, bufferSize, start, limit, range, stride, offsets);
+        case VALUE_TYPE_UINT64:
+            return ScalarRangeRun<uint64_t>(buffer, bufferSize, start, limit, range, stride, offsets);
+        case VALUE_TYPE_FLOAT:
+            return ScalarRangeRun<float>(buffer, bufferSize, start, limit, range, stride, offsets);
+        case VALUE_TYPE_DOUBLE:
+            return ScalarRangeRun<double>(buffer, bufferSize, start, limit, range, stride, offsets);
+        default:
+            return ScalarRangeRun<int32_t>(buffer, bufferSize, start, limit, range, stride, offsets);
+    }
+}
+
+static size_t FindValueOffsetsScalar(const BYTE* buffer, size_t bufferSize, size_t start, size_t limit,
+                                     const ScanValue& value, ValueType type, size_t stride, double epsilon,
+                                     uint32_t* offsets) {
+    switch (type) {
+        case VALUE_TYPE_BYTE:
+            return ScalarRun<uint8_t>(buffer, bufferSize, start, limit, value, stride, epsilon, offsets);
+        case VALUE_TYPE_SHORT:
+        case VALUE_TYPE_UINT16:
+            return ScalarRun<uint16_t>(buffer, bufferSize, start, limit, value, stride, epsilon, offsets);
+        case VALUE_TYPE_INT64:
+        case VALUE_TYPE_UINT64:
+            return ScalarRun<uint64_t>(buffer, bufferSize, start, limit, value, stride, epsilon, offsets);
+        case VALUE_TYPE_FLOAT:
+            return ScalarRun<float>(buffer, bufferSize, start, limit, value, stride, epsilon, offsets);
+        case VALUE_TYPE_DOUBLE:
+            return ScalarRun<double>(buffer, bufferSize, start, limit, value, stride, epsilon, offsets);
+        case VALUE_TYPE_AUTO: {
+            size_t count = 0;
+            for (size_t i = start; i < limit && i + sizeof(int) <= bufferSize; i += stride) {
+                if (ScalarAutoMatch(&buffer[i], bufferSize - i, value, epsilon)) {
+                    offsets[count++] = (uint32_t)i;
                 }
             }
+            return count;
         }
+        default:
+            return ScalarRun<uint32_t>(buffer, bufferSize, start, limit, value, stride, epsilon, offsets);
     }
-    
-    for (size_t i = simdLimit; i <= bufferSize - sizeof(float); i += sizeof(float)) {
-        float value;
-        memcpy(&value, &buffer[i], sizeof(float));
-        if (!std::isnan(value) && !std::isinf(value) && 
-            std::abs(value - valueToFind) < 0.0001f)
-            return true;
-    }
-    
-    return false;
 }
 
-ValueType DetectValueType(const BYTE* buffer, size_t bufferSize, int valueToFind) {
-    if (bufferSize < 8) return VALUE_TYPE_INT;
-    if (valueToFind >= 0 && valueToFind <= 255) {
-        int countAsInt = 0;
-        int countAsByte = 0;
-        
-        for (size_t i = 0; i < std::min(bufferSize, size_t(1024)); i++) {
-            if (buffer[i] == (BYTE)valueToFind) {
-                countAsByte++;
+// SSE2 has no 64-bit compare: the high halves decide unless they are
+// equal, then the low halves decide as unsigned.
+KERNEL_SSE2 static inline __m128i Sse2CmpGt64(__m128i a, __m128i b) {
+    const __m128i lowSign = _mm_set_epi32(0, (int)0x80000000, 0, (int)0x80000000);
+    a = _mm_xor_si128(a, lowSign);
+    b = _mm_xor_si128(b, lowSign);
+    __m128i gt = _mm_cmpgt_epi32(a, b);
+    __m128i eq = _mm_cmpeq_epi32(a, b);
+    __m128i gtLow = _mm_shuffle_epi32(gt, _MM_SHUFFLE(2, 2, 0, 0));
+    __m128i gtHigh = _mm_shuffle_epi32(gt, _MM_SHUFFLE(3, 3, 1, 1));
+    __m128i eqHigh = _mm_shuffle_epi32(eq, _MM_SHUFFLE(3, 3, 1, 1));
+    return _mm_or_si128(gtHigh, _mm_and_si128(eqHigh, gtLow));
+}
+
+struct Sse2Kernel {
+    enum { WIDTH = 16 };
+    __m128i v8, v16, v32, v64;
+    __m128 vf, epsf, minf, absf;
+    __m128d vd, epsd, mind, absd;
+    __m128i lo8, hi8, bias8, lo16, hi16, bias16, lo32, hi32, bias32, lo64, hi64, bias64;
+    __m128 lof, hif;
+    __m128d lod, hid;
+
+    KERNEL_SSE2 void init(const ScanValue& value, double epsilon) {
+        v8 = _mm_set1_epi8((char)value.i);
+        v16 = _mm_set1_epi16((short)value.i);
+        v32 = _mm_set1_epi32((int)value.i);
+        v64 = _mm_set1_epi64x((long long)value.i);
+        vf = _mm_set1_ps((float)value.f);
+        epsf = _mm_set1_ps((float)epsilon);
+        minf = _mm_set1_ps(FLT_MIN);
+        absf = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        vd = _mm_set1_pd(value.f);
+        epsd = _mm_set1_pd(epsilon);
+        mind = _mm_set1_pd(DBL_MIN);
+        absd = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+    }
+
+    KERNEL_SSE2 void initRange(const ScanRange& range, bool flip) {
+        lo8 = _mm_set1_epi8((char)RangeKey(range.low.i, 8, flip));
+        hi8 = _mm_set1_epi8((char)RangeKey(range.high.i, 8, flip));
+        bias8 = _mm_set1_epi8((char)RangeKey(0, 8, flip));
+        lo16 = _mm_set1_epi16((short)RangeKey(range.low.i, 16, flip));
+        hi16 = _mm_set1_epi16((short)RangeKey(range.high.i, 16, flip));
+        bias16 = _mm_set1_epi16((short)RangeKey(0, 16, flip));
+        lo32 = _mm_set1_epi32((int)RangeKey(range.low.i, 32, flip));
+        hi32 = _mm_set1_epi32((int)RangeKey(range.high.i, 32, flip));
+        bias32 = _mm_set1_epi32((int)RangeKey(0, 32, flip));
+        lo64 = _mm_set1_epi64x((long long)RangeKey(range.low.i, 64, flip));
+        hi64 = _mm_set1_epi64x((long long)RangeKey(range.high.i, 64, flip));
+        bias64 = _mm_set1_epi64x((long long)RangeKey(0, 64, flip));
+        lof = _mm_set1_ps((float)range.low.f);
+        hif = _mm_set1_ps((float)range.high.f);
+        lod = _mm_set1_pd(range.low.f);
+        hid = _mm_set1_pd(range.high.f);
+    }
+
+    KERNEL_SSE2 uint64_t eq8(const BYTE* p) const {
+        __m128i d = _mm_loadu_si128((const __m128i*)p);
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(d, v8));
+    }
+
+    template<int PHASES>
+    KERNEL_SSE2 uint64_t eq16(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m128i d = _mm_loadu_si128((const __m128i*)(p + ph));
+            mask |= (uint64_t)((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(d, v16)) & 0x5555u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_SSE2 uint64_t eq32(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m128i d = _mm_loadu_si128((const __m128i*)(p + ph));
+            mask |= (uint64_t)((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi32(d, v32)) & 0x1111u) << ph;
+        }
+        return mask;
+    }
+
+    // SSE2 has no 64-bit compare: both 32-bit halves must match.
+    template<int PHASES>
+    KERNEL_SSE2 uint64_t eq64(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m128i c = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(p + ph)), v64);
+            c = _mm_and_si128(c, _mm_shuffle_epi32(c, _MM_SHUFFLE(2, 3, 0, 1)));
+            mask |= (uint64_t)((uint32_t)_mm_movemask_epi8(c) & 0x0101u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES, bool NORMAL_ONLY>
+    KERNEL_SSE2 uint64_t approxF32(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m128 d = _mm_loadu_ps((const float*)(p + ph));
+            __m128 hit = _mm_cmplt_ps(_mm_and_ps(_mm_sub_ps(d, vf), absf), epsf);
+            if (NORMAL_ONLY) {
+                hit = _mm_and_ps(hit, _mm_cmpge_ps(_mm_and_ps(d, absf), minf));
             }
-            if (i <= bufferSize - sizeof(int)) {
-                int value;
-                memcpy(&value, &buffer[i], sizeof(int));
-                if (value == valueToFind) {
-                    countAsInt++;
-                }
+            mask |= (uint64_t)((uint32_t)_mm_movemask_epi8(_mm_castps_si128(hit)) & 0x1111u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES, bool NORMAL_ONLY>
+    KERNEL_SSE2 uint64_t approxF64(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m128d d = _mm_loadu_pd((const double*)(p + ph));
+            __m128d hit = _mm_cmplt_pd(_mm_and_pd(_mm_sub_pd(d, vd), absd), epsd);
+            if (NORMAL_ONLY) {
+                hit = _mm_and_pd(hit, _mm_cmpge_pd(_mm_and_pd(d, absd), mind));
             }
+            mask |= (uint64_t)((uint32_t)_mm_movemask_epi8(_mm_castpd_si128(hit)) & 0x0101u) << ph;
         }
-        
-        if (countAsByte > countAsInt * 3) {
-            LOG_DEBUG("Auto-detected value %d as BYTE type (byte count: %d, int count: %d)", 
-                      valueToFind, countAsByte, countAsInt);
-            return VALUE_TYPE_BYTE;
-        }
-    }
-    
-    float floatValue = (float)valueToFind;
-    if (floatValue >= 0.1f && floatValue <= 10000.0f) {
-        int countAsInt = 0;
-        int countAsFloat = 0;
-        
-        for (size_t i = 0; i <= bufferSize - sizeof(float); i += sizeof(float)) {
-            float value;
-            memcpy(&value, &buffer[i], sizeof(float));
-            if (!std::isnan(value) && !std::isinf(value) && 
-                std::abs(value - floatValue) < 0.0001f) {
-                countAsFloat++;
+        return mask;
+    }
+
+    // Range lanes are those below neither bound nor above the other.
+    KERNEL_SSE2 uint64_t range8(const BYTE* p) const {
+        __m128i d = _mm_xor_si128(_mm_loadu_si128((const __m128i*)p), bias8);
+        __m128i out = _mm_or_si128(_mm_cmpgt_epi8(lo8, d), _mm_cmpgt_epi8(d, hi8));
+        return ~(uint32_t)_mm_movemask_epi8(out) & 0xFFFFu;
+    }
+
+    template<int PHASES>
+    KERNEL_SSE2 uint64_t range16(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m128i d = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + ph)), bias16);
+            __m128i out = _mm_or_si128(_mm_cmpgt_epi16(lo16, d), _mm_cmpgt_epi16(d, hi16));
+            mask |= (uint64_t)(~(uint32_t)_mm_movemask_epi8(out) & 0x5555u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_SSE2 uint64_t range32(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m128i d = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + ph)), bias32);
+            __m128i out = _mm_or_si128(_mm_cmpgt_epi32(lo32, d), _mm_cmpgt_epi32(d, hi32));
+            mask |= (uint64_t)(~(uint32_t)_mm_movemask_epi8(out) & 0x1111u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_SSE2 uint64_t range64(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m128i d = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(p + ph)), bias64);
+            __m128i out = _mm_or_si128(Sse2CmpGt64(lo64, d), Sse2CmpGt64(d, hi64));
+            mask |= (uint64_t)(~(uint32_t)_mm_movemask_epi8(out) & 0x0101u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_SSE2 uint64_t rangeF32(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m128 d = _mm_loadu_ps((const float*)(p + ph));
+            __m128 hit = _mm_and_ps(_mm_cmpge_ps(d, lof), _mm_cmple_ps(d, hif));
+            mask |= (uint64_t)((uint32_t)_mm_movemask_epi8(_mm_castps_si128(hit)) & 0x1111u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_SSE2 uint64_t rangeF64(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m128d d = _mm_loadu_pd((const double*)(p + ph));
+            __m128d hit = _mm_and_pd(_mm_cmpge_pd(d, lod), _mm_cmple_pd(d, hid));
+            mask |= (uint64_t)((uint32_t)_mm_movemask_epi8(_mm_castpd_si128(hit)) & 0x0101u) << ph;
+        }
+        return mask;
+    }
+};
+
+struct Avx2Kernel {
+    enum { WIDTH = 32 };
+    __m256i v8, v16, v32, v64;
+    __m256 vf, epsf, minf, absf;
+    __m256d vd, epsd, mind, absd;
+    __m256i lo8, hi8, bias8, lo16, hi16, bias16, lo32, hi32, bias32, lo64, hi64, bias64;
+    __m256 lof, hif;
+    __m256d lod, hid;
+
+    KERNEL_AVX2 void init(const ScanValue& value, double epsilon) {
+        v8 = _mm256_set1_epi8((char)value.i);
+        v16 = _mm256_set1_epi16((short)value.i);
+        v32 = _mm256_set1_epi32((int)value.i);
+        v64 = _mm256_set1_epi64x((long long)value.i);
+        vf = _mm256_set1_ps((float)value.f);
+        epsf = _mm256_set1_ps((float)epsilon);
+        minf = _mm256_set1_ps(FLT_MIN);
+        absf = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+        vd = _mm256_set1_pd(value.f);
+        epsd = _mm256_set1_pd(epsilon);
+        mind = _mm256_set1_pd(DBL_MIN);
+        absd = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+    }
+
+    KERNEL_AVX2 void initRange(const ScanRange& range, bool flip) {
+        lo8 = _mm256_set1_epi8((char)RangeKey(range.low.i, 8, flip));
+        hi8 = _mm256_set1_epi8((char)RangeKey(range.high.i, 8, flip));
+        bias8 = _mm256_set1_epi8((char)RangeKey(0, 8, flip));
+        lo16 = _mm256_set1_epi16((short)RangeKey(range.low.i, 16, flip));
+        hi16 = _mm256_set1_epi16((short)RangeKey(range.high.i, 16, flip));
+        bias16 = _mm256_set1_epi16((short)RangeKey(0, 16, flip));
+        lo32 = _mm256_set1_epi32((int)RangeKey(range.low.i, 32, flip));
+        hi32 = _mm256_set1_epi32((int)RangeKey(range.high.i, 32, flip));
+        bias32 = _mm256_set1_epi32((int)RangeKey(0, 32, flip));
+        lo64 = _mm256_set1_epi64x((long long)RangeKey(range.low.i, 64, flip));
+        hi64 = _mm256_set1_epi64x((long long)RangeKey(range.high.i, 64, flip));
+        bias64 = _mm256_set1_epi64x((long long)RangeKey(0, 64, flip));
+        lof = _mm256_set1_ps((float)range.low.f);
+        hif = _mm256_set1_ps((float)range.high.f);
+        lod = _mm256_set1_pd(range.low.f);
+        hid = _mm256_set1_pd(range.high.f);
+    }
+
+    KERNEL_AVX2 uint64_t eq8(const BYTE* p) const {
+        __m256i d = _mm256_loadu_si256((const __m256i*)p);
+        return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(d, v8));
+    }
+
+    template<int PHASES>
+    KERNEL_AVX2 uint64_t eq16(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(p + ph));
+            mask |= (uint64_t)((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi16(d, v16)) & 0x55555555u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_AVX2 uint64_t eq32(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(p + ph));
+            mask |= (uint64_t)((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi32(d, v32)) & 0x11111111u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_AVX2 uint64_t eq64(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(p + ph));
+            mask |= (uint64_t)((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi64(d, v64)) & 0x01010101u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES, bool NORMAL_ONLY>
+    KERNEL_AVX2 uint64_t approxF32(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m256 d = _mm256_loadu_ps((const float*)(p + ph));
+            __m256 hit = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(d, vf), absf), epsf, _CMP_LT_OQ);
+            if (NORMAL_ONLY) {
+                hit = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_and_ps(d, absf), minf, _CMP_GE_OQ));
             }
-            
-            int intValue;
-            memcpy(&intValue, &buffer[i], sizeof(int));
-            if (intValue == valueToFind) {
-                countAsInt++;
+            mask |= (uint64_t)((uint32_t)_mm256_movemask_epi8(_mm256_castps_si256(hit)) & 0x11111111u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES, bool NORMAL_ONLY>
+    KERNEL_AVX2 uint64_t approxF64(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m256d d = _mm256_loadu_pd((const double*)(p + ph));
+            __m256d hit = _mm256_cmp_pd(_mm256_and_pd(_mm256_sub_pd(d, vd), absd), epsd, _CMP_LT_OQ);
+            if (NORMAL_ONLY) {
+                hit = _mm256_and_pd(hit, _mm256_cmp_pd(_mm256_and_pd(d, absd), mind, _CMP_GE_OQ));
             }
+            mask |= (uint64_t)((uint32_t)_mm256_movemask_epi8(_mm256_castpd_si256(hit)) & 0x01010101u) << ph;
         }
-        
-        if (countAsFloat > countAsInt) {
-            LOG_DEBUG("Auto-detected value %d as FLOAT type (float count: %d, int count: %d)", 
-                      valueToFind, countAsFloat, countAsInt);
-            return VALUE_TYPE_FLOAT;
-        }
-    }
-    
-    return VALUE_TYPE_INT;
-}
-
-bool SmartScan(const BYTE* buffer, size_t bufferSize, int valueToFind, 
-               ValueType type, const Settings* settings, DWORD* outAddress) {
-    ValueType effectiveType = type;
-    if (type == VALUE_TYPE_AUTO) {
-        effectiveType = DetectValueType(buffer, bufferSize, valueToFind);
-    }
-    
-    bool found = false;
-    size_t foundOffset = 0;
-    
-    if (settings->useVectorizedOperations) {
-        switch (effectiveType) {
-            case VALUE_TYPE_INT:
-                found = ScanForIntValueSIMD(buffer, bufferSize, valueToFind);
-                break;
-            case VALUE_TYPE_FLOAT:
-                found = ScanForFloatValueSIMD(buffer, bufferSize, (float)valueToFind);
-                break;
-            default:
-                for (size_t i = 0; i <= bufferSize - sizeof(int); i++) {
-                    int value;
-                    memcpy(&value, &buffer[i], sizeof(value));
-                    if (value == valueToFind) {
-                        found = true;
-                        foundOffset = i;
-                        break;
-                    }
-                }
-                break;
+        return mask;
+    }
+
+    KERNEL_AVX2 uint64_t range8(const BYTE* p) const {
+        __m256i d = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)p), bias8);
+        __m256i out = _mm256_or_si256(_mm256_cmpgt_epi8(lo8, d), _mm256_cmpgt_epi8(d, hi8));
+        return ~(uint32_t)_mm256_movemask_epi8(out);
+    }
+
+    template<int PHASES>
+    KERNEL_AVX2 uint64_t range16(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m256i d = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + ph)), bias16);
+            __m256i out = _mm256_or_si256(_mm256_cmpgt_epi16(lo16, d), _mm256_cmpgt_epi16(d, hi16));
+            mask |= (uint64_t)(~(uint32_t)_mm256_movemask_epi8(out) & 0x55555555u) << ph;
         }
-    } else {
-        int typeSize = 4;
-        switch (effectiveType) {
-            case VALUE_TYPE_BYTE: typeSize = 1; break;
-            case VALUE_TYPE_SHORT: typeSize = 2; break;
-            case VALUE_TYPE_INT: 
-            case VALUE_TYPE_FLOAT: typeSize = 4; break;
-            case VALUE_TYPE_DOUBLE: typeSize = 8; break;
-            default: typeSize = 4; break;
-        }
-        
-        for (size_t i = 0; i <= bufferSize - typeSize; i++) {
-            bool matches = false;
-            
-            switch (effectiveType) {
-                case VALUE_TYPE_INT: {
-                    int value;
-                    memcpy(&value, &buffer[i], sizeof(value));
-                    matches = (value == valueToFind);
-                    break;
-                }
-                case VALUE_TYPE_FLOAT: {
-                    float value;
-                    memcpy(&value, &buffer[i], sizeof(value));
-                    matches = (!std::isnan(value) && !std::isinf(value) && 
-                               std::abs(value - (float)valueToFind) < 0.0001f);
-                    break;
-                }
-                case VALUE_TYPE_SHORT: {
-                    short value;
-                    memcpy(&value, &buffer[i], sizeof(value));
-                    matches = (value == (short)valueToFind);
-                    break;
-                }
-                case VALUE_TYPE_BYTE: {
-                    BYTE value = buffer[i];
-                    matches = (value == (BYTE)valueToFind);
-                    break;
-                }
-                default:
-                    break;
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_AVX2 uint64_t range32(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m256i d = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + ph)), bias32);
+            __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(lo32, d), _mm256_cmpgt_epi32(d, hi32));
+            mask |= (uint64_t)(~(uint32_t)_mm256_movemask_epi8(out) & 0x11111111u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_AVX2 uint64_t range64(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m256i d = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + ph)), bias64);
+            __m256i out = _mm256_or_si256(_mm256_cmpgt_epi64(lo64, d), _mm256_cmpgt_epi64(d, hi64));
+            mask |= (uint64_t)(~(uint32_t)_mm256_movemask_epi8(out) & 0x01010101u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_AVX2 uint64_t rangeF32(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m256 d = _mm256_loadu_ps((const float*)(p + ph));
+            __m256 hit = _mm256_and_ps(_mm256_cmp_ps(d, lof, _CMP_GE_OQ), _mm256_cmp_ps(d, hif, _CMP_LE_OQ));
+            mask |= (uint64_t)((uint32_t)_mm256_movemask_epi8(_mm256_castps_si256(hit)) & 0x11111111u) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_AVX2 uint64_t rangeF64(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m256d d = _mm256_loadu_pd((const double*)(p + ph));
+            __m256d hit = _mm256_and_pd(_mm256_cmp_pd(d, lod, _CMP_GE_OQ), _mm256_cmp_pd(d, hid, _CMP_LE_OQ));
+            mask |= (uint64_t)((uint32_t)_mm256_movemask_epi8(_mm256_castpd_si256(hit)) & 0x01010101u) << ph;
+        }
+        return mask;
+    }
+};
+
+struct Avx512Kernel {
+    enum { WIDTH = 64 };
+    __m512i v8, v16, v32, v64, absf, absd;
+    __m512 vf, epsf, minf;
+    __m512d vd, epsd, mind;
+    __m512i lo8, hi8, bias8, lo16, hi16, bias16, lo32, hi32, bias32, lo64, hi64, bias64;
+    __m512 lof, hif;
+    __m512d lod, hid;
+
+    KERNEL_AVX512 void init(const ScanValue& value, double epsilon) {
+        v8 = _mm512_set1_epi8((char)value.i);
+        v16 = _mm512_set1_epi16((short)value.i);
+        v32 = _mm512_set1_epi32((int)value.i);
+        v64 = _mm512_set1_epi64((long long)value.i);
+        vf = _mm512_set1_ps((float)value.f);
+        epsf = _mm512_set1_ps((float)epsilon);
+        minf = _mm512_set1_ps(FLT_MIN);
+        absf = _mm512_set1_epi32(0x7FFFFFFF);
+        vd = _mm512_set1_pd(value.f);
+        epsd = _mm512_set1_pd(epsilon);
+        mind = _mm512_set1_pd(DBL_MIN);
+        absd = _mm512_set1_epi64(0x7FFFFFFFFFFFFFFFLL);
+    }
+
+    KERNEL_AVX512 void initRange(const ScanRange& range, bool flip) {
+        lo8 = _mm512_set1_epi8((char)RangeKey(range.low.i, 8, flip));
+        hi8 = _mm512_set1_epi8((char)RangeKey(range.high.i, 8, flip));
+        bias8 = _mm512_set1_epi8((char)RangeKey(0, 8, flip));
+        lo16 = _mm512_set1_epi16((short)RangeKey(range.low.i, 16, flip));
+        hi16 = _mm512_set1_epi16((short)RangeKey(range.high.i, 16, flip));
+        bias16 = _mm512_set1_epi16((short)RangeKey(0, 16, flip));
+        lo32 = _mm512_set1_epi32((int)RangeKey(range.low.i, 32, flip));
+        hi32 = _mm512_set1_epi32((int)RangeKey(range.high.i, 32, flip));
+        bias32 = _mm512_set1_epi32((int)RangeKey(0, 32, flip));
+        lo64 = _mm512_set1_epi64((long long)RangeKey(range.low.i, 64, flip));
+        hi64 = _mm512_set1_epi64((long long)RangeKey(range.high.i, 64, flip));
+        bias64 = _mm512_set1_epi64((long long)RangeKey(0, 64, flip));
+        lof = _mm512_set1_ps((float)range.low.f);
+        hif = _mm512_set1_ps((float)range.high.f);
+        lod = _mm512_set1_pd(range.low.f);
+        hid = _mm512_set1_pd(range.high.f);
+    }
+
+    // Lane compares produce one bit per lane; pdep spreads them to the
+    // first byte position of each lane.
+    KERNEL_AVX512 uint64_t eq8(const BYTE* p) const {
+        return _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void*)p), v8);
+    }
+
+    template<int PHASES>
+    KERNEL_AVX512 uint64_t eq16(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __mmask32 k = _mm512_cmpeq_epi16_mask(_mm512_loadu_si512((const void*)(p + ph)), v16);
+            mask |= _pdep_u64(k, 0x5555555555555555ULL) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_AVX512 uint64_t eq32(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __mmask16 k = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512((const void*)(p + ph)), v32);
+            mask |= _pdep_u64(k, 0x1111111111111111ULL) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_AVX512 uint64_t eq64(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __mmask8 k = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512((const void*)(p + ph)), v64);
+            mask |= _pdep_u64(k, 0x0101010101010101ULL) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES, bool NORMAL_ONLY>
+    KERNEL_AVX512 uint64_t approxF32(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m512 d = _mm512_loadu_ps((const void*)(p + ph));
+            __m512 diff = _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(_mm512_sub_ps(d, vf)), absf));
+            __mmask16 k = _mm512_cmp_ps_mask(diff, epsf, _CMP_LT_OQ);
+            if (NORMAL_ONLY) {
+                __m512 magnitude = _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(d), absf));
+                k = _mm512_mask_cmp_ps_mask(k, magnitude, minf, _CMP_GE_OQ);
             }
-            
-            if (matches) {
-                found = true;
-                foundOffset = i;
-                break;
+            mask |= _pdep_u64(k, 0x1111111111111111ULL) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES, bool NORMAL_ONLY>
+    KERNEL_AVX512 uint64_t approxF64(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m512d d = _mm512_loadu_pd((const void*)(p + ph));
+            __m512d diff = _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(_mm512_sub_pd(d, vd)), absd));
+            __mmask8 k = _mm512_cmp_pd_mask(diff, epsd, _CMP_LT_OQ);
+            if (NORMAL_ONLY) {
+                __m512d magnitude = _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(d), absd));
+                k = _mm512_mask_cmp_pd_mask(k, magnitude, mind, _CMP_GE_OQ);
             }
+            mask |= _pdep_u64(k, 0x0101010101010101ULL) << ph;
+        }
+        return mask;
+    }
+
+    KERNEL_AVX512 uint64_t range8(const BYTE* p) const {
+        __m512i d = _mm512_xor_si512(_mm512_loadu_si512((const void*)p), bias8);
+        return _mm512_mask_cmple_epi8_mask(_mm512_cmpge_epi8_mask(d, lo8), d, hi8);
+    }
+
+    template<int PHASES>
+    KERNEL_AVX512 uint64_t range16(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m512i d = _mm512_xor_si512(_mm512_loadu_si512((const void*)(p + ph)), bias16);
+            __mmask32 k = _mm512_mask_cmple_epi16_mask(_mm512_cmpge_epi16_mask(d, lo16), d, hi16);
+            mask |= _pdep_u64(k, 0x5555555555555555ULL) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_AVX512 uint64_t range32(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m512i d = _mm512_xor_si512(_mm512_loadu_si512((const void*)(p + ph)), bias32);
+            __mmask16 k = _mm512_mask_cmple_epi32_mask(_mm512_cmpge_epi32_mask(d, lo32), d, hi32);
+            mask |= _pdep_u64(k, 0x1111111111111111ULL) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_AVX512 uint64_t range64(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m512i d = _mm512_xor_si512(_mm512_loadu_si512((const void*)(p + ph)), bias64);
+            __mmask8 k = _mm512_mask_cmple_epi64_mask(_mm512_cmpge_epi64_mask(d, lo64), d, hi64);
+            mask |= _pdep_u64(k, 0x0101010101010101ULL) << ph;
+        }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_AVX512 uint64_t rangeF32(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m512 d = _mm512_loadu_ps((const void*)(p + ph));
+            __mmask16 k = _mm512_mask_cmp_ps_mask(_mm512_cmp_ps_mask(d, lof, _CMP_GE_OQ), d, hif, _CMP_LE_OQ);
+            mask |= _pdep_u64(k, 0x1111111111111111ULL) << ph;
         }
+        return mask;
+    }
+
+    template<int PHASES>
+    KERNEL_AVX512 uint64_t rangeF64(const BYTE* p) const {
+        uint64_t mask = 0;
+        for (int ph = 0; ph < PHASES; ph++) {
+            __m512d d = _mm512_loadu_pd((const void*)(p + ph));
+            __mmask8 k = _mm512_mask_cmp_pd_mask(_mm512_cmp_pd_mask(d, lod, _CMP_GE_OQ), d, hid, _CMP_LE_OQ);
+            mask |= _pdep_u64(k, 0x0101010101010101ULL) << ph;
+        }
+        return mask;
+    }
+};
+
+template<typename K, int PRED, int PHASES>
+static KERNEL_INLINE uint64_t KernelBlockMask(const K& k, const BYTE* p) {
+    switch (PRED) {
+        case PRED_EQ8: return k.eq8(p);
+        case PRED_EQ16: return k.template eq16<PHASES>(p);
+        case PRED_EQ32: return k.template eq32<PHASES>(p);
+        case PRED_EQ64: return k.template eq64<PHASES>(p);
+        case PRED_APPROX_F32: return k.template approxF32<PHASES, false>(p);
+        case PRED_APPROX_F64: return k.template approxF64<PHASES, false>(p);
+        case PRED_AUTO:
+            return k.template eq32<4>(p) | k.template eq16<2>(p) | k.eq8(p) |
+                   k.template approxF32<4, true>(p) | k.template approxF64<8, true>(p);
+        case PRED_AUTO_REAL:
+            return k.template approxF32<4, true>(p) | k.template approxF64<8, true>(p);
+        case PRED_RANGE8: return k.range8(p);
+        case PRED_RANGE16: return k.template range16<PHASES>(p);
+        case PRED_RANGE32: return k.template range32<PHASES>(p);
+        case PRED_RANGE64: return k.template range64<PHASES>(p);
+        case PRED_RANGE_F32: return k.template rangeF32<PHASES>(p);
+        case PRED_RANGE_F64: return k.template rangeF64<PHASES>(p);
+    }
+    return 0;
+}
+
+// Runs whole blocks while both the block and its widest phase read stay
+// inside the buffer; the caller finishes the tail with the scalar kernel.
+template<typename K, int PRED, int PHASES, int READ_EXTRA>
+static KERNEL_INLINE size_t KernelRunBlocks(const K& k, const BYTE* buffer, size_t bufferSize,
+                                            size_t limit, uint32_t* offsets, size_t* blockEnd) {
+    size_t count = 0;
+    size_t base = 0;
+    for (; base + K::WIDTH <= limit && base + K::WIDTH + READ_EXTRA <= bufferSize; base += K::WIDTH) {
+        uint64_t mask = KernelBlockMask<K, PRED, PHASES>(k, buffer + base);
+        while (mask) {
+            offsets[count++] = (uint32_t)(base + __builtin_ctzll(mask));
+            mask &= mask - 1;
+        }
+    }
+    *blockEnd = base;
+    return count;
+}
+
+template<typename K>
+static KERNEL_INLINE size_t KernelFindOffsets(const K& k, const BYTE* buffer, size_t bufferSize, size_t limit,
+                                              const ScanValue& value, ValueType type, bool unaligned,
+                                              double epsilon, uint32_t* offsets) {
+    size_t blockEnd = 0;
+    size_t count = 0;
+    switch (type) {
+        case VALUE_TYPE_BYTE:
+            count = KernelRunBlocks<K, PRED_EQ8, 1, 0>(k, buffer, bufferSize, limit, offsets, &blockEnd);
+            break;
+        case VALUE_TYPE_SHORT:
+        case VALUE_TYPE_UINT16:
+            count = unaligned
+                ? KernelRunBlocks<K, PRED_EQ16, 2, 1>(k, buffer, bufferSize, limit, offsets, &blockEnd)
+                : KernelRunBlocks<K, PRED_EQ16, 1, 0>(k, buffer, bufferSize, limit, offsets, &blockEnd);
+            break;
+        case VALUE_TYPE_INT:
+        case VALUE_TYPE_UINT32:
+            count = unaligned
+                ? KernelRunBlocks<K, PRED_EQ32, 4, 3>(k, buffer, bufferSize, limit, offsets, &blockEnd)
+                : KernelRunBlocks<K, PRED_EQ32, 1, 0>(k, buffer, bufferSize, limit, offsets, &blockEnd);
+            break;
+        case VALUE_TYPE_INT64:
+        case VALUE_TYPE_UINT64:
+            count = unaligned
+                ? KernelRunBlocks<K, PRED_EQ64, 8, 7>(k, buffer, bufferSize, limit, offsets, &blockEnd)
+                : KernelRunBlocks<K, PRED_EQ64, 1, 0>(k, buffer, bufferSize, limit, offsets, &blockEnd);
+            break;
+        case VALUE_TYPE_FLOAT:
+            count = unaligned
+                ? KernelRunBlocks<K, PRED_APPROX_F32, 4, 3>(k, buffer, bufferSize, limit, offsets, &blockEnd)
+                : KernelRunBlocks<K, PRED_APPROX_F32, 1, 0>(k, buffer, bufferSize, limit, offsets, &blockEnd);
+            break;
+        case VALUE_TYPE_DOUBLE:
+            count = unaligned
+                ? KernelRunBlocks<K, PRED_APPROX_F64, 8, 7>(k, buffer, bufferSize, limit, offsets, &blockEnd)
+                : KernelRunBlocks<K, PRED_APPROX_F64, 1, 0>(k, buffer, bufferSize, limit, offsets, &blockEnd);
+            break;
+        case VALUE_TYPE_AUTO:
+            count = HasFraction(value)
+                ? KernelRunBlocks<K, PRED_AUTO_REAL, 8, 7>(k, buffer, bufferSize, limit, offsets, &blockEnd)
+                : KernelRunBlocks<K, PRED_AUTO, 8, 7>(k, buffer, bufferSize, limit, offsets, &blockEnd);
+            break;
     }
-    
-    if (found && outAddress) {
-        *outAddress = (DWORD)foundOffset;
+
+    size_t stride = unaligned ? 1 : KernelTypeSize(type);
+    return count + FindValueOffsetsScalar(buffer, bufferSize, blockEnd, limit, value, type,
+                                          stride, epsilon, offsets + count);
+}
+
+template<typename K>
+static KERNEL_INLINE size_t KernelFindRangeOffsets(const K& k, const BYTE* buffer, size_t bufferSize, size_t limit,
+                                                   const ScanRange& range, ValueType type, bool unaligned,
+                                                   uint32_t* offsets) {
+    size_t blockEnd = 0;
+    size_t count = 0;
+    switch (type) {
+        case VALUE_TYPE_BYTE:
+            count = KernelRunBlocks<K, PRED_RANGE8, 1, 0>(k, buffer, bufferSize, limit, offsets, &blockEnd);
+            break;
+        case VALUE_TYPE_SHORT:
+        case VALUE_TYPE_UINT16:
+            count = unaligned
+                ? KernelRunBlocks<K, PRED_RANGE16, 2, 1>(k, buffer, bufferSize, limit, offsets, &blockEnd)
+                : KernelRunBlocks<K, PRED_RANGE16, 1, 0>(k, buffer, bufferSize, limit, offsets, &blockEnd);
+            break;
+        case VALUE_TYPE_INT64:
+        case VALUE_TYPE_UINT64:
+            count = unaligned
+                ? KernelRunBlocks<K, PRED_RANGE64, 8, 7>(k, buffer, bufferSize, limit, offsets, &blockEnd)
+                : KernelRunBlocks<K, PRED_RANGE64, 1, 0>(k, buffer, bufferSize, limit, offsets, &blockEnd);
+            break;
+        case VALUE_TYPE_FLOAT:
+            count = unaligned
+                ? KernelRunBlocks<K, PRED_RANGE_F32, 4, 3>(k, buffer, bufferSize, limit, offsets, &blockEnd)
+                : KernelRunBlocks<K, PRED_RANGE_F32, 1, 0>(k, buffer, bufferSize, limit, offsets, &blockEnd);
+            break;
+        case VALUE_TYPE_DOUBLE:
+            count = unaligned
+                ? KernelRunBlocks<K, PRED_RANGE_F64, 8, 7>(k, buffer, bufferSize, limit, offsets, &blockEnd)
+                : KernelRunBlocks<K, PRED_RANGE_F64, 1, 0>(k, buffer, bufferSize, limit, offsets, &blockEnd);
+            break;
+        default:
+            count = unaligned
+                ? KernelRunBlocks<K, PRED_RANGE32, 4, 3>(k, buffer, bufferSize, limit, offsets, &blockEnd)
+                : KernelRunBlocks<K, PRED_RANGE32, 1, 0>(k, buffer, bufferSize, limit, offsets, &blockEnd);
+            break;
     }
-    
-    return found;
+
+    size_t stride = unaligned ? 1 : KernelTypeSize(type);
+    return count + FindRangeOffsetsScalar(buffer, bufferSize, blockEnd, limit, range, type, stride, offsets + count);
+}
+
+KERNEL_SSE2 static size_t FindValueOffsetsSse2(const BYTE* buffer, size_t bufferSize, size_t limit,
+                                               const ScanValue& value, ValueType type, bool unaligned,
+                                               double epsilon, uint32_t* offsets) {
+    Sse2Kernel k;
+    k.init(value, epsilon);
+    return KernelFindOffsets(k, buffer, bufferSize, limit, value, type, unaligned, epsilon, offsets);
+}
+
+KERNEL_AVX2 static size_t FindValueOffsetsAvx2(const BYTE* buffer, size_t bufferSize, size_t limit,
+                                               const ScanValue& value, ValueType type, bool unaligned,
+                                               double epsilon, uint32_t* offsets) {
+    Avx2Kernel k;
+    k.init(value, epsilon);
+    return KernelFindOffsets(k, buffer, bufferSize, limit, value, type, unaligned, epsilon, offsets);
+}
+
+KERNEL_AVX512 static size_t FindValueOffsetsAvx512(const BYTE* buffer, size_t bufferSize, size_t limit,
+                                                   const ScanValue& value, ValueType type, bool unaligned,
+                                                   double epsilon, uint32_t* offsets) {
+    Avx512Kernel k;
+    k.init(value, epsilon);
+    return KernelFindOffsets(k, buffer, bufferSize, limit, value, type, unaligned, epsilon, offsets);
+}
+
+KERNEL_SSE2 static size_t FindRangeOffsetsSse2(const BYTE* buffer, size_t bufferSize, size_t limit,
+                                               const ScanRange& range, ValueType type, bool unaligned,
+                                               uint32_t* offsets) {
+    Sse2Kernel k;
+    k.initRange(range, IsUnsignedType(type));
+    return KernelFindRangeOffsets(k, buffer, bufferSize, limit, range, type, unaligned, offsets);
+}
+
+KERNEL_AVX2 static size_t FindRangeOffsetsAvx2(const BYTE* buffer, size_t bufferSize, size_t limit,
+                                               const ScanRange& range, ValueType type, bool unaligned,
+                                               uint32_t* offsets) {
+    Avx2Kernel k;
+    k.initRange(range, IsUnsignedType(type));
+    return KernelFindRangeOffsets(k, buffer, bufferSize, limit, range, type, unaligned, offsets);
+}
+
+KERNEL_AVX512 static size_t FindRangeOffsetsAvx512(const BYTE* buffer, size_t bufferSize, size_t limit,
+                                                   const ScanRange& range, ValueType type, bool unaligned,
+                                                   uint32_t* offsets) {
+    Avx512Kernel k;
+    k.initRange(range, IsUnsignedType(type));
+    return KernelFindRangeOffsets(k, buffer, bufferSize, limit, range, type, unaligned, offsets);
+}
+
+static uint64_t ReadXcr0() {
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+}
+
+static ScanKernelLevel DetectScanKernelLevel() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return SCAN_KERNEL_SCALAR;
+    }
+
+    ScanKernelLevel level = (edx & bit_SSE2) ? SCAN_KERNEL_SSE2 : SCAN_KERNEL_SCALAR;
+
+    // AVX state must be enabled by the OS (XCR0 XMM|YMM), not just the CPU.
+    if (!(ecx & bit_OSXSAVE)) {
+        return level;
+    }
+    uint64_t xcr0 = ReadXcr0();
+    if ((xcr0 & 0x6) != 0x6 || !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return level;
+    }
+
+    if (ebx & bit_AVX2) {
+        level = SCAN_KERNEL_AVX2;
+    }
+    // AVX-512 additionally needs the opmask and ZMM state (XCR0 bits 5-7).
+    if ((xcr0 & 0xE6) == 0xE6 && (ebx & bit_AVX512F) && (ebx & bit_AVX512BW) && (ebx & bit_BMI2)) {
+        level = SCAN_KERNEL_AVX512;
+    }
+    return level;
+}
+
+ScanKernelLevel GetScanKernelLevel() {
+    static const ScanKernelLevel level = DetectScanKernelLevel();
+    return level;
+}
+
+const char* GetScanKernelName(ScanKernelLevel level) {
+    switch (level) {
+        case SCAN_KERNEL_SSE2: return "SSE2";
+        case SCAN_KERNEL_AVX2: return "AVX2";
+        case SCAN_KERNEL_AVX512: return "AVX-512";
+        default: return "Scalar";
+    }
+}
+
+size_t FindValueOffsets(const BYTE* buffer, size_t bufferSize, size_t limit, const ScanValue& value,
+                        ValueType type, size_t stride, double epsilon, uint32_t* offsets,
+                        ScanKernelLevel level) {
+    if (limit > bufferSize) {
+        limit = bufferSize;
+    }
+    bool unaligned = (stride == 1) || type == VALUE_TYPE_AUTO;
+    if (unaligned) {
+        stride = 1;
+    } else {
+        stride = KernelTypeSize(type);
+    }
+
+    switch (level) {
+        case SCAN_KERNEL_AVX512:
+            return FindValueOffsetsAvx512(buffer, bufferSize, limit, value, type, unaligned, epsilon, offsets);
+        case SCAN_KERNEL_AVX2:
+            return FindValueOffsetsAvx2(buffer, bufferSize, limit, value, type, unaligned, epsilon, offsets);
+        case SCAN_KERNEL_SSE2:
+            return FindValueOffsetsSse2(buffer, bufferSize, limit, value, type, unaligned, epsilon, offsets);
+        default:
+            return FindValueOffsetsScalar(buffer, bufferSize, 0, limit, value, type, stride, epsilon, offsets);
+    }
+}
+
+bool MatchesValue(const BYTE* p, size_t available, const ScanValue& value, ValueType type, double epsilon) {
+    if (available < KernelTypeSize(type)) {
+        return false;
+    }
+    switch (type) {
+        case VALUE_TYPE_BYTE: return ScalarMatchAs<uint8_t>(p, value, epsilon);
+        case VALUE_TYPE_SHORT:
+        case VALUE_TYPE_UINT16: return ScalarMatchAs<uint16_t>(p, value, epsilon);
+        case VALUE_TYPE_INT64:
+        case VALUE_TYPE_UINT64: return ScalarMatchAs<uint64_t>(p, value, epsilon);
+        case VALUE_TYPE_FLOAT: return ScalarMatchAs<float>(p, value, epsilon);
+        case VALUE_TYPE_DOUBLE: return ScalarMatchAs<double>(p, value, epsilon);
+        case VALUE_TYPE_AUTO: return ScalarAutoMatch(p, available, value, epsilon);
+        default: return ScalarMatchAs<uint32_t>(p, value, epsilon);
+    }
+}
+
+size_t FindRangeOffsets(const BYTE* buffer, size_t bufferSize, size_t limit, const ScanRange& range,
+                        ValueType type, size_t stride, uint32_t* offsets, ScanKernelLevel level) {
+    if (limit > bufferSize) {
+        limit = bufferSize;
+    }
+    bool unaligned = (stride == 1) || type == VALUE_TYPE_AUTO;
+    stride = unaligned ? 1 : KernelTypeSize(type);
+
+    switch (level) {
+        case SCAN_KERNEL_AVX512:
+            return FindRangeOffsetsAvx512(buffer, bufferSize, limit, range, type, unaligned, offsets);
+        case SCAN_KERNEL_AVX2:
+            return FindRangeOffsetsAvx2(buffer, bufferSize, limit, range, type, unaligned, offsets);
+        case SCAN_KERNEL_SSE2:
+            return FindRangeOffsetsSse2(buffer, bufferSize, limit, range, type, unaligned, offsets);
+        default:
+            return FindRangeOffsetsScalar(buffer, bufferSize, 0, limit, range, type, stride, offsets);
+    }
+}
+
+bool MatchesRange(const BYTE* p, size_t available, const ScanRange& range, ValueType type) {
+    uint32_t offset;
+    return FindRangeOffsetsScalar(p, available, 0, 1, range, type, 1, &offset) == 1;
 }
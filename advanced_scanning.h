@@ -1,6 +1,8 @@
 #pragma once
 
-#include <windows.h>
+#include "platform.h"
+#include <immintrin.h>
+#include <stdint.h>
 #include "settings.h"
 
 typedef enum {
@@ -8,20 +10,63 @@ typedef enum {
     VALUE_TYPE_FLOAT, // 4 bytes
     VALUE_TYPE_DOUBLE, // 8 bytes
     VALUE_TYPE_SHORT, // 2 bytes
-    VALUE_TYPE_BYTE, // 1 byte
-    VALUE_TYPE_AUTO // Auto-detect
+    VALUE_TYPE_BYTE, // 1 byte, unsigned
+    VALUE_TYPE_AUTO, // Auto-detect
+    VALUE_TYPE_INT64, // 8 bytes
+    VALUE_TYPE_UINT16, // 2 bytes, unsigned
+    VALUE_TYPE_UINT32, // 4 bytes, unsigned
+    VALUE_TYPE_UINT64 // 8 bytes, unsigned
 } ValueType;
 
-// SIMD-accelerated integer value search
-bool ScanForIntValueSIMD(const BYTE* buffer, size_t bufferSize, int valueToFind);
-bool ScanForFloatValueSIMD(const BYTE* buffer, size_t bufferSize, float valueToFind);
+// A value to search for. Integer types compare against i cut to their
+// width (unsigned values keep their bit pattern); float, double and the
+// floating point half of auto scans compare against f. Auto scans skip the
+// integer compares when f has a fraction.
+typedef struct {
+    int64_t i;
+    double f;
+} ScanValue;
 
-// Smart auto-detection of value type
-ValueType DetectValueType(const BYTE* buffer, size_t bufferSize, int valueToFind);
+typedef enum {
+    SCAN_KERNEL_SCALAR,
+    SCAN_KERNEL_SSE2,
+    SCAN_KERNEL_AVX2,
+    SCAN_KERNEL_AVX512
+} ScanKernelLevel;
+
+const double DEFAULT_SCAN_EPSILON = 0.0001;
+
+// Inclusive bounds for range scans, held like a ScanValue: integer types
+// use i (read back at the type's width and signedness), float and double
+// use f. low > high matches nothing. Auto scans compare ranges as int.
+typedef struct {
+    ScanValue low;
+    ScanValue high;
+} ScanRange;
+
+// Best kernel level this CPU and OS support, detected via CPUID on first
+// use and cached for the rest of the run.
+ScanKernelLevel GetScanKernelLevel();
+const char* GetScanKernelName(ScanKernelLevel level);
+
+// Writes the offset of every match of value that starts in [0, limit) at a
+// multiple of stride (the value size for aligned scans, 1 for unaligned;
+// VALUE_TYPE_AUTO is always unaligned) and returns the count. Floats and
+// doubles match within epsilon. Bytes up to bufferSize may be read to
+// complete values that start just before limit. offsets must hold at least
+// limit / stride + 1 entries. The type, stride and kernel are picked once
+// per call; the block loop itself is specialized for each combination.
+size_t FindValueOffsets(const BYTE* buffer, size_t bufferSize, size_t limit, const ScanValue& value,
+                        ValueType type, size_t stride, double epsilon, uint32_t* offsets,
+                        ScanKernelLevel level);
+
+// Single-value check with the same rules as the kernels.
+bool MatchesValue(const BYTE* p, size_t available, const ScanValue& value, ValueType type, double epsilon);
 
-// Smart scan implementation that determines best strategy based on value and settings
-bool SmartScan(const BYTE* buffer, size_t bufferSize, int valueToFind, 
-               ValueType type, const Settings* settings, DWORD* outAddress = nullptr);
+// FindValueOffsets for values inside range. Each kernel level tests both
+// bounds with two vector compares per lane, so range, greater/less-than
+// and tolerance scans run at the speed of exact ones.
+size_t FindRangeOffsets(const BYTE* buffer, size_t bufferSize, size_t limit, const ScanRange& range,
+                        ValueType type, size_t stride, uint32_t* offsets, ScanKernelLevel level);
 
-// SSE helper function
-__m128 _mm_abs_ps(__m128 x);
+bool MatchesRange(const BYTE* p, size_t available, const ScanRange& range, ValueType type);
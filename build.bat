@@ -13,12 +13,28 @@ if errorlevel 1 (
 
 g++ -o build\CEngine.exe ^
 main.cpp ^
+scan_engine.cpp ^
+scan_pipeline.cpp ^
+scan_buffer_pool.cpp ^
+write_tracking.cpp ^
+scan_threads.cpp ^
+scan_results.cpp ^
+snapshot.cpp ^
+pointer_scan.cpp ^
+pointer_map_file.cpp ^
+pattern_scan.cpp ^
+multi_scan.cpp ^
+group_scan.cpp ^
+value_refresher.cpp ^
 settings.cpp ^
 settings_ui.cpp ^
 logging.cpp ^
 log_console.cpp ^
 debug_info.cpp ^
 memory_protection.cpp ^
+memory_source.cpp ^
+region_map.cpp ^
+memory_source_win32.cpp ^
 advanced_scanning.cpp ^
 include/imgui.cpp ^
 include/imgui_demo.cpp ^
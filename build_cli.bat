@@ -0,0 +1,36 @@
+@echo off
+
+REM Headless scanner (console subsystem, no ImGui/D3D)
+g++ -o build\cengine-cli.exe ^
+cli_main.cpp ^
+scan_engine.cpp ^
+scan_pipeline.cpp ^
+scan_buffer_pool.cpp ^
+write_tracking.cpp ^
+scan_threads.cpp ^
+scan_results.cpp ^
+snapshot.cpp ^
+pointer_scan.cpp ^
+pointer_map_file.cpp ^
+pattern_scan.cpp ^
+multi_scan.cpp ^
+group_scan.cpp ^
+settings.cpp ^
+logging.cpp ^
+debug_info.cpp ^
+memory_protection.cpp ^
+memory_source.cpp ^
+region_map.cpp ^
+memory_source_win32.cpp ^
+advanced_scanning.cpp ^
+-I. ^
+-lpsapi ^
+-lshell32 ^
+-lole32 ^
+-DWIN32_LEAN_AND_MEAN ^
+-DWINVER=0x0601 ^
+-D_WIN32_WINNT=0x0601 ^
+-O2 ^
+-std=c++11 ^
+-Wl,-Bstatic -lstdc++ -lpthread -Wl,-Bdynamic ^
+-static
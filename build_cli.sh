@@ -0,0 +1,29 @@
+#!/bin/sh
+# Headless scanner for Linux (reads the target through process_vm_readv)
+mkdir -p build
+
+g++ -o build/cengine-cli \
+cli_main.cpp \
+scan_engine.cpp \
+scan_pipeline.cpp \
+scan_buffer_pool.cpp \
+write_tracking.cpp \
+scan_threads.cpp \
+scan_results.cpp \
+snapshot.cpp \
+pointer_scan.cpp \
+pointer_map_file.cpp \
+pattern_scan.cpp \
+multi_scan.cpp \
+group_scan.cpp \
+settings.cpp \
+logging.cpp \
+debug_info.cpp \
+memory_source.cpp \
+region_map.cpp \
+memory_source_linux.cpp \
+advanced_scanning.cpp \
+-I. \
+-O2 \
+-std=c++11 \
+-pthread
@@ -0,0 +1,673 @@
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <chrono>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#include "settings.h"
+#include "logging.h"
+#include "scan_engine.h"
+#include "pointer_scan.h"
+#include "pointer_map_file.h"
+#include "region_map.h"
+#include "pattern_scan.h"
+#include "multi_scan.h"
+#include "group_scan.h"
+
+// Headless front-end for the scan engine. Usage:
+//
+//   cengine-cli --pid <pid> (--value <n> | --greater <n> | --less <n> | --between <a>,<b> | --unknown)
+//               [--type <t>] [--fuzzy <threshold>]
+//               [--threads <n>] [--pipeline <n>] [--large-pages] [--read-all] [--incremental]
+//               [--no-pin] [--priority <1-5>]
+//               [--narrow <n> | --next <compare>]... [--interval <ms>]
+//               [--write <n>] [--verify] [--epsilon <e>] [--format csv|bin] [--output <file>]
+//               [--verbose]
+//   cengine-cli --pid <pid> --pointer-scan <address> [--max-depth <n>] [--max-offset <n>]
+//               [--save-map <file>] [--output <file>]
+//   cengine-cli --load-map <file> --pointer-scan <address> [--max-depth <n>] [--max-offset <n>]
+//               [--output <file>]
+//   cengine-cli --pid <pid> --revalidate <paths file> --pointer-scan <address> [--output <file>]
+//   cengine-cli --pid <pid> --pattern "<signature>"... [--pattern-data] [--output <file>]
+//   cengine-cli --pid <pid> --values <n>,<type>:<n>,... [--type <t>] [--output <file>]
+//   cengine-cli --pid <pid> --group <type>:<n>@<offset>,... [--type <t>] [--output <file>]
+//
+// Results go to stdout (or --output); status and timing go to stderr.
+
+static bool g_quiet = false;
+
+void ShowStatusMessage(const char* message) {
+    if (!message || g_quiet) return;
+    fprintf(stderr, "%s\n", message);
+}
+
+void ShowFormattedStatusMessage(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    ShowStatusMessage(buffer);
+}
+
+typedef enum {
+    OUTPUT_CSV,
+    OUTPUT_BINARY
+} OutputFormat;
+
+// Binary result file: BinaryResultHeader followed by count BinaryResultRecord.
+#pragma pack(push, 1)
+typedef struct {
+    char magic[4];          // "CERS"
+    uint32_t version;       // Format version (2)
+    uint32_t valueType;     // ValueType of the scan
+    uint32_t reserved;
+    uint64_t count;         // Number of records
+} BinaryResultHeader;
+
+// Values are the raw bytes of the scanned type, zero-extended.
+typedef struct {
+    uint64_t address;
+    uint64_t value;
+    uint64_t originalValue;
+} BinaryResultRecord;
+#pragma pack(pop)
+
+// One narrowing step, in command line order. Values are parsed once the
+// scan type is known, so --type may come after them.
+typedef struct {
+    ScanCompareType compare;
+    const char* text;       // nullptr for compares without a value
+    ScanValue value;
+    ScanValue high;         // Upper bound of between
+} NarrowStep;
+
+static const struct {
+    const char* name;
+    ScanCompareType compare;
+    bool takesValue;
+} kCompareNames[] = {
+    { "exact", SCAN_COMPARE_EXACT, true },
+    { "changed", SCAN_COMPARE_CHANGED, false },
+    { "unchanged", SCAN_COMPARE_UNCHANGED, false },
+    { "increased", SCAN_COMPARE_INCREASED, false },
+    { "decreased", SCAN_COMPARE_DECREASED, false },
+    { "increased-by", SCAN_COMPARE_INCREASED_BY, true },
+    { "decreased-by", SCAN_COMPARE_DECREASED_BY, true },
+    { "greater", SCAN_COMPARE_GREATER, true },
+    { "less", SCAN_COMPARE_LESS, true },
+    { "between", SCAN_COMPARE_BETWEEN, true },
+};
+
+static void printUsage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s --pid <pid> (--value <n> | --greater <n> | --less <n> | --between <a>,<b> |\n"
+        "              --unknown) [options]\n"
+        "       %s --pid <pid> --pointer-scan <address> [options]\n"
+        "       %s --load-map <file> --pointer-scan <address> [options]\n"
+        "       %s --pid <pid> --pattern \"48 8B 05 ?? ?? ?? ??\" [options]\n"
+        "       %s --pid <pid> --values 100,250,float:3 [options]\n"
+        "       %s --pid <pid> --group int:100,int:100,float:?@12 [options]\n"
+        "\n"
+        "Options:\n"
+        "  --type <t>        int, short, byte, int64, uint16, uint32, uint64, float,\n"
+        "                    double or auto (default: int)\n"
+        "  --threads <n>     Number of scan threads\n"
+        "  --pipeline <n>    Chunk buffers each scan thread reads ahead into;\n"
+        "                    below 2 reads inline (default: scanPipelineDepth)\n"
+        "  --large-pages     Back scan buffers with 2 MB pages when available\n"
+        "  --read-all        Also read untouched, zero and swapped out pages\n"
+        "  --incremental     Narrow steps only re-read pages the target wrote\n"
+        "                    since the last full read (Linux soft-dirty bits)\n"
+        "  --no-pin          Let scan threads float instead of pinning them to\n"
+        "                    physical cores and NUMA nodes\n"
+        "  --priority <n>    Scan thread priority, 1 (lowest) to 5 (highest)\n"
+        "  --unknown         Start with an unknown initial value snapshot\n"
+        "  --narrow <n>      Narrow results to value n (repeatable)\n"
+        "  --next <c>[:n]    Narrow by comparing with the previous scan: changed,\n"
+        "                    unchanged, increased, decreased, increased-by:n,\n"
+        "                    decreased-by:n or exact:n; or by value: greater:n,\n"
+        "                    less:n or between:a,b (repeatable)\n"
+        "  --interval <ms>   Delay before each narrow step (default: 0)\n"
+        "  --write <n>       Write n to every remaining result\n"
+        "  --verify          Re-read pages holding hits and drop values that changed\n"
+        "  --epsilon <e>     Float and double tolerance (default: floatEpsilon)\n"
+        "  --fuzzy <t>       Exact float and double matches within t of the value,\n"
+        "                    relative (0.01 = 1%%)\n"
+        "  --format <f>      csv or bin (default: csv)\n"
+        "  --output <file>   Write results to file instead of stdout\n"
+        "  --pointer-scan <a> Find static pointer paths to hex address a\n"
+        "  --max-depth <n>   Pointer levels to follow (default: maxPointerDepth)\n"
+        "  --max-offset <n>  Largest pointer offset (default: maxPointerOffset)\n"
+        "  --save-map <file> Also save the pointer map to file\n"
+        "  --load-map <file> Search a saved pointer map instead of a process\n"
+        "  --revalidate <f>  Keep the paths in f that still lead to the address\n"
+        "  --pattern <sig>   Find an array-of-bytes signature in module code;\n"
+        "                    ?? is a wildcard byte, 4? a wildcard nibble (repeatable)\n"
+        "  --pattern-data    Also search non-executable module sections\n"
+        "  --values <list>   Find several values in one pass; each may carry a\n"
+        "                    type: prefix, the rest use --type\n"
+        "  --group <list>    Find structs holding [type:]value[@offset] members;\n"
+        "                    ? matches any value, offsets default to packed\n"
+        "  --settings <file> Load settings from file instead of defaults\n"
+        "  --verbose         Log engine activity to stderr\n"
+        "  --quiet           Suppress status messages\n",
+        program, program, program, program, program, program);
+}
+
+static bool parseCompare(const char* text, NarrowStep* step) {
+    const char* colon = strchr(text, ':');
+    size_t nameLength = colon ? (size_t)(colon - text) : strlen(text);
+    for (size_t i = 0; i < sizeof(kCompareNames) / sizeof(kCompareNames[0]); i++) {
+        if (strlen(kCompareNames[i].name) != nameLength || _strnicmp(text, kCompareNames[i].name, nameLength) != 0) {
+            continue;
+        }
+        step->compare = kCompareNames[i].compare;
+        step->text = nullptr;
+        step->value = MakeScanValue(0);
+        step->high = MakeScanValue(0);
+        if (kCompareNames[i].takesValue) {
+            step->text = colon ? colon + 1 : nullptr;
+            return step->text != nullptr;
+        }
+        return !colon;
+    }
+    return false;
+}
+
+static bool parseInt(const char* text, int* value) {
+    char* end = nullptr;
+    long parsed = strtol(text, &end, 0);
+    if (!end || *end != '\0' || end == text) {
+        return false;
+    }
+    *value = (int)parsed;
+    return true;
+}
+
+// Parses text as a value, or as "a,b" for between.
+static bool parseStepValue(const char* text, ValueType type, ScanCompareType compare,
+                           ScanValue* value, ScanValue* high) {
+    if (compare != SCAN_COMPARE_BETWEEN) {
+        return parseScanValue(text, type, value);
+    }
+    const char* end = nullptr;
+    return parseScanValue(text, type, value, &end) && *end == ',' && parseScanValue(end + 1, type, high);
+}
+
+static bool parseAddress(const char* text, uintptr_t* address) {
+    char* end = nullptr;
+    unsigned long long parsed = strtoull(text, &end, 16);
+    if (!end || *end != '\0' || end == text) {
+        return false;
+    }
+    *address = (uintptr_t)parsed;
+    return true;
+}
+
+static bool writeResults(FILE* out, const ScanResults* results, OutputFormat format) {
+    if (format == OUTPUT_BINARY) {
+        BinaryResultHeader header;
+        memcpy(header.magic, "CERS", 4);
+        header.version = 2;
+        header.valueType = (uint32_t)currentValueType;
+        header.reserved = 0;
+        header.count = results->count;
+        if (fwrite(&header, sizeof(header), 1, out) != 1) {
+            return false;
+        }
+    } else {
+        fprintf(out, "address,value,original\n");
+    }
+
+    // Walk region by region so bitmap regions decode sequentially.
+    std::vector<uint32_t> offsets(4096);
+    for (size_t r = 0; r < results->regions.size(); r++) {
+        const ResultRegion& region = results->regions[r];
+        for (size_t entry = 0; entry < region.count; ) {
+            size_t n = getScanResultOffsets(results, r, entry, offsets.data(), offsets.size());
+            for (size_t i = 0; i < n; i++) {
+                size_t index = region.firstEntry + entry + i;
+                uintptr_t address = region.base + offsets[i];
+                const BYTE* value = getScanResultValue(results, index);
+                const BYTE* originalValue = getScanResultOriginal(results, index);
+
+                if (format == OUTPUT_CSV) {
+                    char valueText[32];
+                    char originalText[32];
+                    FormatScanValue(value, results->valueSize, results->valueType, valueText, sizeof(valueText));
+                    FormatScanValue(originalValue, results->valueSize, results->valueType,
+                                    originalText, sizeof(originalText));
+                    fprintf(out, "0x%llX,%s,%s\n", (unsigned long long)address, valueText, originalText);
+                } else {
+                    BinaryResultRecord record = { address, 0, 0 };
+                    memcpy(&record.value, value, results->valueSize);
+                    memcpy(&record.originalValue, originalValue, results->valueSize);
+                    if (fwrite(&record, sizeof(record), 1, out) != 1) {
+                        return false;
+                    }
+                }
+            }
+            entry += n;
+        }
+    }
+    return !ferror(out);
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int pid = 0;
+    const char* valueText = nullptr;
+    ScanCompareType valueCompare = SCAN_COMPARE_EXACT;
+    ScanValue value = MakeScanValue(0);
+    ScanValue high = MakeScanValue(0);
+    float fuzzy = -1.0f;
+    int threads = 0;
+    int pipeline = -1;
+    bool largePages = false;
+    bool readAll = false;
+    bool incremental = false;
+    bool noPin = false;
+    int priority = 0;
+    int interval = 0;
+    const char* writeText = nullptr;
+    ScanValue writeValue = MakeScanValue(0);
+    double epsilon = 0.0;
+    bool verbose = false;
+    bool verify = false;
+    OutputFormat format = OUTPUT_CSV;
+    const char* outputPath = nullptr;
+    const char* settingsPath = nullptr;
+    ValueType type = VALUE_TYPE_INT;
+    bool unknown = false;
+    std::vector<NarrowStep> steps;
+    uintptr_t pointerTarget = 0;
+    bool pointerScanMode = false;
+    int maxDepth = 0;
+    int maxOffset = 0;
+    const char* saveMapPath = nullptr;
+    const char* loadMapPath = nullptr;
+    const char* revalidatePath = nullptr;
+    std::vector<BytePattern> patterns;
+    bool patternData = false;
+    const char* valuesText = nullptr;
+    const char* groupText = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* next = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool ok = true;
+
+        if (strcmp(arg, "--pid") == 0 && next) {
+            ok = parseInt(next, &pid); i++;
+        } else if (strcmp(arg, "--value") == 0 && next) {
+            valueText = next; i++;
+        } else if ((strcmp(arg, "--greater") == 0 || strcmp(arg, "--less") == 0 ||
+                    strcmp(arg, "--between") == 0) && next) {
+            valueText = next; i++;
+            valueCompare = arg[2] == 'g' ? SCAN_COMPARE_GREATER :
+                           arg[2] == 'l' ? SCAN_COMPARE_LESS : SCAN_COMPARE_BETWEEN;
+        } else if (strcmp(arg, "--fuzzy") == 0 && next) {
+            char* end = nullptr;
+            fuzzy = strtof(next, &end);
+            ok = end != next && *end == '\0' && fuzzy >= 0.0f && fuzzy <= 1.0f; i++;
+        } else if (strcmp(arg, "--type") == 0 && next) {
+            ok = parseValueTypeName(next, strlen(next), &type); i++;
+        } else if (strcmp(arg, "--threads") == 0 && next) {
+            ok = parseInt(next, &threads) && threads > 0; i++;
+        } else if (strcmp(arg, "--narrow") == 0 && next) {
+            NarrowStep step = { SCAN_COMPARE_EXACT, next, MakeScanValue(0), MakeScanValue(0) };
+            i++;
+            steps.push_back(step);
+        } else if (strcmp(arg, "--next") == 0 && next) {
+            NarrowStep step;
+            ok = parseCompare(next, &step); i++;
+            steps.push_back(step);
+        } else if (strcmp(arg, "--unknown") == 0) {
+            unknown = true;
+        } else if (strcmp(arg, "--interval") == 0 && next) {
+            ok = parseInt(next, &interval) && interval >= 0; i++;
+        } else if (strcmp(arg, "--write") == 0 && next) {
+            writeText = next; i++;
+        } else if (strcmp(arg, "--format") == 0 && next) {
+            if (_stricmp(next, "csv") == 0) format = OUTPUT_CSV;
+            else if (_stricmp(next, "bin") == 0) format = OUTPUT_BINARY;
+            else ok = false;
+            i++;
+        } else if (strcmp(arg, "--output") == 0 && next) {
+            outputPath = next; i++;
+        } else if (strcmp(arg, "--pointer-scan") == 0 && next) {
+            ok = parseAddress(next, &pointerTarget); pointerScanMode = ok; i++;
+        } else if (strcmp(arg, "--max-depth") == 0 && next) {
+            ok = parseInt(next, &maxDepth) && maxDepth > 0; i++;
+        } else if (strcmp(arg, "--max-offset") == 0 && next) {
+            ok = parseInt(next, &maxOffset) && maxOffset > 0; i++;
+        } else if (strcmp(arg, "--save-map") == 0 && next) {
+            saveMapPath = next; i++;
+        } else if (strcmp(arg, "--load-map") == 0 && next) {
+            loadMapPath = next; i++;
+        } else if (strcmp(arg, "--revalidate") == 0 && next) {
+            revalidatePath = next; i++;
+        } else if (strcmp(arg, "--pattern") == 0 && next) {
+            BytePattern pattern;
+            ok = compileBytePattern(next, &pattern); i++;
+            patterns.push_back(pattern);
+        } else if (strcmp(arg, "--values") == 0 && next) {
+            valuesText = next; i++;
+        } else if (strcmp(arg, "--group") == 0 && next) {
+            groupText = next; i++;
+        } else if (strcmp(arg, "--pattern-data") == 0) {
+            patternData = true;
+        } else if (strcmp(arg, "--settings") == 0 && next) {
+            settingsPath = next; i++;
+        } else if (strcmp(arg, "--pipeline") == 0 && next) {
+            ok = parseInt(next, &pipeline) && pipeline >= 0 && pipeline <= 16; i++;
+        } else if (strcmp(arg, "--large-pages") == 0) {
+            largePages = true;
+        } else if (strcmp(arg, "--read-all") == 0) {
+            readAll = true;
+        } else if (strcmp(arg, "--incremental") == 0) {
+            incremental = true;
+        } else if (strcmp(arg, "--no-pin") == 0) {
+            noPin = true;
+        } else if (strcmp(arg, "--priority") == 0 && next) {
+            ok = parseInt(next, &priority) && priority >= 1 && priority <= 5; i++;
+        } else if (strcmp(arg, "--epsilon") == 0 && next) {
+            char* end = nullptr;
+            epsilon = strtod(next, &end);
+            ok = end != next && *end == '\0' && epsilon > 0.0; i++;
+        } else if (strcmp(arg, "--verify") == 0) {
+            verify = true;
+        } else if (strcmp(arg, "--verbose") == 0) {
+            verbose = true;
+        } else if (strcmp(arg, "--quiet") == 0) {
+            g_quiet = true;
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "Invalid argument: %s%s%s\n", arg, next ? " " : "", next ? next : "");
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (valueText && !parseStepValue(valueText, type, valueCompare, &value, &high)) {
+        fprintf(stderr, "Invalid value: %s\n", valueText);
+        return 2;
+    }
+    if (writeText && !parseScanValue(writeText, type, &writeValue)) {
+        fprintf(stderr, "Invalid argument: --write %s\n", writeText);
+        return 2;
+    }
+    for (size_t i = 0; i < steps.size(); i++) {
+        if (steps[i].text && !parseStepValue(steps[i].text, type, steps[i].compare, &steps[i].value, &steps[i].high)) {
+            fprintf(stderr, "Invalid value for %s: %s\n", GetScanCompareName(steps[i].compare), steps[i].text);
+            return 2;
+        }
+    }
+
+    bool needsProcess = !loadMapPath;
+    bool pointerMode = pointerScanMode || loadMapPath || revalidatePath;
+    bool patternMode = !patterns.empty();
+    std::vector<ScanTarget> targets;
+    if (valuesText && !parseScanTargets(valuesText, type, targets)) {
+        fprintf(stderr, "Invalid argument: --values %s\n", valuesText);
+        return 2;
+    }
+    bool multiMode = !targets.empty();
+    ScanGroup group;
+    if (groupText && !parseScanGroup(groupText, type, &group)) {
+        fprintf(stderr, "Invalid argument: --group %s\n", groupText);
+        return 2;
+    }
+    bool groupMode = groupText != nullptr;
+    if ((needsProcess && pid <= 0) || (pointerMode && !pointerScanMode) ||
+        (!pointerMode && !patternMode && !multiMode && !groupMode && (valueText != nullptr) == unknown)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    Logger::getInstance().init(false, verbose);
+    LOG_INFO("Scan kernels: %s", GetScanKernelName(GetScanKernelLevel()));
+
+    if (settingsPath) {
+        if (!loadSettings(&g_settings, settingsPath)) {
+            fprintf(stderr, "Failed to load settings from %s, using defaults\n", settingsPath);
+        }
+        validateSettings(&g_settings);
+    } else {
+        initSettings(&g_settings);
+    }
+    if (verify) {
+        g_settings.verifyScanHits = true;
+    }
+    if (largePages) {
+        g_settings.useLargePages = true;
+    }
+    if (readAll) {
+        g_settings.skipZeroRegions = false;
+        g_settings.skipSwappedPages = false;
+    }
+    if (incremental) {
+        g_settings.incrementalNextScan = true;
+    }
+    if (noPin) {
+        g_settings.pinThreadsToCores = false;
+    }
+    if (priority > 0) {
+        g_settings.threadPriorityLevel = priority;
+    }
+    if (pipeline >= 0) {
+        g_settings.scanPipelineDepth = pipeline;
+    }
+    if (epsilon > 0.0) {
+        g_settings.floatEpsilon = epsilon;
+    }
+    if (fuzzy >= 0.0f) {
+        g_settings.useFuzzyScanning = true;
+        g_settings.fuzzyThreshold = fuzzy;
+    }
+    if (threads > 0) {
+        g_settings.threadCount = threads;
+        if (g_settings.maxThreadCount < threads) {
+            g_settings.maxThreadCount = threads;
+        }
+    }
+
+    if (pointerMode) {
+        if (maxDepth > 0) {
+            g_settings.maxPointerDepth = maxDepth;
+        }
+        if (maxOffset > 0) {
+            g_settings.maxPointerOffset = maxOffset;
+        }
+        validateSettings(&g_settings);
+    }
+
+    if (loadMapPath) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        MappedPointerMap map;
+        if (!openPointerMap(loadMapPath, &map)) {
+            fprintf(stderr, "Failed to load pointer map %s\n", loadMapPath);
+            return 1;
+        }
+        std::vector<PointerPath> paths;
+        findPointerPaths(map.entries, map.entryCount, map.modules, pointerTarget,
+                         g_settings.maxPointerDepth, g_settings.maxPointerOffset, POINTER_SCAN_MAX_PATHS, paths);
+        bool written = writePointerPaths(outputPath, map.modules, pointerTarget, paths);
+        fprintf(stderr, "pointer map search: %zu paths to 0x%llX in %.1f ms (%zu pointers, depth %d, offset %d)\n",
+                paths.size(), (unsigned long long)pointerTarget, elapsedMs(start), map.entryCount,
+                g_settings.maxPointerDepth, g_settings.maxPointerOffset);
+        closePointerMap(&map);
+        return written ? 0 : 1;
+    }
+
+    ProcessInfo process = ProcessInfo();
+    process.processId = (DWORD)pid;
+    process.settings = &g_settings;
+    process.memory = CreateRegionMapSource(CreateMemorySource((DWORD)pid), &g_settings);
+    if (!process.memory) {
+        fprintf(stderr, "Failed to open process %d\n", pid);
+        return 1;
+    }
+
+    if (patternMode) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<PatternMatch> matches;
+        std::vector<ModuleInfo> modules;
+        scanBytePatterns(&process, patterns, !patternData, matches, modules);
+        double ms = elapsedMs(start);
+        bool written = writePatternMatches(outputPath, matches, modules);
+        fprintf(stderr, "pattern scan: %zu matches for %zu signatures, %.2f MB in %.1f ms (%s)\n",
+                matches.size(), patterns.size(), (double)g_bytesScanned.load() / (1024.0 * 1024.0), ms,
+                GetScanKernelName(g_settings.useVectorizedOperations ? GetScanKernelLevel() : SCAN_KERNEL_SCALAR));
+        delete process.memory;
+        return written ? 0 : 1;
+    }
+
+    if (multiMode) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<MultiScanMatch> matches;
+        scanMultipleValues(&process, targets, matches);
+        double ms = elapsedMs(start);
+        bool written = writeMultiScanMatches(outputPath, targets, matches);
+        double mb = (double)g_bytesScanned.load() / (1024.0 * 1024.0);
+        fprintf(stderr, "multi scan: %zu matches for %zu values, %.2f MB in %.1f ms (%.1f MB/s, %d threads)\n",
+                matches.size(), targets.size(), mb, ms, ms > 0 ? mb * 1000.0 / ms : 0.0,
+                GetScanThreadCount(&g_settings));
+        delete process.memory;
+        return written ? 0 : 1;
+    }
+
+    if (groupMode) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<uintptr_t> bases;
+        scanMemoryGroup(&process, group, bases);
+        double ms = elapsedMs(start);
+        bool written = writeGroupMatches(outputPath, bases);
+        double mb = (double)g_bytesScanned.load() / (1024.0 * 1024.0);
+        fprintf(stderr, "group scan: %zu matches for %zu members, %.2f MB in %.1f ms (%.1f MB/s, %d threads)\n",
+                bases.size(), group.members.size(), mb, ms, ms > 0 ? mb * 1000.0 / ms : 0.0,
+                GetScanThreadCount(&g_settings));
+        delete process.memory;
+        return written ? 0 : 1;
+    }
+
+    if (revalidatePath) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<ModuleInfo> modules;
+        std::vector<PointerPath> paths;
+        if (!readPointerPaths(revalidatePath, modules, paths)) {
+            fprintf(stderr, "Failed to read pointer paths from %s\n", revalidatePath);
+            delete process.memory;
+            return 1;
+        }
+        size_t before = paths.size();
+        revalidatePointerPaths(&process, modules, paths, pointerTarget);
+        bool written = writePointerPaths(outputPath, modules, pointerTarget, paths);
+        fprintf(stderr, "revalidate: %zu -> %zu paths to 0x%llX in %.1f ms\n",
+                before, paths.size(), (unsigned long long)pointerTarget, elapsedMs(start));
+        delete process.memory;
+        return written ? 0 : 1;
+    }
+
+    if (pointerScanMode) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t paths = 0;
+        bool scanned = pointerScan(&process, pointerTarget, outputPath, saveMapPath, &paths);
+        fprintf(stderr, "pointer scan: %zu paths to 0x%llX in %.1f ms (%.2f MB, depth %d, offset %d)\n",
+                paths, (unsigned long long)pointerTarget, elapsedMs(start),
+                (double)g_bytesScanned.load() / (1024.0 * 1024.0),
+                g_settings.maxPointerDepth, g_settings.maxPointerOffset);
+        delete process.memory;
+        return scanned ? 0 : 1;
+    }
+
+    currentValueType = type;
+    initScanResults(&g_scanResults, type);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (unknown) {
+        scanUnknownInitialValue(&process);
+    } else {
+        scanMemory(&process, value, valueCompare, high);
+    }
+    double scanMs = elapsedMs(start);
+    double scannedMB = (double)g_bytesScanned.load() / (1024.0 * 1024.0);
+    if (unknown) {
+        fprintf(stderr, "snapshot: %.2f MB in %.1f ms (%.1f MB/s, %.2f MB compressed, %.2f MB spilled)\n",
+                scannedMB, scanMs, scanMs > 0.0 ? scannedMB / (scanMs / 1000.0) : 0.0,
+                (double)(g_memorySnapshot.memoryBytes + g_memorySnapshot.spillBytes) / (1024.0 * 1024.0),
+                (double)g_memorySnapshot.spillBytes / (1024.0 * 1024.0));
+    } else {
+        fprintf(stderr, "scan: %zu results, %.2f MB in %.1f ms (%.1f MB/s, %d threads, %.2f MB skipped)\n",
+                g_scanResults.count, scannedMB, scanMs,
+                scanMs > 0.0 ? scannedMB / (scanMs / 1000.0) : 0.0, g_settings.threadCount,
+                (double)g_bytesSkipped.load() / (1024.0 * 1024.0));
+    }
+
+    for (size_t i = 0; i < steps.size() && (g_scanResults.count > 0 || hasMemorySnapshot(&g_memorySnapshot)); i++) {
+        if (interval > 0) {
+            Sleep((DWORD)interval);
+        }
+        size_t before = g_scanResults.count;
+        start = std::chrono::steady_clock::now();
+        nextScan(&process, steps[i].compare, steps[i].value, steps[i].high);
+        fprintf(stderr, "%s %s: %zu -> %zu results in %.1f ms (%.2f MB read, %.2f MB reused)\n",
+                GetScanCompareName(steps[i].compare), steps[i].text ? steps[i].text : "-", before,
+                g_scanResults.count, elapsedMs(start), (double)g_bytesScanned.load() / (1024.0 * 1024.0),
+                (double)g_bytesSkipped.load() / (1024.0 * 1024.0));
+    }
+    freeMemorySnapshot(&g_memorySnapshot);
+
+    if (writeText) {
+        for (size_t i = 0; i < g_scanResults.count; i++) {
+            updateMemoryValue(&process, getScanResultAddress(&g_scanResults, i), writeValue);
+        }
+        fprintf(stderr, "write: %s written to %zu addresses\n", writeText, g_scanResults.count);
+    }
+
+    FILE* out = stdout;
+#ifdef _WIN32
+    // A text mode stdout would turn every 0x0A byte into 0x0D 0x0A.
+    if (!outputPath && format == OUTPUT_BINARY) {
+        _setmode(_fileno(stdout), _O_BINARY);
+    }
+#endif
+    if (outputPath) {
+        out = fopen(outputPath, format == OUTPUT_BINARY ? "wb" : "w");
+        if (!out) {
+            fprintf(stderr, "Failed to open %s for writing\n", outputPath);
+            freeScanResults(&g_scanResults);
+            delete process.memory;
+            return 1;
+        }
+    }
+
+    bool written = writeResults(out, &g_scanResults, format);
+    if (out != stdout) {
+        fclose(out);
+    }
+    if (!written) {
+        fprintf(stderr, "Failed to write results\n");
+    }
+
+    freeScanResults(&g_scanResults);
+    delete process.memory;
+    return written ? 0 : 1;
+}
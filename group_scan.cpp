@@ -0,0 +1,350 @@
+#include "platform.h"
+#include <emmintrin.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include "group_scan.h"
+#include "multi_scan.h"
+#include "scan_buffer_pool.h"
+#include "logging.h"
+
+// Guess at how rare a member's value is in live memory: wider values
+// carry more bits, while zero, +-1 and small counters or flags are
+// everywhere. Wildcards are never searched.
+static int MemberRarity(const GroupMember& member) {
+    if (member.wildcard) {
+        return -1;
+    }
+    int bits = GetValueTypeSize(member.type) * 8;
+    double magnitude = std::fabs(member.type == VALUE_TYPE_FLOAT || member.type == VALUE_TYPE_DOUBLE ?
+                                 member.value.f : (double)member.value.i);
+    if (magnitude == 0) {
+        return bits / 8;
+    }
+    if (magnitude == 1) {
+        return bits / 4;
+    }
+    if (magnitude < 256) {
+        return bits / 2;
+    }
+    return bits;
+}
+
+bool parseScanGroup(const char* text, ValueType defaultType, ScanGroup* group) {
+    group->members.clear();
+    const char* p = text;
+    while (*p) {
+        while (*p == ' ' || *p == ',') p++;
+        if (!*p) break;
+
+        GroupMember member = { defaultType, MakeScanValue(0), 0, false };
+        const char* colon = strchr(p, ':');
+        const char* comma = strchr(p, ',');
+        const char* at = strchr(p, '@');
+        if (colon && (!comma || colon < comma) && (!at || colon < at)) {
+            if (!parseValueTypeName(p, colon - p, &member.type)) {
+                LOG_ERROR("Unknown value type in group \"%s\"", text);
+                return false;
+            }
+            p = colon + 1;
+        }
+
+        if (*p == '?') {
+            member.wildcard = true;
+            p++;
+        } else if (member.type == VALUE_TYPE_AUTO || !parseScanValue(p, member.type, &member.value, &p)) {
+            LOG_ERROR("Malformed value in group \"%s\"", text);
+            return false;
+        }
+
+        if (*p == '@') {
+            char* end = nullptr;
+            member.offset = (int)strtol(p + 1, &end, 0);
+            if (end == p + 1) {
+                LOG_ERROR("Malformed offset in group \"%s\"", text);
+                return false;
+            }
+            p = end;
+        } else if (!group->members.empty()) {
+            const GroupMember& previous = group->members.back();
+            member.offset = previous.offset + GetValueTypeSize(previous.type);
+        }
+
+        if ((*p && *p != ',' && *p != ' ') || member.type == VALUE_TYPE_AUTO) {
+            LOG_ERROR("Malformed member in group \"%s\"", text);
+            return false;
+        }
+        group->members.push_back(member);
+    }
+
+    const std::vector<GroupMember>& members = group->members;
+    if (members.empty() || members.size() > MAX_GROUP_MEMBERS) {
+        LOG_ERROR("Expected 1 to %zu group members, got %zu", MAX_GROUP_MEMBERS, members.size());
+        return false;
+    }
+
+    long long low = members[0].offset;
+    long long high = low;
+    for (size_t i = 0; i < members.size(); i++) {
+        low = std::min(low, (long long)members[i].offset);
+        high = std::max(high, (long long)members[i].offset + GetValueTypeSize(members[i].type));
+    }
+    if (high - low > (long long)MAX_GROUP_SPAN) {
+        LOG_ERROR("Group \"%s\" spans more than %zu bytes", text, MAX_GROUP_SPAN);
+        return false;
+    }
+    group->minOffset = (int)low;
+    group->span = (size_t)(high - low);
+
+    size_t padded = (group->span + 15) & ~(size_t)15;
+    group->bytes.assign(padded, 0);
+    group->mask.assign(padded, 0);
+    group->approx.clear();
+    std::vector<BYTE> used(group->span, 0);
+    group->anchor = 0;
+    for (size_t i = 0; i < members.size(); i++) {
+        const GroupMember& member = members[i];
+        size_t start = (size_t)(member.offset - group->minOffset);
+        size_t size = GetValueTypeSize(member.type);
+        for (size_t b = start; b < start + size; b++) {
+            if (used[b]++) {
+                LOG_ERROR("Group \"%s\" has overlapping members at offset %d", text, member.offset);
+                return false;
+            }
+        }
+
+        if (member.wildcard) {
+            continue;
+        }
+        if (member.type == VALUE_TYPE_FLOAT || member.type == VALUE_TYPE_DOUBLE) {
+            group->approx.push_back(i);
+        } else {
+            EncodeScanValue(member.value, member.type, &group->bytes[start]);
+            memset(&group->mask[start], 0xFF, size);
+        }
+        if (MemberRarity(member) > MemberRarity(members[group->anchor])) {
+            group->anchor = i;
+        }
+    }
+
+    if (members[group->anchor].wildcard) {
+        LOG_ERROR("Group \"%s\" needs at least one member with a value", text);
+        return false;
+    }
+    return true;
+}
+
+static bool GroupVerify(const ScanGroup& group, const BYTE* p, size_t available, double epsilon) {
+    for (size_t i = 0; i < group.bytes.size(); i += 16) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i m = _mm_loadu_si128((const __m128i*)(group.mask.data() + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(group.bytes.data() + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(d, m), b)) != 0xFFFF) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < group.approx.size(); i++) {
+        const GroupMember& member = group.members[group.approx[i]];
+        size_t start = (size_t)(member.offset - group.minOffset);
+        if (!MatchesValue(p + start, available - start, member.value, member.type, epsilon)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t scanMemoryGroup(ProcessInfo* process, const ScanGroup& group, std::vector<uintptr_t>& bases) {
+    bases.clear();
+    if (!process || !process->memory || !process->settings) {
+        LOG_ERROR("Invalid process handle");
+        return 0;
+    }
+    if (group.members.empty()) {
+        return 0;
+    }
+
+    bool searchingForZero = false;
+    for (size_t i = 0; i < group.members.size(); i++) {
+        searchingForZero = searchingForZero || (!group.members[i].wildcard && group.members[i].value.i == 0 &&
+                                               group.members[i].value.f == 0.0);
+    }
+
+    g_cancelScan = false;
+    g_scanInProgress = true;
+    g_regionsScanned = 0;
+    g_bytesScanned = 0;
+    g_bytesSkipped = 0;
+    g_matchesFound = 0;
+    g_regionsSkipped = 0;
+
+    std::vector<MemoryRegion> allRegions;
+    process->memory->refreshRegions();
+    process->memory->enumerateRegions(allRegions);
+
+    const SIZE_T chunkSize = GetScanChunkSize(process->settings);
+    std::vector<ScanChunk> chunks;
+    std::vector<size_t> chunksPerRegion;
+    size_t totalBytes = 0;
+    for (const auto& region : allRegions) {
+        if (IsLikelyValidDataRegion(region, searchingForZero)) {
+            chunksPerRegion.push_back(AddRegionChunks(region.base, region.size, chunksPerRegion.size(),
+                                                      chunkSize, chunks));
+            totalBytes += region.size;
+        } else if (region.state == MEM_COMMIT) {
+            g_regionsSkipped++;
+        }
+    }
+
+    std::unique_ptr<std::atomic<size_t>[]> regionChunksLeft(new std::atomic<size_t>[chunksPerRegion.size()]);
+    for (size_t r = 0; r < chunksPerRegion.size(); r++) {
+        regionChunksLeft[r] = chunksPerRegion[r];
+    }
+    std::atomic<size_t> matchCount(0);
+    g_totalRegionsToScan = chunksPerRegion.size();
+    g_totalMemoryToScan = totalBytes;
+
+    int threadCount = GetScanThreadCount(process->settings);
+    if ((size_t)threadCount > chunks.size()) {
+        threadCount = chunks.empty() ? 1 : (int)chunks.size();
+    }
+
+    const GroupMember& anchor = group.members[group.anchor];
+    BYTE anchorBytes[sizeof(uint64_t)];
+    char anchorText[32];
+    FormatScanValue(anchorBytes, EncodeScanValue(anchor.value, anchor.type, anchorBytes), anchor.type,
+                    anchorText, sizeof(anchorText));
+    LOG_INFO("Scanning %zu regions (%zu MB) for a %zu member group (%zu bytes, anchor %s at %+d) on %d threads",
+             chunksPerRegion.size(), totalBytes / (1024 * 1024), group.members.size(), group.span,
+             anchorText, anchor.offset, threadCount);
+
+    WorkStealingQueue<ScanChunk> queue(threadCount);
+    queue.distribute(chunks);
+
+    std::vector<std::vector<uintptr_t> > shards(threadCount);
+    std::vector<GroupScanThreadData> threadData(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        threadData[i].process = process;
+        threadData[i].group = &group;
+        threadData[i].matchCount = &matchCount;
+        threadData[i].shard = &shards[i];
+        threadData[i].queue = &queue;
+        threadData[i].workerIndex = i;
+        threadData[i].regionChunksLeft = regionChunksLeft.get();
+    }
+    RunScanWorkers(groupScanThreadFunc, threadData, process->settings);
+
+    g_scanInProgress = false;
+    g_scanProgress = 1.0;
+
+    for (size_t i = 0; i < shards.size(); i++) {
+        bases.insert(bases.end(), shards[i].begin(), shards[i].end());
+        std::vector<uintptr_t>().swap(shards[i]);
+    }
+    std::sort(bases.begin(), bases.end());
+
+    LOG_INFO("Group scan %s: %zu matches in %zu MB (%zu steals)", g_cancelScan ? "cancelled" : "done",
+             bases.size(), g_bytesScanned.load() / (1024 * 1024), queue.steals());
+    return bases.size();
+}
+
+bool writeGroupMatches(const char* filename, const std::vector<uintptr_t>& bases) {
+    FILE* file = filename ? fopen(filename, "w") : stdout;
+    if (!file) {
+        LOG_ERROR("Failed to open %s for writing", filename);
+        return false;
+    }
+
+    fprintf(file, "address\n");
+    for (size_t i = 0; i < bases.size(); i++) {
+        fprintf(file, "0x%llX\n", (unsigned long long)bases[i]);
+    }
+
+    bool ok = !ferror(file);
+    if (filename) {
+        ok = fclose(file) == 0 && ok;
+    }
+    if (!ok) {
+        LOG_ERROR("Failed to write group matches to %s", filename ? filename : "stdout");
+    }
+    return ok;
+}
+
+unsigned __stdcall groupScanThreadFunc(void* arg) {
+    GroupScanThreadData* data = static_cast<GroupScanThreadData*>(arg);
+    if (!data || !data->process || !data->process->memory || !data->group || !data->matchCount ||
+        !data->shard || !data->queue) {
+        LOG_ERROR("Invalid thread data");
+        return 1;
+    }
+
+    DWORD threadId = GetCurrentThreadId();
+    MemorySource* memory = data->process->memory;
+    const Settings* settings = data->process->settings;
+    const ScanGroup& group = *data->group;
+    std::vector<uintptr_t>& shard = *data->shard;
+    const ScanKernelLevel kernelLevel = settings->useVectorizedOperations ?
+                                        GetScanKernelLevel() : SCAN_KERNEL_SCALAR;
+    const double epsilon = GetScanEpsilon(settings);
+
+    // A group belongs to the chunk holding its first byte. Anchors are
+    // searched from the first aligned position at or past the anchor's
+    // offset into the group, so every hit leaves room for the members
+    // before it.
+    const GroupMember& anchor = group.members[group.anchor];
+    const size_t anchorRel = (size_t)(anchor.offset - group.minOffset);
+    const size_t stride = GetScanStride(settings, anchor.type);
+    const size_t first = (anchorRel + stride - 1) / stride * stride;
+
+    try {
+        const SIZE_T chunkSize = GetScanChunkSize(settings);
+        // Verification reads whole 16-byte lanes past the last member.
+        ScanBuffer buffer(chunkSize + group.span + 16, settings);
+        // Anchor hits start at most one per stride inside the chunk.
+        ScanBuffer offsetBuffer((chunkSize / stride + 1) * sizeof(uint32_t), settings);
+        uint32_t* offsets = reinterpret_cast<uint32_t*>(offsetBuffer.data());
+
+        ScanChunk chunk;
+        while (!g_cancelScan && data->queue->next(data->workerIndex, &chunk)) {
+            SIZE_T bytesToRead = chunk.size + std::min((SIZE_T)(group.span - 1),
+                                                       (SIZE_T)(chunk.regionEnd - chunk.address - chunk.size));
+            SIZE_T actualRead = 0;
+            memory->read(chunk.address, buffer.data(), bytesToRead, &actualRead);
+
+            if (actualRead > first && anchorRel + chunk.size > first) {
+                size_t count = FindValueOffsets(buffer.data() + first, actualRead - first,
+                                                anchorRel + chunk.size - first, anchor.value, anchor.type,
+                                                stride, epsilon, offsets, kernelLevel);
+                for (size_t h = 0; h < count; h++) {
+                    size_t start = first + offsets[h] - anchorRel;
+                    if (start + group.span > actualRead ||
+                        !GroupVerify(group, buffer.data() + start, actualRead - start, epsilon)) {
+                        continue;
+                    }
+                    if ((*data->matchCount)++ >= GROUP_SCAN_MAX_MATCHES) {
+                        break;
+                    }
+                    shard.push_back(chunk.address + start - group.minOffset);
+                    g_matchesFound++;
+                }
+            }
+
+            g_bytesScanned += std::min(actualRead, chunk.size);
+            if (--data->regionChunksLeft[chunk.regionIndex] == 0) {
+                g_regionsScanned++;
+                if (g_totalRegionsToScan > 0) {
+                    g_scanProgress = (double)g_regionsScanned / g_totalRegionsToScan;
+                }
+            }
+        }
+
+    } catch (const std::exception& e) {
+        LOG_ERROR("Thread %lu error: %s", threadId, e.what());
+    }
+
+    LOG_DEBUG("Thread %lu: Found %zu group matches", threadId, shard.size());
+    return 0;
+}
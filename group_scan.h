@@ -0,0 +1,63 @@
+#pragma once
+
+#include "platform.h"
+#include <stdint.h>
+#include <vector>
+
+#include "scan_engine.h"
+
+// Group scan: finds structs whose members hold known values at fixed
+// offsets from each other, e.g. health and max health 4 bytes apart. The
+// rarest member is searched with the regular kernels (FindValueOffsets);
+// each hit is then checked in the same buffer against a masked image of
+// the whole group, 16 bytes per compare, with float and double members
+// rechecked within the usual tolerance. Only the group's base address is
+// reported.
+
+const size_t MAX_GROUP_MEMBERS = 32;
+const size_t MAX_GROUP_SPAN = 4096;
+const size_t GROUP_SCAN_MAX_MATCHES = 1000000;
+
+typedef struct {
+    ValueType type;
+    ScanValue value;
+    int offset;             // From the group base, may be negative
+    bool wildcard;          // Any value; only reserves the member's bytes
+} GroupMember;
+
+// Exact members become bytes under a 0xFF mask; wildcards and the
+// tolerance-compared float/double members stay masked out. bytes and mask
+// are zero-padded to a multiple of 16.
+typedef struct {
+    std::vector<GroupMember> members;
+    int minOffset;                  // Lowest member offset
+    size_t span;                    // Bytes from minOffset to the end of the last member
+    size_t anchor;                  // Member searched first
+    std::vector<BYTE> bytes;
+    std::vector<BYTE> mask;
+    std::vector<size_t> approx;     // Float/double members checked one by one
+} ScanGroup;
+
+typedef struct {
+    ProcessInfo* process;
+    const ScanGroup* group;
+    std::atomic<size_t>* matchCount;
+    std::vector<uintptr_t>* shard;
+    WorkStealingQueue<ScanChunk>* queue;
+    int workerIndex;
+    std::atomic<size_t>* regionChunksLeft;
+} GroupScanThreadData;
+
+// Parses "int:100@0,int:100@4,float:?@8": comma separated members written
+// as [type:]value[@offset], where ? matches any value and a missing offset
+// places the member right after the previous one. Members without a type
+// use defaultType; auto is not allowed. Fails on overlapping members.
+bool parseScanGroup(const char* text, ValueType defaultType, ScanGroup* group);
+
+// Scans the same regions as scanMemory. bases come back sorted.
+size_t scanMemoryGroup(ProcessInfo* process, const ScanGroup& group, std::vector<uintptr_t>& bases);
+
+// Writes address lines to filename (stdout when nullptr).
+bool writeGroupMatches(const char* filename, const std::vector<uintptr_t>& bases);
+
+unsigned __stdcall groupScanThreadFunc(void* arg);
@@ -1,12 +1,25 @@
 #include "logging.h"
 #include "debug_info.h"
-#include <windows.h>
-#include <psapi.h>
+#include "platform.h"
 #include <sys/stat.h>
-#include <direct.h>
 #include <time.h>
+#include <errno.h>
+#include <stdarg.h>
 #include <sstream>
 
+#ifdef _WIN32
+#include <psapi.h>
+#include <direct.h>
+#else
+static int _mkdir(const char* path) {
+    return mkdir(path, 0755);
+}
+
+static void localtime_s(struct tm* result, const time_t* time) {
+    localtime_r(time, result);
+}
+#endif
+
 Logger::Logger() : logFile(nullptr), enableFileLogging(false), enableConsoleLogging(false), maxEntries(1000) {
 }
 
@@ -53,6 +66,7 @@ void Logger::init(bool enableFileLogging, bool enableConsoleLogging) {
             fprintf(logFile, "=== CEngine Session Log ===\n");
             fprintf(logFile, "Session started: %s\n", asctime(&timeinfo));
             
+#ifdef _WIN32
             SYSTEM_INFO sysInfo;
             GetSystemInfo(&sysInfo);
             
@@ -68,6 +82,17 @@ void Logger::init(bool enableFileLogging, bool enableConsoleLogging) {
                     (float)memInfo.ullTotalPhys / (1024*1024*1024));
             fprintf(logFile, "Available Physical Memory: %.2f GB\n", 
                     (float)memInfo.ullAvailPhys / (1024*1024*1024));
+#else
+            long pageSize = sysconf(_SC_PAGESIZE);
+            
+            fprintf(logFile, "\nSystem Information:\n");
+            fprintf(logFile, "Processor Count: %ld\n", sysconf(_SC_NPROCESSORS_ONLN));
+            fprintf(logFile, "Page Size: %ld\n", pageSize);
+            fprintf(logFile, "Total Physical Memory: %.2f GB\n", 
+                    (float)sysconf(_SC_PHYS_PAGES) * pageSize / (1024*1024*1024));
+            fprintf(logFile, "Available Physical Memory: %.2f GB\n", 
+                    (float)sysconf(_SC_AVPHYS_PAGES) * pageSize / (1024*1024*1024));
+#endif
             fprintf(logFile, "\n=== Session Log Begin ===\n\n");
             
             fflush(logFile);
@@ -119,13 +144,13 @@ void Logger::log(LogLevel level, const char* format, ...) {
     vsnprintf(buffer, sizeof(buffer), format, args);
     va_end(args);
 
-    DWORD threadId = GetCurrentThreadId();
+    unsigned long threadId = (unsigned long)GetCurrentThreadId();
 
     const size_t maxMessageSize = 2048;
     char fullMessage[maxMessageSize];
     int result = snprintf(fullMessage, maxMessageSize, "[%s][%s][%lu] %s\n", 
              timestamp, levelStr, threadId, buffer);
-    if (result < 0 || result >= maxMessageSize) {
+    if (result < 0 || (size_t)result >= maxMessageSize) {
         const char* truncMsg = "... (truncated)";
         size_t truncLen = strlen(truncMsg);
         if (maxMessageSize > truncLen + 1) {
@@ -152,6 +177,7 @@ void Logger::log(LogLevel level, const char* format, ...) {
                 fprintf(logFile, "Last Error: %s\n", g_debugInfo.lastError);
             }
             
+#ifdef _WIN32
             PROCESS_MEMORY_COUNTERS_EX pmc;
             ZeroMemory(&pmc, sizeof(PROCESS_MEMORY_COUNTERS_EX));
             pmc.cb = sizeof(PROCESS_MEMORY_COUNTERS_EX);
@@ -164,6 +190,7 @@ void Logger::log(LogLevel level, const char* format, ...) {
                 fprintf(logFile, "Private Usage: %.2f MB\n", 
                     pmc.PrivateUsage / (1024.0f * 1024.0f));
             }
+#endif
             
             fprintf(logFile, "\n=== End Error Details ===\n\n");
         }
@@ -173,6 +200,7 @@ void Logger::log(LogLevel level, const char* format, ...) {
     }
 
     if (enableConsoleLogging) {
+#ifdef _WIN32
         HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
         WORD color;
         
@@ -189,6 +217,9 @@ void Logger::log(LogLevel level, const char* format, ...) {
         SetConsoleTextAttribute(hConsole, color);
         printf("%s", fullMessage);
         SetConsoleTextAttribute(hConsole, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+#else
+        fputs(fullMessage, stderr);
+#endif
     }
 }
 
@@ -255,7 +286,7 @@ void Logger::logSecurityEvent(const char* format, ...) {
     
     std::string timestamp = getCurrentTimestamp();
     
-    char logLine[4096];
+    char logLine[sizeof(buffer) + 64];
     snprintf(logLine, sizeof(logLine), "[%s] [SECURITY] %s", timestamp.c_str(), buffer);
     
     if (enableFileLogging && logFile) {
@@ -269,7 +300,11 @@ void Logger::logSecurityEvent(const char* format, ...) {
     }
     
     if (enableConsoleLogging) {
+#ifdef _WIN32
         OutputDebugStringA(logLine);
         OutputDebugStringA("\n");
+#else
+        fprintf(stderr, "%s\n", logLine);
+#endif
     }
 }
\ No newline at end of file
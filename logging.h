@@ -1,8 +1,7 @@
 #ifndef LOGGING_H
 #define LOGGING_H
 
-#include <windows.h>
-#include <psapi.h>
+#include "platform.h"
 #include <vector>
 #include <string>
 #include <mutex>
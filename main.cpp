@@ -27,6 +27,14 @@
 #include "log_console.h"
 #include "debug_info.h"
 #include "memory_protection.h"
+#include "memory_source.h"
+#include "region_map.h"
+#include "scan_engine.h"
+#include "value_refresher.h"
+#include "pointer_scan.h"
+#include "pattern_scan.h"
+#include "multi_scan.h"
+#include "group_scan.h"
 
 #define IMGUI_IMPL_WIN32_DISABLE_GAMEPAD
 bool g_firstRun = true;              // First run state
@@ -69,80 +77,42 @@ void CaptureDebugInfo(const char* error) {
 }
 
 
-typedef struct {
-    DWORD processId;
-    HANDLE processHandle;
-    char processName[MAX_PATH];
-    Settings* settings;
-} ProcessInfo;
-
-typedef struct {
-    DWORD address;
-    int value;
-    int originalValue;
-} MemoryEntry;
-
-typedef struct {
-    MemoryEntry* entries;
-    size_t count;
-    size_t capacity;
-} ScanResults;
-
-ScanResults g_scanResults = {nullptr, 0, 0};
-
 ProcessInfo g_currentProcess = {
     0,                  // processId
     NULL,              // processHandle
     "",                // processName
-    &g_settings        // settings pointer
+    &g_settings,       // settings pointer
+    nullptr            // memory source
 };
 
-typedef struct {
-    ProcessInfo* process;
-    int valueToFind;
-    ScanResults* results;
-    Settings* settings;
-    std::vector<MEMORY_BASIC_INFORMATION> regions;
-} ScanThreadData;
-
-typedef enum {
-    VALUE_TYPE_INT,
-    VALUE_TYPE_FLOAT,
-    VALUE_TYPE_DOUBLE,
-    VALUE_TYPE_SHORT,
-    VALUE_TYPE_BYTE,
-    VALUE_TYPE_AUTO
-} ValueType;
-
-
-ValueType currentValueType = VALUE_TYPE_INT;
-
 const char* valueTypeNames[] = {
     "Integer (4 bytes)",
     "Float (4 bytes)",
     "Double (8 bytes)",
     "Short (2 bytes)",
     "Byte (1 byte)",
-    "Auto-detect"
+    "Auto-detect",
+    "Int64 (8 bytes)",
+    "UInt16 (2 bytes)",
+    "UInt32 (4 bytes)",
+    "UInt64 (8 bytes)"
 };
 
 bool showProcessList = false;
 bool showMemoryRegions = false;
 bool showProcessDetails = false;
 bool showScanStats = false;
-int valueToFind = 0;
+char valueToFind[64] = "0";
 char searchBuffer[256] = "";
-char g_addressInput[16] = "";
+char g_addressInput[20] = "";
+ValueRefresher g_valueRefresher;
 
 const SIZE_T CHUNK_SIZE = 4096;
 const DWORD MAX_THREAD_RUNTIME = 60000;
 const DWORD WATCHDOG_CHECK_INTERVAL = 10000;
 const DWORD GRACE_PERIOD = 15000;
-const SIZE_T SCAN_CHUNK_SIZE = 1024 * 1024;
-const DWORD SCAN_BATCH_SIZE = 1000;
 const DWORD THREAD_TIMEOUT = 15000;
 const DWORD PROGRESS_UPDATE_INTERVAL = 100; 
-const size_t INITIAL_RESULTS_CAPACITY = 1024;
 
 
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -153,51 +123,21 @@ bool saveSettings(const Settings* settings, const char* filename);
 
 void listProcesses(ImGuiTableFlags flags);
 bool attachToProcess(ProcessInfo* process, DWORD processId);
-void scanMemory(ProcessInfo* process, int valueToFind);
-void updateMemoryValue(ProcessInfo* process, DWORD address, int newValue);
 void displayMemoryRegions(ProcessInfo* process, ImGuiTableFlags flags);
 void DisplayScanResults(ImGuiTableFlags flags);
-void initScanResults(ScanResults* results);
-void optimizeScanResults(ScanResults* results);
-bool addScanResult(ScanResults* results, DWORD address, int value);
-void freeScanResults(ScanResults* results);
-void narrowResults(ProcessInfo* process, ScanResults* results, int newValue);
-void ShowStatusMessage(const char* message);
-void ShowFormattedStatusMessage(const char* format, ...);
+void DisplaySearchResultRow(size_t index);
 void UpdateResultsDisplay();
-int GetValueTypeSize(ValueType type);
-bool ValueMatches(const BYTE* buffer, int valueToFind, ValueType type);
-void SaveBatchResults(ScanResults* results, std::vector<std::pair<DWORD, int>>& batch);
-unsigned __stdcall scanMemoryThreadFunc(void* arg);
+bool parseValueInput(const char* text, ScanValue* value);
 void ShowWelcomeGuide();
 void ShowScanProgressDialog();
 
-template<typename T>
-T min_val(T a, T b) {
-    return (a < b) ? a : b;
-}
-
-SIZE_T min_val(SIZE_T a, DWORD b) {
-    return (a < static_cast<SIZE_T>(b)) ? a : static_cast<SIZE_T>(b);
-}
-
-int newValue = 0;
-DWORD addressToModify = 0; //
-std::atomic<bool> g_cancelScan{false};
-double g_scanProgress = 0.0;
-size_t g_totalRegionsToScan = 0;
+char newValue[64] = "0";
+char highValue[64] = "0";
+uintptr_t addressToModify = 0; //
 std::atomic<bool> g_threadSignal{true};
-std::atomic<bool> g_scanInProgress{false};
-std::atomic<size_t> g_regionsScanned{0};
-std::atomic<size_t> g_matchesFound{0};
-std::atomic<size_t> g_bytesScanned{0};
-std::atomic<size_t> g_regionsSkipped{0};
-std::atomic<bool> g_resultsUpdated{false};
-std::atomic<size_t> g_totalMemoryToScan{0};
 float g_scanSpeed = 0.0f;
 
 LogConsole g_logConsole;
-std::mutex scanResultsMutex;
 
 ID3D11Device* g_pd3dDevice = NULL;
 ID3D11DeviceContext* g_pd3dDeviceContext = NULL;
@@ -216,8 +156,9 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
         LOG_WARNING("Using default settings - no saved settings found");
     }
     
-    initScanResults(&g_scanResults);
+    initScanResults(&g_scanResults, currentValueType);
     g_currentProcess.settings = &g_settings;
+    startValueRefresher(&g_valueRefresher, &g_settings);
 
     WNDCLASSEX wc = { 
         sizeof(WNDCLASSEX), 
@@ -293,6 +234,7 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 
     Logger::getInstance().init(g_settings.enableLogging, true);
     LOG_INFO("CEngine started");
+    LOG_INFO("Scan kernels: %s", GetScanKernelName(GetScanKernelLevel()));
 
     bool done = false;
     static bool firstRun = true;
@@ -417,7 +359,7 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
         ImGui::Separator();
         ImGui::Text("Memory Operations");
         
-        ImGui::InputInt("Value to Find", &valueToFind);
+        ImGui::InputText("Value to Find", valueToFind, sizeof(valueToFind));
         
         if (ImGui::BeginCombo("Value Type", valueTypeNames[currentValueType])) {
             for (int i = 0; i < IM_ARRAYSIZE(valueTypeNames); i++) {
@@ -433,20 +375,92 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
             ImGui::EndCombo();
         }
 
+        static const ScanCompareType firstScanCompares[] = {
+            SCAN_COMPARE_EXACT, SCAN_COMPARE_GREATER, SCAN_COMPARE_LESS, SCAN_COMPARE_BETWEEN
+        };
+        static int firstScanCompare = 0;
+        if (ImGui::BeginCombo("Scan Type", GetScanCompareName(firstScanCompares[firstScanCompare]))) {
+            for (int i = 0; i < IM_ARRAYSIZE(firstScanCompares); i++) {
+                bool isSelected = (firstScanCompare == i);
+                if (ImGui::Selectable(GetScanCompareName(firstScanCompares[i]), isSelected)) {
+                    firstScanCompare = i;
+                }
+                if (isSelected) {
+                    ImGui::SetItemDefaultFocus();
+                }
+            }
+            ImGui::EndCombo();
+        }
+        bool firstScanBetween = firstScanCompares[firstScanCompare] == SCAN_COMPARE_BETWEEN;
+
         if (ImGui::Button("Scan for Value")) {
             if (g_currentProcess.processHandle) {
-                freeScanResults(&g_scanResults);
-                scanMemory(&g_currentProcess, valueToFind);
+                ScanValue value;
+                ScanValue high;
+                if (parseValueInput(valueToFind, &value) &&
+                    (!firstScanBetween || parseValueInput(highValue, &high))) {
+                    freeScanResults(&g_scanResults);
+                    scanMemory(&g_currentProcess, value, firstScanCompares[firstScanCompare], high);
+                }
+            }
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Unknown Initial Value")) {
+            if (g_currentProcess.processHandle) {
+                scanUnknownInitialValue(&g_currentProcess);
             }
         }
         
-        ImGui::InputInt("New Value for Filtering", &newValue);
+        ImGui::InputText("New Value for Filtering", newValue, sizeof(newValue));
         
         if (ImGui::Button("Narrow Results")) {
-            if (g_currentProcess.processHandle && g_scanResults.count > 0) {
-                narrowResults(&g_currentProcess, &g_scanResults, newValue);
+            ScanValue value;
+            if (g_currentProcess.processHandle && g_scanResults.count > 0 && parseValueInput(newValue, &value)) {
+                narrowResults(&g_currentProcess, &g_scanResults, value);
             }
         }
+
+        static int nextScanCompare = SCAN_COMPARE_CHANGED;
+        if (ImGui::BeginCombo("Compare", GetScanCompareName((ScanCompareType)nextScanCompare))) {
+            for (int i = SCAN_COMPARE_EXACT; i <= SCAN_COMPARE_BETWEEN; i++) {
+                bool isSelected = (nextScanCompare == i);
+                if (ImGui::Selectable(GetScanCompareName((ScanCompareType)i), isSelected)) {
+                    nextScanCompare = i;
+                }
+                if (isSelected) {
+                    ImGui::SetItemDefaultFocus();
+                }
+            }
+            ImGui::EndCombo();
+        }
+        if (firstScanBetween || nextScanCompare == SCAN_COMPARE_BETWEEN) {
+            ImGui::InputText("High Value", highValue, sizeof(highValue));
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Upper bound for between scans; the lower bound is the value above");
+            }
+        }
+        if (ImGui::Button("Next Scan")) {
+            if (g_currentProcess.processHandle &&
+                (g_scanResults.count > 0 || hasMemorySnapshot(&g_memorySnapshot))) {
+                // Changed/unchanged/increased/decreased ignore the value;
+                // between also takes the high value.
+                ScanValue value = MakeScanValue(0);
+                ScanValue high;
+                bool usesValue = IsValueCompare((ScanCompareType)nextScanCompare) ||
+                                 nextScanCompare == SCAN_COMPARE_INCREASED_BY ||
+                                 nextScanCompare == SCAN_COMPARE_DECREASED_BY;
+                if ((!usesValue || parseValueInput(newValue, &value)) &&
+                    (nextScanCompare != SCAN_COMPARE_BETWEEN || parseValueInput(highValue, &high))) {
+                    nextScan(&g_currentProcess, (ScanCompareType)nextScanCompare, value, high);
+                }
+            }
+        }
+        if (hasMemorySnapshot(&g_memorySnapshot)) {
+            ImGui::Text("Snapshot: %zu MB captured, %zu MB in memory, %llu MB on disk",
+                        g_memorySnapshot.capturedBytes / (1024 * 1024),
+                        g_memorySnapshot.memoryBytes / (1024 * 1024),
+                        (unsigned long long)(g_memorySnapshot.spillBytes / (1024 * 1024)));
+        }
         
         ImGui::Separator();
         ImGui::Text("Memory Modification");
@@ -456,15 +470,136 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 
         if (ImGui::Button("Write Memory")) {
             if (g_currentProcess.processHandle) {
-                DWORD addr;
-                if (sscanf(g_addressInput, "%x", &addr) == 1) {
-                    updateMemoryValue(&g_currentProcess, addr, newValue);
-                } else {
+                unsigned long long addr;
+                ScanValue value;
+                if (sscanf(g_addressInput, "%llx", &addr) != 1) {
                     ShowStatusMessage("Invalid address format");
+                } else if (parseValueInput(newValue, &value)) {
+                    updateMemoryValue(&g_currentProcess, (uintptr_t)addr, value);
                 }
             }
         }
         
+        if (g_settings.detectPointerChains) {
+            if (ImGui::Button("Pointer Scan")) {
+                unsigned long long addr;
+                if (!g_currentProcess.processHandle) {
+                    ShowStatusMessage("No process attached");
+                } else if (sscanf(g_addressInput, "%llx", &addr) == 1) {
+                    pointerScan(&g_currentProcess, (uintptr_t)addr, "pointer_paths.txt", "pointer_map.cepm");
+                } else {
+                    ShowStatusMessage("Invalid address format");
+                }
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Writes static pointer paths to the address above into pointer_paths.txt and saves the pointer map to pointer_map.cepm");
+            }
+        }
+
+        if (g_settings.useBytePatternScanning) {
+            static char signatureInput[512] = "";
+            static std::vector<PatternMatch> signatureMatches;
+            static std::vector<ModuleInfo> signatureModules;
+
+            ImGui::InputText("Signature", signatureInput, sizeof(signatureInput));
+            if (ImGui::Button("Signature Scan")) {
+                BytePattern pattern;
+                if (!g_currentProcess.processHandle) {
+                    ShowStatusMessage("No process attached");
+                } else if (compileBytePattern(signatureInput, &pattern)) {
+                    std::vector<BytePattern> patterns(1, pattern);
+                    scanBytePatterns(&g_currentProcess, patterns, true, signatureMatches, signatureModules);
+                    ShowFormattedStatusMessage("Signature found at %zu addresses", signatureMatches.size());
+                } else {
+                    ShowStatusMessage("Invalid signature");
+                }
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Searches module code for the bytes above; ?? matches any byte, 4? any low nibble");
+            }
+
+            // Selecting a match copies its address to the field above.
+            for (size_t i = 0; i < signatureMatches.size() && i < 32; i++) {
+                const PatternMatch& match = signatureMatches[i];
+                char label[320];
+                if (match.module != (size_t)-1) {
+                    snprintf(label, sizeof(label), "%llX  %s+0x%llX", (unsigned long long)match.address,
+                             signatureModules[match.module].name,
+                             (unsigned long long)(match.address - signatureModules[match.module].base));
+                } else {
+                    snprintf(label, sizeof(label), "%llX", (unsigned long long)match.address);
+                }
+                if (ImGui::Selectable(label)) {
+                    snprintf(g_addressInput, sizeof(g_addressInput), "%llX", (unsigned long long)match.address);
+                }
+            }
+        }
+
+        if (g_settings.enableMultiScan) {
+            static char multiValueInput[512] = "";
+            static std::vector<ScanTarget> multiTargets;
+            static std::vector<MultiScanMatch> multiMatches;
+
+            ImGui::InputText("Values", multiValueInput, sizeof(multiValueInput));
+            if (ImGui::Button("Multi Scan")) {
+                std::vector<ScanTarget> targets;
+                if (!g_currentProcess.processHandle) {
+                    ShowStatusMessage("No process attached");
+                } else if (parseScanTargets(multiValueInput, currentValueType, targets)) {
+                    multiTargets = targets;
+                    scanMultipleValues(&g_currentProcess, multiTargets, multiMatches);
+                    ShowFormattedStatusMessage("Found %zu matches for %zu values", multiMatches.size(), multiTargets.size());
+                } else {
+                    ShowStatusMessage("Invalid value list");
+                }
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Finds every value in one pass, e.g. 100,250,float:3; values without a type use the type above");
+            }
+
+            for (size_t i = 0; i < multiMatches.size() && i < 32; i++) {
+                const MultiScanMatch& match = multiMatches[i];
+                const ScanTarget& target = multiTargets[match.target];
+                BYTE bytes[sizeof(uint64_t)];
+                char value[32];
+                FormatScanValue(bytes, EncodeScanValue(target.value, target.type, bytes), target.type,
+                                value, sizeof(value));
+                char label[128];
+                snprintf(label, sizeof(label), "%llX  %s %s##multi%zu", (unsigned long long)match.address,
+                         GetValueTypeName(target.type), value, i);
+                if (ImGui::Selectable(label)) {
+                    snprintf(g_addressInput, sizeof(g_addressInput), "%llX", (unsigned long long)match.address);
+                }
+            }
+
+            static char groupInput[512] = "";
+            static std::vector<uintptr_t> groupBases;
+
+            ImGui::InputText("Group", groupInput, sizeof(groupInput));
+            if (ImGui::Button("Group Scan")) {
+                ScanGroup group;
+                if (!g_currentProcess.processHandle) {
+                    ShowStatusMessage("No process attached");
+                } else if (parseScanGroup(groupInput, currentValueType, &group)) {
+                    scanMemoryGroup(&g_currentProcess, group, groupBases);
+                    ShowFormattedStatusMessage("Found %zu matching structs", groupBases.size());
+                } else {
+                    ShowStatusMessage("Invalid group");
+                }
+            }
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Finds structs holding every value at its offset, e.g. 100,100@4,float:?@8; ? matches anything");
+            }
+
+            for (size_t i = 0; i < groupBases.size() && i < 32; i++) {
+                char label[64];
+                snprintf(label, sizeof(label), "%llX##group%zu", (unsigned long long)groupBases[i], i);
+                if (ImGui::Selectable(label)) {
+                    snprintf(g_addressInput, sizeof(g_addressInput), "%llX", (unsigned long long)groupBases[i]);
+                }
+            }
+        }
+
         if (ImGui::Button("View Memory Regions")) {
             showMemoryRegions = true;
         }
@@ -490,6 +625,7 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
         ImGui::SameLine();
         if (ImGui::Button("Clear Results")) {
             freeScanResults(&g_scanResults);
+            freeMemorySnapshot(&g_memorySnapshot);
             g_resultsUpdated = true;
         }
         
@@ -511,29 +647,21 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
                 ImGui::TableSetupColumn("Original Value");
                 ImGui::TableHeadersRow();
                 
-                for (size_t i = 0; i < g_scanResults.count; i++) {
-                    char addressStr[20];
-                    sprintf_s(addressStr, sizeof(addressStr), "0x%08X", g_scanResults.entries[i].address);
-                    
-                    if (searchBuffer[0] != '\0') {
-                        char valueStr[20];
-                        sprintf_s(valueStr, sizeof(valueStr), "%d", g_scanResults.entries[i].value);
-                        if (strstr(addressStr, searchBuffer) == NULL && 
-                            strstr(valueStr, searchBuffer) == NULL) {
-                            continue;
+                // Without a search every row is shown, so only the visible
+                // ones need to be laid out.
+                if (searchBuffer[0] == '\0') {
+                    ImGuiListClipper clipper;
+                    clipper.Begin((int)std::min(g_scanResults.count, (size_t)std::numeric_limits<int>::max()));
+                    while (clipper.Step()) {
+                        for (size_t i = (size_t)clipper.DisplayStart; i < (size_t)clipper.DisplayEnd; i++) {
+                            DisplaySearchResultRow(i);
                         }
                     }
-                    
-                    ImGui::TableNextRow();
-                    ImGui::TableSetColumnIndex(0);
-                    if (ImGui::Selectable(addressStr, false, ImGuiSelectableFlags_SpanAllColumns)) {
-                        addressToModify = g_scanResults.entries[i].address;
-                        newValue = g_scanResults.entries[i].value;
+                    clipper.End();
+                } else {
+                    for (size_t i = 0; i < g_scanResults.count; i++) {
+                        DisplaySearchResultRow(i);
                     }
-                    ImGui::TableSetColumnIndex(1);
-                    ImGui::Text("%d", g_scanResults.entries[i].value);
-                    ImGui::TableSetColumnIndex(2);
-                    ImGui::Text("%d", g_scanResults.entries[i].originalValue);
                 }
                 ImGui::EndTable();
             }
@@ -634,6 +762,9 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
     }
 
     try {
+        stopValueRefresher(&g_valueRefresher);
+        delete g_currentProcess.memory;
+        g_currentProcess.memory = nullptr;
         if (g_currentProcess.processHandle) {
             CloseHandle(g_currentProcess.processHandle);
             g_currentProcess.processHandle = NULL;
@@ -907,6 +1038,9 @@ bool attachToProcess(ProcessInfo* process, DWORD processId) {
     }
     
     if (process->processHandle) {
+        setValueRefresherSource(&g_valueRefresher, nullptr);
+        delete process->memory;
+        process->memory = nullptr;
         CloseHandle(process->processHandle);
         process->processHandle = NULL;
         process->processId = 0;
@@ -1026,579 +1160,21 @@ bool attachToProcess(ProcessInfo* process, DWORD processId) {
         }
     }
     
+    process->memory = CreateRegionMapSource(CreateMemorySourceFromHandle(process->processHandle, processId),
+                                            &g_settings);
+    if (!process->memory) {
+        LOG_ERROR("Failed to create memory source for process %lu", processId);
+        CloseHandle(process->processHandle);
+        process->processHandle = NULL;
+        return FALSE;
+    }
+    setValueRefresherSource(&g_valueRefresher, process->memory);
+    
     LOG_INFO("Successfully attached to process %s (PID: %lu)", 
             process->processName, process->processId);
     return TRUE;
 }
 
-void initScanResults(ScanResults* results) {
-    results->entries = NULL;
-    results->count = 0;
-    results->capacity = 0;
-}
-
-void optimizeScanResults(ScanResults* results) {
-    std::lock_guard<std::mutex> lock(scanResultsMutex);
-    
-    if (results->count < results->capacity / 2 && results->count > 0) {
-        size_t newCapacity = (1024 > results->count * 2) ? 1024 : results->count * 2;
-        
-        if (newCapacity == 0) newCapacity = 1024;
-        
-        MemoryEntry* newEntries = (MemoryEntry*)realloc(
-            results->entries, newCapacity * sizeof(MemoryEntry));
-            
-        if (newEntries) {
-            results->entries = newEntries;
-            results->capacity = newCapacity;
-            LOG_DEBUG("Optimized results: new capacity %zu", newCapacity);
-        }
-        else {
-            LOG_WARNING("Failed to reallocate memory during results optimization");
-        }
-    }
-}
-
-bool addScanResult(ScanResults* results, DWORD address, int value) {
-    if (!results->entries) {
-        results->entries = (MemoryEntry*)malloc(INITIAL_RESULTS_CAPACITY * sizeof(MemoryEntry));
-        if (!results->entries) {
-            LOG_ERROR("Failed to initialize results array");
-            return false;
-        }
-        results->capacity = INITIAL_RESULTS_CAPACITY;
-        results->count = 0;
-        LOG_DEBUG("Initialized results array with capacity %zu", results->capacity);
-    }
-    
-    if (results->count >= results->capacity) {
-        size_t newCapacity = results->capacity * 2;
-        MemoryEntry* newEntries = (MemoryEntry*)realloc(results->entries, 
-                                                       newCapacity * sizeof(MemoryEntry));
-        if (!newEntries) {
-            LOG_ERROR("Failed to expand results array");
-            return false;
-        }
-        results->entries = newEntries;
-        results->capacity = newCapacity;
-        LOG_DEBUG("Expanded results array to capacity %zu", newCapacity);
-    }
-
-    results->entries[results->count].address = address;
-    results->entries[results->count].value = value;
-    results->entries[results->count].originalValue = value;
-    results->count++;
-    
-    LOG_DEBUG("Added result: Address=0x%08X Value=%d (Total: %zu)", 
-              address, value, results->count);
-    return true;
-}
-
-void freeScanResults(ScanResults* results) {
-    if (results->entries) {
-        free(results->entries);
-        results->entries = NULL;
-    }
-    results->count = 0;
-    results->capacity = 0;
-}
-
-std::atomic<bool> g_threadAlive{true};
-const DWORD THREAD_CHECK_INTERVAL = 500; // milliseconds
-
-int GetValueTypeSize(ValueType type) {
-    switch (type) {
-        case VALUE_TYPE_INT: return sizeof(int);
-        case VALUE_TYPE_FLOAT: return sizeof(float);
-        case VALUE_TYPE_DOUBLE: return sizeof(double);
-        case VALUE_TYPE_SHORT: return sizeof(short);
-        case VALUE_TYPE_BYTE: return sizeof(char);
-        case VALUE_TYPE_AUTO: return sizeof(int);
-    }
-    return sizeof(int);
-}
-
-bool ValueMatches(const BYTE* buffer, int valueToFind, ValueType type) {
-    switch (type) {
-        case VALUE_TYPE_AUTO: {
-            int ivalue;
-            float fvalue;
-            double dvalue;
-            short svalue;
-            unsigned char bvalue;
-            
-            memcpy(&ivalue, buffer, sizeof(int));
-            if (ivalue == valueToFind) return true;
-            
-            memcpy(&fvalue, buffer, sizeof(float));
-            if (!std::isnan(fvalue) && !std::isinf(fvalue) && 
-                std::abs(fvalue - (float)valueToFind) < 0.0001f) {
-                uint32_t bits;
-                memcpy(&bits, &fvalue, sizeof(bits));
-                uint32_t exp = (bits >> 23) & 0xFF;
-                if (exp != 0 && exp != 0xFF);
-            }
-            
-            memcpy(&dvalue, buffer, sizeof(double));
-            if (!std::isnan(dvalue) && !std::isinf(dvalue) && 
-                std::abs(dvalue - (double)valueToFind) < 0.0001) {
-                uint64_t bits;
-                memcpy(&bits, &dvalue, sizeof(bits));
-                uint64_t exp = (bits >> 52) & 0x7FF;
-                if (exp != 0 && exp != 0x7FF)
-                    return true;
-            }
-            
-            memcpy(&svalue, buffer, sizeof(short));
-            if (svalue == (short)valueToFind) return true;
-            
-            memcpy(&bvalue, buffer, sizeof(unsigned char));
-            if (bvalue == (unsigned char)valueToFind) return true;
-            
-            return false;
-        }
-            
-        case VALUE_TYPE_INT: {
-            int value;
-            memcpy(&value, buffer, sizeof(int));
-            return value == valueToFind;
-        }
-            
-        case VALUE_TYPE_FLOAT: {
-            float fvalue;
-            memcpy(&fvalue, buffer, sizeof(float));
-            if (std::isnan(fvalue) || std::isinf(fvalue)) 
-                return false;
-            return std::abs(fvalue - (float)valueToFind) < 0.0001f;
-        }
-            
-        case VALUE_TYPE_DOUBLE: {
-            double dvalue;
-            memcpy(&dvalue, buffer, sizeof(double));
-            if (std::isnan(dvalue) || std::isinf(dvalue))
-                return false;
-            return std::abs(dvalue - (double)valueToFind) < 0.0001;
-        }
-            
-        case VALUE_TYPE_SHORT: {
-            short value;
-            memcpy(&value, buffer, sizeof(short));
-            return value == (short)valueToFind;
-        }
-            
-        case VALUE_TYPE_BYTE: {
-            unsigned char value;
-            memcpy(&value, buffer, sizeof(unsigned char));
-            return value == (unsigned char)valueToFind;
-        }
-    }
-    return false;
-}
-
-bool VectorizedValueMatch(const BYTE* buffer, int valueToFind, ValueType type, SIZE_T bufferSize) {
-    if (type == VALUE_TYPE_INT && bufferSize >= 16) {
-        __m128i searchValue = _mm_set1_epi32(valueToFind);
-        
-        for (SIZE_T i = 0; i <= bufferSize - 16; i += 16) {
-            __m128i data = _mm_loadu_si128((__m128i*)&buffer[i]);
-            __m128i cmp = _mm_cmpeq_epi32(data, searchValue);
-            
-            int mask = _mm_movemask_epi8(cmp);
-            if (mask != 0) {
-                for (int j = 0; j < 4; j++) {
-                    int value;
-                    memcpy(&value, &buffer[i + j * sizeof(int)], sizeof(int));
-                    if (value == valueToFind) {
-                        return true;
-                    }
-                }
-            }
-        }
-    }
-    
-    int typeSize = GetValueTypeSize(type);
-    for (SIZE_T i = 0; i <= bufferSize - typeSize; i++) {
-        if (ValueMatches(&buffer[i], valueToFind, type)) {
-            return true;
-        }
-    }
-    
-    return false;
-}
-
-bool IsLikelyValidDataRegion(const MEMORY_BASIC_INFORMATION& mbi, bool isSearchingForZero) {
-    if (mbi.RegionSize < 4096)
-        return false;
-    if (mbi.State != MEM_COMMIT)
-        return false;
-    if (!(mbi.Protect & (PAGE_READONLY | PAGE_READWRITE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE)))
-        return false;
-    if (mbi.Protect & (PAGE_GUARD | PAGE_NOACCESS))
-        return false;
-        
-    if (isSearchingForZero) {
-        if (mbi.Type == MEM_MAPPED)
-            return false;           
-        if (mbi.Type != MEM_PRIVATE)
-            return false;
-    }
-    
-    return true;
-}
-
-void validateScanResults() {
-    LOG_DEBUG("Validating scan results...");
-    if (!g_scanResults.entries && g_scanResults.count > 0) {
-        LOG_ERROR("Invalid scan results: null entries but count > 0");
-        g_scanResults.count = 0;
-        return;
-    }
-    
-    if (g_scanResults.entries) {
-        LOG_DEBUG("Scan results: %zu entries, capacity %zu", 
-                 g_scanResults.count, g_scanResults.capacity);
-        if (g_scanResults.count > 0) {
-            LOG_DEBUG("First entry: 0x%08X = %d", 
-                     g_scanResults.entries[0].address,
-                     g_scanResults.entries[0].value);
-            LOG_DEBUG("Last entry: 0x%08X = %d",
-                     g_scanResults.entries[g_scanResults.count-1].address,
-                     g_scanResults.entries[g_scanResults.count-1].value);
-        }    
-    }
-}
-
-bool IsReadableMemory(HANDLE processHandle, LPCVOID address, SIZE_T size) {
-    MEMORY_BASIC_INFORMATION mbi;
-    if (VirtualQueryEx(processHandle, address, &mbi, sizeof(mbi)) == 0) {
-        return false;
-    }
-
-    return (mbi.State == MEM_COMMIT) && 
-           (mbi.Protect & (PAGE_READONLY | PAGE_READWRITE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE)) &&
-           !(mbi.Protect & (PAGE_GUARD | PAGE_NOACCESS));
-}
-
-bool SafeReadMemory(HANDLE processHandle, LPCVOID address, LPVOID buffer, SIZE_T size, SIZE_T* bytesRead) {
-    *bytesRead = 0;
-    if (!IsReadableMemory(processHandle, address, size)) {
-        return false;
-    }
-    return ReadProcessMemory(processHandle, address, buffer, size, bytesRead);
-}
-
-void scanMemory(ProcessInfo* process, int valueToFind) {
-    if (!process || !process->processHandle) {
-        LOG_ERROR("Invalid process handle");
-        ShowStatusMessage("Invalid process handle");
-        return;
-    }
-
-    freeScanResults(&g_scanResults);
-    initScanResults(&g_scanResults);
-
-    g_cancelScan = false;
-    g_scanInProgress = true;
-    g_regionsScanned = 0;
-    g_bytesScanned = 0;
-    g_matchesFound = 0;
-
-    SYSTEM_INFO sysInfo;
-    GetSystemInfo(&sysInfo);
-    LPVOID address = sysInfo.lpMinimumApplicationAddress;
-    
-    std::vector<MEMORY_BASIC_INFORMATION> regions;
-    
-    while (address < sysInfo.lpMaximumApplicationAddress) {
-        MEMORY_BASIC_INFORMATION mbi;
-        if (VirtualQueryEx(process->processHandle, address, &mbi, sizeof(mbi)) == 0) {
-            break;
-        }
-
-        if (IsLikelyValidDataRegion(mbi, valueToFind == 0)) {
-            regions.push_back(mbi);
-        }
-
-        address = (LPVOID)((DWORD_PTR)mbi.BaseAddress + mbi.RegionSize);
-    }
-
-    g_totalRegionsToScan = regions.size();
-    LOG_INFO("Found %zu memory regions to scan", g_totalRegionsToScan);
-
-    std::vector<BYTE> buffer(SCAN_CHUNK_SIZE);
-    
-    for (const auto& mbi : regions) {
-        if (g_cancelScan) break;
-
-        SIZE_T bytesRead = 0;
-        for (SIZE_T offset = 0; offset < mbi.RegionSize; offset += SCAN_CHUNK_SIZE) {
-            SIZE_T bytesToRead = min_val(SCAN_CHUNK_SIZE, mbi.RegionSize - offset);
-            LPVOID currentAddress = (LPVOID)((DWORD_PTR)mbi.BaseAddress + offset);
-
-            if (SafeReadMemory(process->processHandle, currentAddress, buffer.data(), bytesToRead, &bytesRead)) {
-                for (SIZE_T i = 0; i <= bytesRead - GetValueTypeSize(currentValueType); i++) {
-                    if (ValueMatches(&buffer[i], valueToFind, currentValueType)) {
-                        DWORD resultAddress = (DWORD)((DWORD_PTR)currentAddress + i);
-                        addScanResult(&g_scanResults, resultAddress, valueToFind);
-                    }
-                }
-
-                if (bytesRead >= sizeof(DWORD)) {
-                    for (SIZE_T i = 0; i <= bytesRead - sizeof(DWORD); i += sizeof(DWORD)) {
-                        DWORD pointerValue;
-                        memcpy(&pointerValue, &buffer[i], sizeof(DWORD));
-
-                        DWORD minAppAddr = (DWORD)(DWORD_PTR)sysInfo.lpMinimumApplicationAddress;
-                        DWORD maxAppAddr = (DWORD)(DWORD_PTR)sysInfo.lpMaximumApplicationAddress;
-                        
-                        if (pointerValue > minAppAddr && pointerValue < maxAppAddr) {
-                            
-                            int pointedValue;
-                            SIZE_T pointedBytesRead;
-                            if (SafeReadMemory(process->processHandle, (LPCVOID)(DWORD_PTR)pointerValue, 
-                                            &pointedValue, sizeof(int), &pointedBytesRead) && 
-                                pointedValue == valueToFind) {
-                                    
-                                DWORD pointerAddress = (DWORD)((DWORD_PTR)currentAddress + i);
-                                addScanResult(&g_scanResults, pointerAddress, pointerValue);
-                            }
-                        }
-                    }
-                }
-            }
-
-            g_bytesScanned += bytesRead;
-        }
-
-        g_regionsScanned++;
-        g_scanProgress = (double)g_regionsScanned / g_totalRegionsToScan;
-    }
-
-    g_scanInProgress = false;
-    validateScanResults();
-    
-    size_t resultCount = g_scanResults.count;
-    size_t regionsScannedCount = g_regionsScanned.load();
-    LOG_INFO("Scan completed: Found %zu matches in %zu regions", 
-             resultCount, regionsScannedCount);
-    
-    ShowFormattedStatusMessage("Found %zu matches", resultCount);
-}
-
-void narrowResults(ProcessInfo* process, ScanResults* results, int newValue) {
-    if (!process || !process->processHandle || results->count == 0) {
-        LOG_WARNING("Cannot narrow results: invalid process or empty results");
-        return;
-    }
-    
-    LOG_INFO("Narrowing results from %zu entries with value %d", results->count, newValue);
-
-    std::unique_ptr<MemoryEntry[]> tempEntries(new (std::nothrow) MemoryEntry[results->count]);
-    if (!tempEntries) {
-        LOG_ERROR("Failed to allocate memory for narrowing results");
-        return;
-    }
-
-    g_cancelScan = false;
-    g_scanInProgress = true;
-    g_regionsScanned = 0;
-    g_totalRegionsToScan = results->count;
-    
-    size_t tempCount = 0;
-    size_t entriesRemoved = 0;
-
-    const DWORD TIMEOUT_MS = 5000; // 5 second timeout
-    const DWORD CHECK_INTERVAL = 100; // Check every 100ms
-    DWORD startTime = GetTickCount();
-
-    const size_t BATCH_SIZE = 500;
-    std::vector<std::pair<DWORD, int>> validResults;
-    validResults.reserve(BATCH_SIZE);
-    
-    for (size_t i = 0; i < results->count && !g_cancelScan; i++) {
-        if ((i % 100) == 0) {
-            DWORD currentTime = GetTickCount();
-            if (currentTime - startTime > TIMEOUT_MS) {
-                LOG_WARNING("Narrowing operation timed out after processing %zu entries", i);
-                ShowStatusMessage("Operation timed out - partial results saved");
-                break;
-            }
-
-            MSG msg;
-            while (PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE)) {
-                TranslateMessage(&msg);
-                DispatchMessage(&msg);
-            }
-            
-            Sleep(0);
-        }
-        
-        DWORD address = results->entries[i].address;
-        SIZE_T bytesRead = 0;
-        bool valueMatches = false;
-        
-        try {
-            const DWORD READ_TIMEOUT = 50; // 50ms per read
-            DWORD readStart = GetTickCount();
-            
-            switch (currentValueType) {
-                case VALUE_TYPE_INT: {
-                    int value;
-                    if (ReadProcessMemory(process->processHandle, (LPVOID)(uintptr_t)address, 
-                                       &value, sizeof(value), &bytesRead) && 
-                        bytesRead == sizeof(value)) {
-                        valueMatches = (value == newValue);
-                        if (valueMatches) {
-                            validResults.emplace_back(address, value);
-                        }
-                    }
-                    break;
-                }
-            }
-            
-            if (GetTickCount() - readStart > READ_TIMEOUT) {
-                LOG_DEBUG("Slow memory read at address 0x%08X", address);
-            }
-            
-        } catch (const std::exception& e) {
-            LOG_ERROR("Error processing address 0x%08X: %s", address, e.what());
-            continue;
-        }
-
-        if (validResults.size() >= BATCH_SIZE) {
-            std::lock_guard<std::mutex> lock(scanResultsMutex);
-            for (const auto& result : validResults) {
-                tempEntries[tempCount++] = {
-                    result.first,
-                    result.second,
-                    results->entries[i].originalValue
-                };
-            }
-            validResults.clear();
-
-            g_regionsScanned = i;
-            float progress = (float)i / results->count;
-            ShowFormattedStatusMessage("Narrowing results: %.1f%% (Found: %zu)", 
-                            progress * 100.0f, tempCount);
-        }
-    }
-
-    if (!validResults.empty()) {
-        std::lock_guard<std::mutex> lock(scanResultsMutex);
-        size_t currentIndex = g_regionsScanned - validResults.size();
-        for (size_t j = 0; j < validResults.size(); j++) {
-            tempEntries[tempCount++] = {
-                validResults[j].first,
-                validResults[j].second,
-                results->entries[currentIndex + j].originalValue
-            };
-        }
-    }
-
-    {
-        std::lock_guard<std::mutex> lock(scanResultsMutex);
-        if (results->entries) {
-            free(results->entries);
-        }
-        results->entries = (MemoryEntry*)malloc(tempCount * sizeof(MemoryEntry));
-        if (results->entries) {
-            memcpy(results->entries, tempEntries.get(), tempCount * sizeof(MemoryEntry));
-            results->count = tempCount;
-            results->capacity = tempCount;
-        } else {
-            LOG_ERROR("Failed to allocate memory for narrowed results");
-            results->count = 0;
-            results->capacity = 0;
-        }
-    }
-    
-    g_scanInProgress = false;
-    g_resultsUpdated = true;
-    
-    LOG_INFO("Narrowing complete. Removed %zu entries, kept %zu entries.", 
-             results->count - tempCount, tempCount);
-    ShowFormattedStatusMessage("Narrowed to %zu results", tempCount);
-}
-
-void updateMemoryValue(ProcessInfo* process, DWORD address, int newValue) {
-    if (!process || !process->processHandle) {
-        LOG_ERROR("Invalid process for memory write");
-        ShowStatusMessage("Invalid process for memory write");
-        return;
-    }
-
-    HANDLE processHandle = OpenProcess(PROCESS_VM_READ | PROCESS_VM_WRITE | PROCESS_VM_OPERATION, 
-                                     FALSE, process->processId);
-    if (!processHandle) {
-        LOG_ERROR("Failed to open process with write permissions");
-        ShowStatusMessage("Failed to get write permissions");
-        return;
-    }
-
-    MemoryProtectionContext* protContext = CreateProtectionContext(processHandle, 
-        (LPVOID)(uintptr_t)address, sizeof(int));
-
-    bool success = false;
-    
-    MEMORY_BASIC_INFORMATION mbi;
-    bool needProtectionChange = false;
-    
-    if (VirtualQueryEx(processHandle, (LPVOID)(uintptr_t)address, &mbi, sizeof(mbi))) {
-        LOG_DEBUG("Memory at 0x%08X has protection: 0x%X", address, mbi.Protect);
-        
-        if (!(mbi.Protect & PAGE_READWRITE) && 
-            !(mbi.Protect & PAGE_EXECUTE_READWRITE) &&
-            !(mbi.Protect & PAGE_WRITECOPY) &&
-            !(mbi.Protect & PAGE_EXECUTE_WRITECOPY)) {
-            
-            needProtectionChange = true;
-        }
-    }
-    
-    if (needProtectionChange && g_settings.overwriteMemoryProtection) {
-        LOG_DEBUG("Attempting to modify memory protection for address 0x%08X", address);
-        
-        if (!ModifyMemoryProtection(protContext, PAGE_READWRITE)) {
-            LOG_ERROR("Failed to modify memory protection for address 0x%08X", address);
-            ShowFormattedStatusMessage("Failed to modify memory protection for address 0x%08X", address);
-            DestroyProtectionContext(protContext);
-            CloseHandle(processHandle);
-            return;
-        }
-        
-        LOG_DEBUG("Successfully modified memory protection for address 0x%08X", address);
-    }
-
-    SIZE_T bytesWritten;
-    if (WriteProcessMemory(processHandle, (LPVOID)(uintptr_t)address, 
-                          &newValue, sizeof(newValue), &bytesWritten)) {
-        LOG_INFO("Successfully wrote value %d to address 0x%08X", newValue, address);
-        ShowFormattedStatusMessage("Value %d written successfully to 0x%08X", newValue, address);
-        success = true;
-        
-        int verifyValue;
-        SIZE_T verifyBytesRead;
-        if (SafeReadMemoryWithRetry(processHandle, (LPVOID)(uintptr_t)address, 
-                                 &verifyValue, sizeof(verifyValue), &verifyBytesRead, 3)) {
-            if (verifyValue == newValue) {
-                LOG_DEBUG("Write verified successfully: value %d at 0x%08X", verifyValue, address);
-            } else {
-                LOG_WARNING("Write verification failed: expected %d, read %d at 0x%08X", 
-                           newValue, verifyValue, address);
-            }
-        }
-    } else {
-        DWORD error = GetLastError();
-        LOG_ERROR("Failed to write to address 0x%08X (Error: %lu - %s)", 
-                address, error, GetLastErrorAsString(error));
-        ShowFormattedStatusMessage("Failed to write value: %s", GetLastErrorAsString(error));
-    }
-
-    RestoreMemoryProtection(protContext);
-    
-    DestroyProtectionContext(protContext);
-    CloseHandle(processHandle);
-}
 
 void displayMemoryRegions(ProcessInfo* process, ImGuiTableFlags flags) {
     if (!process || !process->processHandle) {
@@ -1636,8 +1212,17 @@ void displayMemoryRegions(ProcessInfo* process, ImGuiTableFlags flags) {
     static char addressSearch[32] = "";
     ImGui::InputText("Search Address", addressSearch, sizeof(addressSearch), ImGuiInputTextFlags_CharsHexadecimal);
     
-    MEMORY_BASIC_INFORMATION mbi;
-    LPVOID address = NULL;
+    ImGui::SameLine();
+    if (ImGui::Button("Refresh Regions") && process->memory) {
+        process->memory->refreshRegions();
+    }
+
+    // Cached by the region map; a frame copies the list instead of walking
+    // the address space.
+    std::vector<MemoryRegion> regions;
+    if (process->memory) {
+        process->memory->enumerateRegions(regions);
+    }
     
     if (ImGui::BeginTable("MemoryRegionsTable", 5, flags, ImVec2(0, 450))) {
         ImGui::TableSetupColumn("Base Address", ImGuiTableColumnFlags_WidthFixed, 100.0f);
@@ -1651,22 +1236,22 @@ void displayMemoryRegions(ProcessInfo* process, ImGuiTableFlags flags) {
         const size_t MAX_REGIONS = 2000; 
         
         try {
-            while (regionsDisplayed < MAX_REGIONS && 
-                  VirtualQueryEx(process->processHandle, address, &mbi, sizeof(mbi))) {
+            for (size_t r = 0; r < regions.size() && regionsDisplayed < MAX_REGIONS; r++) {
+                const MemoryRegion& region = regions[r];
                 
                 bool showRegion = false;
                 
-                if ((mbi.State == MEM_COMMIT && showCommitted) ||
-                    (mbi.State == MEM_FREE && showFree) ||
-                    (mbi.State == MEM_RESERVE && showReserved)) {
+                if ((region.state == MEM_COMMIT && showCommitted) ||
+                    (region.state == MEM_FREE && showFree) ||
+                    (region.state == MEM_RESERVE && showReserved)) {
                     
-                    if (mbi.State != MEM_FREE) {
-                        if ((mbi.Protect & PAGE_READONLY && showReadOnly) ||
-                            ((mbi.Protect & PAGE_READWRITE || mbi.Protect & PAGE_WRITECOPY) && showReadWrite) ||
-                            ((mbi.Protect & PAGE_EXECUTE || mbi.Protect & PAGE_EXECUTE_READ || 
-                              mbi.Protect & PAGE_EXECUTE_READWRITE || mbi.Protect & PAGE_EXECUTE_WRITECOPY) && 
+                    if (region.state != MEM_FREE) {
+                        if ((region.protect & PAGE_READONLY && showReadOnly) ||
+                            ((region.protect & PAGE_READWRITE || region.protect & PAGE_WRITECOPY) && showReadWrite) ||
+                            ((region.protect & PAGE_EXECUTE || region.protect & PAGE_EXECUTE_READ || 
+                              region.protect & PAGE_EXECUTE_READWRITE || region.protect & PAGE_EXECUTE_WRITECOPY) && 
                              showExecutable) ||
-                            ((mbi.Protect & PAGE_GUARD || mbi.Protect & PAGE_NOACCESS) && showProtected)) {
+                            ((region.protect & PAGE_GUARD || region.protect & PAGE_NOACCESS) && showProtected)) {
                             
                             showRegion = true;
                         }
@@ -1678,8 +1263,8 @@ void displayMemoryRegions(ProcessInfo* process, ImGuiTableFlags flags) {
                 if (addressSearch[0] != '\0') {
                     DWORD_PTR searchAddr = 0;
                     if (sscanf(addressSearch, "%lx", &searchAddr) == 1) {
-                        if (!((DWORD_PTR)mbi.BaseAddress <= searchAddr && 
-                              searchAddr < (DWORD_PTR)mbi.BaseAddress + mbi.RegionSize)) {
+                        if (!((DWORD_PTR)region.base <= searchAddr && 
+                              searchAddr < (DWORD_PTR)region.base + region.size)) {
                             showRegion = false;
                         }
                     }
@@ -1690,66 +1275,66 @@ void displayMemoryRegions(ProcessInfo* process, ImGuiTableFlags flags) {
                     
                     ImGui::TableSetColumnIndex(0);
                     char addressStr[32];
-                    snprintf(addressStr, sizeof(addressStr), "0x%p", mbi.BaseAddress);
+                    snprintf(addressStr, sizeof(addressStr), "0x%p", (void*)region.base);
                     ImGui::Text("%s", addressStr);
                     
                     ImGui::TableSetColumnIndex(1);
                     char sizeStr[32];
-                    if (mbi.RegionSize >= 1024*1024) {
-                        snprintf(sizeStr, sizeof(sizeStr), "%.2f MB", (float)mbi.RegionSize / (1024*1024));
-                    } else if (mbi.RegionSize >= 1024) {
-                        snprintf(sizeStr, sizeof(sizeStr), "%.2f KB", (float)mbi.RegionSize / 1024);
+                    if (region.size >= 1024*1024) {
+                        snprintf(sizeStr, sizeof(sizeStr), "%.2f MB", (float)region.size / (1024*1024));
+                    } else if (region.size >= 1024) {
+                        snprintf(sizeStr, sizeof(sizeStr), "%.2f KB", (float)region.size / 1024);
                     } else {
-                        snprintf(sizeStr, sizeof(sizeStr), "%zu B", mbi.RegionSize);
+                        snprintf(sizeStr, sizeof(sizeStr), "%zu B", region.size);
                     }
                     ImGui::Text("%s", sizeStr);
                     
                     ImGui::TableSetColumnIndex(2);
-                    if (mbi.State == MEM_COMMIT) {
+                    if (region.state == MEM_COMMIT) {
                         ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "COMMIT");
                     }
-                    else if (mbi.State == MEM_FREE) {
+                    else if (region.state == MEM_FREE) {
                         ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "FREE");
                     }
-                    else if (mbi.State == MEM_RESERVE) {
+                    else if (region.state == MEM_RESERVE) {
                         ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "RESERVE");
                     }
                     
                     ImGui::TableSetColumnIndex(3);
-                    if (mbi.State != MEM_FREE) {
-                        if (mbi.Protect & PAGE_NOACCESS) {
+                    if (region.state != MEM_FREE) {
+                        if (region.protect & PAGE_NOACCESS) {
                             ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "NOACCESS");
                         }
-                        else if (mbi.Protect & PAGE_READONLY) {
+                        else if (region.protect & PAGE_READONLY) {
                             ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "READONLY");
                         }
-                        else if (mbi.Protect & PAGE_READWRITE) {
+                        else if (region.protect & PAGE_READWRITE) {
                             ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "READWRITE");
                         }
-                        else if (mbi.Protect & PAGE_WRITECOPY) {
+                        else if (region.protect & PAGE_WRITECOPY) {
                             ImGui::TextColored(ImVec4(0.0f, 0.8f, 0.8f, 1.0f), "WRITECOPY");
                         }
-                        else if (mbi.Protect & PAGE_EXECUTE) {
+                        else if (region.protect & PAGE_EXECUTE) {
                             ImGui::TextColored(ImVec4(1.0f, 0.0f, 1.0f, 1.0f), "EXECUTE");
                         }
-                        else if (mbi.Protect & PAGE_EXECUTE_READ) {
+                        else if (region.protect & PAGE_EXECUTE_READ) {
                             ImGui::TextColored(ImVec4(0.8f, 0.0f, 0.8f, 1.0f), "EXEC+READ");
                         }
-                        else if (mbi.Protect & PAGE_EXECUTE_READWRITE) {
+                        else if (region.protect & PAGE_EXECUTE_READWRITE) {
                             ImGui::TextColored(ImVec4(0.0f, 0.8f, 0.0f, 1.0f), "EXEC+RW");
                         }
-                        else if (mbi.Protect & PAGE_EXECUTE_WRITECOPY) {
+                        else if (region.protect & PAGE_EXECUTE_WRITECOPY) {
                             ImGui::TextColored(ImVec4(0.0f, 0.6f, 0.6f, 1.0f), "EXEC+WC");
                         }
                         else {
-                            ImGui::Text("0x%X", mbi.Protect);
+                            ImGui::Text("0x%X", region.protect);
                         }
                         
-                        if (mbi.Protect & PAGE_GUARD) {
+                        if (region.protect & PAGE_GUARD) {
                             ImGui::SameLine();
                             ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "+GUARD");
                         }
-                        if (mbi.Protect & PAGE_NOCACHE) {
+                        if (region.protect & PAGE_NOCACHE) {
                             ImGui::SameLine();
                             ImGui::Text("+NOCACHE");
                         }
@@ -1758,18 +1343,18 @@ void displayMemoryRegions(ProcessInfo* process, ImGuiTableFlags flags) {
                     }
                     
                     ImGui::TableSetColumnIndex(4);
-                    if (mbi.State != MEM_FREE) {
-                        if (mbi.Type == MEM_IMAGE) {
+                    if (region.state != MEM_FREE) {
+                        if (region.type == MEM_IMAGE) {
                             ImGui::Text("IMAGE");
                         }
-                        else if (mbi.Type == MEM_MAPPED) {
+                        else if (region.type == MEM_MAPPED) {
                             ImGui::Text("MAPPED");
                         }
-                        else if (mbi.Type == MEM_PRIVATE) {
+                        else if (region.type == MEM_PRIVATE) {
                             ImGui::Text("PRIVATE");
                         }
                         else {
-                            ImGui::Text("0x%X", mbi.Type);
+                            ImGui::Text("0x%X", region.type);
                         }
                     } else {
                         ImGui::Text("-");
@@ -1777,8 +1362,6 @@ void displayMemoryRegions(ProcessInfo* process, ImGuiTableFlags flags) {
                     
                     regionsDisplayed++;
                 }
-                
-                address = (LPVOID)((DWORD_PTR)mbi.BaseAddress + mbi.RegionSize);
             }
         }
         catch (const std::exception& e) {
@@ -1915,263 +1498,60 @@ void UpdateResultsDisplay() {
     }
 }
 
-inline float GetScanProgress() {
-    return (g_totalRegionsToScan > 0) ? 
-        (float)g_regionsScanned / (float)g_totalRegionsToScan : 0.0f;
-}
-
-
-bool isValidMemoryRegion(HANDLE processHandle, LPVOID address, SIZE_T size) {
-    MEMORY_BASIC_INFORMATION mbi;
-    if (!VirtualQueryEx(processHandle, address, &mbi, sizeof(mbi))) {
-        return false;
-    }
-    
-    if (mbi.State != MEM_COMMIT || 
-        !(mbi.Protect & (PAGE_READONLY | PAGE_READWRITE | PAGE_EXECUTE_READ | 
-                        PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)) || 
-        (mbi.Protect & PAGE_GUARD) || 
-        (mbi.Protect & PAGE_NOACCESS)) {
+bool parseValueInput(const char* text, ScanValue* value) {
+    if (!parseScanValue(text, currentValueType, value)) {
+        ShowFormattedStatusMessage("\"%s\" is not a valid %s", text, valueTypeNames[currentValueType]);
         return false;
     }
-    
     return true;
 }
 
-unsigned __stdcall scanMemoryThreadFunc(void* arg) {
-    ScanThreadData* data = static_cast<ScanThreadData*>(arg);
-    if (!data || !data->process || !data->settings || !data->results) {
-        LOG_ERROR("Invalid thread data");
-        return 1;
-    }
-    
-    LOG_DEBUG("Thread started - Assigned %zu regions to scan", data->regions.size());
-    DWORD threadId = GetCurrentThreadId();
-    
-    HANDLE processHandle = OpenProcess(PROCESS_VM_READ | PROCESS_QUERY_INFORMATION, 
-                                     FALSE, data->process->processId);
-    if (!processHandle) {
-        LOG_ERROR("Thread %lu: Failed to open process for scanning", threadId);
-        return 1;
-    }
-    
-    std::vector<std::pair<DWORD, int>> localResults;
-    localResults.reserve(SCAN_BATCH_SIZE);
-    
-    size_t threadBytesScanned = 0;
-    size_t threadMatchesFound = 0;
-    size_t threadRegionsSkipped = 0;
-    SIZE_T bytesRead = 0;
-    
-    try {
-        const int valueTypeSize = GetValueTypeSize(currentValueType);
-        const size_t BUFFER_SIZE = static_cast<size_t>(data->settings->scanBufferMB) * 1024 * 1024;
-        const size_t PAGE_SIZE = 4096;
-        
-        std::vector<BYTE> buffer;
-        buffer.reserve(BUFFER_SIZE + PAGE_SIZE);
-        size_t alignedSize = (BUFFER_SIZE + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
-        buffer.resize(alignedSize);
-
-        bool isSearchingForZero = (data->valueToFind == 0);
-
-        std::vector<MEMORY_BASIC_INFORMATION> sortedRegions;
-        for (const auto& mbi : data->regions) {
-            if (IsLikelyValidDataRegion(mbi, isSearchingForZero)) {
-                sortedRegions.push_back(mbi);
-            } else {
-                g_regionsSkipped++;
-                threadRegionsSkipped++;
-            }
-        }
-
-
-        std::sort(sortedRegions.begin(), sortedRegions.end(), 
-            [](const MEMORY_BASIC_INFORMATION& a, const MEMORY_BASIC_INFORMATION& b) {
-                if ((a.Protect & PAGE_READWRITE) && a.Type == MEM_PRIVATE) {
-                    if (!((b.Protect & PAGE_READWRITE) && b.Type == MEM_PRIVATE)) {
-                        return true;
-                    }
-                } else if ((b.Protect & PAGE_READWRITE) && b.Type == MEM_PRIVATE) {
-                    return false;
-                }
-                
-                return a.RegionSize > b.RegionSize;
-            });
-
-        LOG_DEBUG("Thread %lu: Will scan %zu regions after filtering", threadId, sortedRegions.size());
-
-        if (data->settings->prefetchMemory) {
-            _mm_prefetch(reinterpret_cast<const char*>(buffer.data()), _MM_HINT_T0);
-        }
-
-        for (const auto& mbi : sortedRegions) {
-            if (g_cancelScan) break;
-
-            BYTE* currentAddr = static_cast<BYTE*>(mbi.BaseAddress);
-            SIZE_T remaining = mbi.RegionSize;
-            
-            if (!IsLikelyValidDataRegion(mbi, isSearchingForZero)) {
-                g_regionsSkipped++;
-                threadRegionsSkipped++;
-                continue;
-            }
-
-            BYTE testBuffer[16];
-            if (!ReadProcessMemory(processHandle, currentAddr, testBuffer, sizeof(testBuffer), &bytesRead) || bytesRead == 0) {
-                g_regionsSkipped++;
-                threadRegionsSkipped++;
-                continue;
-            }
-
-            if (isSearchingForZero) {
-                bool allZeros = true;
-                for (size_t i = 0; i < bytesRead; i++) {
-                    if (testBuffer[i] != 0) {
-                        allZeros = false;
-                        break;
-                    }
-                }
-
-                if (allZeros) {
-                    localResults.emplace_back((DWORD)(uintptr_t)currentAddr, 0);
-                    threadMatchesFound++;
-                    g_regionsScanned++;
-                    g_bytesScanned += mbi.RegionSize;
-                    threadBytesScanned += mbi.RegionSize;
-                    continue;
-                }
-            }
-
-            LOG_DEBUG("Thread %lu: Scanning region at 0x%p (Size: %zu bytes)", 
-                     threadId, mbi.BaseAddress, mbi.RegionSize);
-
-            while (remaining > 0 && !g_cancelScan) {
-                SIZE_T bytesToRead = std::min(remaining, BUFFER_SIZE);
-                SIZE_T actualRead = 0;
-
-                if (!ReadProcessMemory(processHandle, currentAddr, buffer.data(), 
-                                    bytesToRead, &actualRead) || actualRead == 0) {
-                    break;
-                }
-
-                bool useVectorized = data->settings->useVectorizedOperations && 
-                                   (currentValueType == VALUE_TYPE_INT);
-
-                if (useVectorized) {
-                    if (VectorizedValueMatch(buffer.data(), data->valueToFind, currentValueType, actualRead)) {
-                        for (SIZE_T i = 0; i <= actualRead - valueTypeSize; i += sizeof(int)) {
-                            if (ValueMatches(&buffer[i], data->valueToFind, currentValueType)) {
-                                DWORD address = (DWORD)((uintptr_t)currentAddr + i);
-                                
-                                int confirmValue;
-                                if (ReadProcessMemory(processHandle, (LPCVOID)(uintptr_t)address, 
-                                    &confirmValue, sizeof(confirmValue), nullptr) && 
-                                    confirmValue == data->valueToFind) {
-                                    
-                                    localResults.emplace_back(address, confirmValue);
-                                    threadMatchesFound++;
-                                    
-                                    if (localResults.size() >= SCAN_BATCH_SIZE) {
-                                        std::lock_guard<std::mutex> lock(scanResultsMutex);
-                                        SaveBatchResults(data->results, localResults);
-                                        localResults.clear();
-                                    }
-                                }
-                            }
-                        }
-                    }
-                } else {
-                    int stride = 1;
-                    if (currentValueType == VALUE_TYPE_INT) {
-                        stride = 4;
-                    } else if (currentValueType == VALUE_TYPE_AUTO) {
-                        stride = 1;
-                    }
-                    
-                    for (SIZE_T i = 0; i <= actualRead - valueTypeSize; i += stride) {
-                        if (ValueMatches(&buffer[i], data->valueToFind, currentValueType)) {
-                            DWORD address = (DWORD)((uintptr_t)currentAddr + i);
-                            
-                            int confirmValue;
-                            if (ReadProcessMemory(processHandle, (LPCVOID)(uintptr_t)address, 
-                                &confirmValue, sizeof(confirmValue), nullptr)) {
-                                
-                                if (currentValueType == VALUE_TYPE_INT && confirmValue == data->valueToFind) {
-                                    localResults.emplace_back(address, confirmValue);
-                                    threadMatchesFound++;
-                                } else if (currentValueType != VALUE_TYPE_INT) {
-                                    // For non-int types, do a second match check
-                                    BYTE confirmBuffer[8];  // Large enough for any type
-                                    if (ReadProcessMemory(processHandle, (LPCVOID)(uintptr_t)address,
-                                        confirmBuffer, valueTypeSize, nullptr) && 
-                                        ValueMatches(confirmBuffer, data->valueToFind, currentValueType)) {
-                                        
-                                        localResults.emplace_back(address, confirmValue);
-                                        threadMatchesFound++;
-                                    }
-                                }
-                                
-                                if (localResults.size() >= SCAN_BATCH_SIZE) {
-                                    std::lock_guard<std::mutex> lock(scanResultsMutex);
-                                    SaveBatchResults(data->results, localResults);
-                                    localResults.clear();
-                                }
-                            }
-                        }
-                    }
-                }
+inline float GetScanProgress() {
+    return (g_totalRegionsToScan > 0) ? 
+        (float)g_regionsScanned / (float)g_totalRegionsToScan : 0.0f;
+}
 
-                currentAddr += actualRead;
-                remaining -= actualRead;
-                g_bytesScanned += actualRead;
-                threadBytesScanned += actualRead;
-            }
-            g_regionsScanned++;
-        }
 
-        if (!localResults.empty()) {
-            std::lock_guard<std::mutex> lock(scanResultsMutex);
-            SaveBatchResults(data->results, localResults);
-        }
 
-    } catch (const std::exception& e) {
-        LOG_ERROR("Thread %lu error: %s", threadId, e.what());
-    }
-    
-    CloseHandle(processHandle);
-    return 0;
-}
-
-void SaveBatchResults(ScanResults* results, std::vector<std::pair<DWORD, int>>& batch) {
-    std::lock_guard<std::mutex> lock(scanResultsMutex);
-    
-    LOG_DEBUG("Starting batch save of %zu results (Current total: %zu)", 
-              batch.size(), results->count);
+void DisplaySearchResultRow(size_t index) {
+    uintptr_t address = getScanResultAddress(&g_scanResults, index);
+    char valueStr[32];
+    FormatScanValue(getScanResultValue(&g_scanResults, index), g_scanResults.valueSize, g_scanResults.valueType,
+                    valueStr, sizeof(valueStr));
+    char addressStr[20];
+    sprintf_s(addressStr, sizeof(addressStr), "0x%08llX", (unsigned long long)address);
     
-    size_t beforeCount = results->count;
-    size_t added = 0;
-    
-    for (const auto& result : batch) {
-        if (addScanResult(results, result.first, result.second)) {
-            added++;
+    if (searchBuffer[0] != '\0') {
+        if (strstr(addressStr, searchBuffer) == NULL && 
+            strstr(valueStr, searchBuffer) == NULL) {
+            return;
         }
     }
     
-    LOG_DEBUG("Batch save complete: Added %zu/%zu results (New total: %zu)", 
-              added, batch.size(), results->count);
-    
-    g_resultsUpdated = true;
+    ImGui::TableNextRow();
+    ImGui::TableSetColumnIndex(0);
+    if (ImGui::Selectable(addressStr, false, ImGuiSelectableFlags_SpanAllColumns)) {
+        addressToModify = address;
+        strcpy_s(newValue, sizeof(newValue), valueStr);
+    }
+    ImGui::TableSetColumnIndex(1);
+    ImGui::Text("%s", valueStr);
+    ImGui::TableSetColumnIndex(2);
+    char originalStr[32];
+    FormatScanValue(getScanResultOriginal(&g_scanResults, index), g_scanResults.valueSize, g_scanResults.valueType,
+                    originalStr, sizeof(originalStr));
+    ImGui::Text("%s", originalStr);
 }
 
 void DisplayScanResults(ImGuiTableFlags flags) {
-    if (ImGui::BeginTable("ScanResultsTable", 3, flags | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY, 
+    if (ImGui::BeginTable("ScanResultsTable", 4, flags | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY, 
                          ImVec2(0, 400))) {
         
         ImGui::TableSetupScrollFreeze(0, 1);
         ImGui::TableSetupColumn("Address", ImGuiTableColumnFlags_WidthFixed, 100.0f);
         ImGui::TableSetupColumn("Current Value", ImGuiTableColumnFlags_WidthFixed, 100.0f);
         ImGui::TableSetupColumn("Original Value", ImGuiTableColumnFlags_WidthFixed, 100.0f);
+        ImGui::TableSetupColumn("Last Changed", ImGuiTableColumnFlags_WidthFixed, 100.0f);
         ImGui::TableHeadersRow();
 
         ImGui::TableNextRow();
@@ -2185,113 +1565,109 @@ void DisplayScanResults(ImGuiTableFlags flags) {
         ImGui::TextColored(ImVec4(1,1,0,1), "Matches: %zu", 
                           g_matchesFound.load());
 
-        if (g_scanResults.count > 0 && g_scanResults.entries != nullptr) {
+        if (g_scanResults.count > 0 && !g_scanResults.regions.empty()) {
             static float lastClickTime = 0.0f;
             const float doubleClickTime = 0.3f;
 
-            bool processHandleValid = g_currentProcess.processHandle && 
+            bool processHandleValid = g_currentProcess.memory && 
                                     g_currentProcess.processId != 0;
 
-            for (size_t i = 0; i < g_scanResults.count; i++) {
-                ImGui::TableNextRow();
-                
-                ImGui::TableSetColumnIndex(0);
-                char addressStr[32];
-                snprintf(addressStr, sizeof(addressStr), "0x%08X", 
-                        g_scanResults.entries[i].address);
-
-                if (ImGui::Selectable(addressStr, false, ImGuiSelectableFlags_SpanAllColumns)) {
-                    float currentTime = ImGui::GetTime();
-                    if (currentTime - lastClickTime <= doubleClickTime) {
-                        strcpy_s(g_addressInput, sizeof(g_addressInput), &addressStr[2]); // Skip the '0x' prefix
-                        
-                        if (processHandleValid) {
-                            int currentValue = 0;
-                            SIZE_T bytesRead = 0;
-                            if (SafeReadMemoryWithRetry(g_currentProcess.processHandle, 
-                                                (LPVOID)(uintptr_t)g_scanResults.entries[i].address,
-                                                &currentValue, sizeof(currentValue), &bytesRead, 3)) {
-                                newValue = currentValue;
-                            } else {
-                                newValue = g_scanResults.entries[i].value;
+            // Only visible rows are laid out; their addresses go to the
+            // refresher, which reads them in the background.
+            static std::vector<uintptr_t> visibleAddresses;
+            visibleAddresses.clear();
+            const ValueCache* valueCache = acquireValueCache(&g_valueRefresher);
+            DWORD now = GetTickCount();
+
+            ImGuiListClipper clipper;
+            clipper.Begin((int)std::min(g_scanResults.count, (size_t)std::numeric_limits<int>::max()));
+            while (clipper.Step()) {
+                for (size_t i = (size_t)clipper.DisplayStart; i < (size_t)clipper.DisplayEnd; i++) {
+                    uintptr_t address = getScanResultAddress(&g_scanResults, i);
+                    const BYTE* originalValue = getScanResultOriginal(&g_scanResults, i);
+                    char originalStr[32];
+                    FormatScanValue(originalValue, g_scanResults.valueSize, g_scanResults.valueType,
+                                    originalStr, sizeof(originalStr));
+                    visibleAddresses.push_back(address);
+
+                    ImGui::TableNextRow();
+                    
+                    ImGui::TableSetColumnIndex(0);
+                    char addressStr[32];
+                    snprintf(addressStr, sizeof(addressStr), "0x%08llX", 
+                            (unsigned long long)address);
+
+                    if (ImGui::Selectable(addressStr, false, ImGuiSelectableFlags_SpanAllColumns)) {
+                        float currentTime = ImGui::GetTime();
+                        if (currentTime - lastClickTime <= doubleClickTime) {
+                            strcpy_s(g_addressInput, sizeof(g_addressInput), &addressStr[2]); // Skip the '0x' prefix
+                            
+                            BYTE currentValue[sizeof(uint64_t)];
+                            size_t bytesRead = 0;
+                            if (!processHandleValid ||
+                                !SafeReadSourceWithRetry(g_currentProcess.memory, 
+                                                    address,
+                                                    currentValue, g_scanResults.valueSize, &bytesRead, 3)) {
+                                memcpy(currentValue, getScanResultValue(&g_scanResults, i), g_scanResults.valueSize);
                             }
-                        } else {
-                            newValue = g_scanResults.entries[i].value;
+                            FormatScanValue(currentValue, g_scanResults.valueSize, g_scanResults.valueType,
+                                            newValue, sizeof(newValue));
+                            
+                            LOG_DEBUG("Double-clicked result - Address: %s, Value: %s", 
+                                    g_addressInput, newValue);
+                            ShowStatusMessage("Value copied to memory modification");
                         }
-                        
-                        LOG_DEBUG("Double-clicked result - Address: %s, Value: %d", 
-                                g_addressInput, newValue);
-                        ShowStatusMessage("Value copied to memory modification");
+                        lastClickTime = currentTime;
                     }
-                    lastClickTime = currentTime;
-                }
 
-                ImGui::TableSetColumnIndex(1);
-                
-                if (processHandleValid) {
-                    int currentValue;
-                    SIZE_T bytesRead = 0;
-                    DWORD lastError = 0;
-                    bool readResult = false;
-                    
-                    readResult = SafeReadMemoryWithRetry(
-                        g_currentProcess.processHandle,
-                        (LPVOID)(uintptr_t)g_scanResults.entries[i].address,
-                        &currentValue,
-                        sizeof(currentValue),
-                        &bytesRead,
-                        3
-                    );
-                    
-                    if (!readResult) {
-                        lastError = GetLastError();
-                    }
+                    ImGui::TableSetColumnIndex(1);
                     
-                    if (readResult && bytesRead == sizeof(currentValue)) {
-                        bool valueChanged = (currentValue != g_scanResults.entries[i].originalValue);
-                        
-                        if (valueChanged) {
-                            ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%d", currentValue);
+                    const RefreshedValue* refreshed = processHandleValid ?
+                        findRefreshedValue(valueCache, address) : nullptr;
+                    if (refreshed && refreshed->bytesRead > 0) {
+                        char currentValue[32];
+                        FormatScanValue(refreshed->value, g_scanResults.valueSize, g_scanResults.valueType,
+                                        currentValue, sizeof(currentValue));
+
+                        if (refreshed->bytesRead < g_scanResults.valueSize) {
+                            ImGui::TextColored(ImVec4(1,0.5f,0,1), "%s (partial)", currentValue);
+                        } else if (memcmp(refreshed->value, originalValue, g_scanResults.valueSize) != 0) {
+                            ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%s", currentValue);
                         } else {
-                            ImGui::Text("%d", currentValue);
+                            ImGui::Text("%s", currentValue);
                         }
-                        
-                        g_scanResults.entries[i].value = currentValue;
-                    } 
-                    else if (readResult && bytesRead > 0) {
-                        ImGui::TextColored(ImVec4(1,0.5f,0,1), "%d (partial)", currentValue);
-                        
-                        LOG_DEBUG("Partial read at 0x%08X: got %zu of %zu bytes", 
-                                 g_scanResults.entries[i].address, bytesRead, sizeof(currentValue));
-                        g_scanResults.entries[i].value = currentValue;
+                    } else if (refreshed) {
+                        ImGui::TextColored(ImVec4(1,0,0,1), "NO ACCESS");
+                    } else {
+                        char cachedValue[32];
+                        FormatScanValue(getScanResultValue(&g_scanResults, i), g_scanResults.valueSize,
+                                        g_scanResults.valueType, cachedValue, sizeof(cachedValue));
+                        ImGui::TextColored(ImVec4(0.7f,0.7f,0.7f,1), "%s [cached]", cachedValue);
                     }
-                    else {
-                        if (lastError == ERROR_PARTIAL_COPY) {
-                            ImGui::TextColored(ImVec4(1,0.5f,0,1), "PARTIAL");
-                        }
-                        else if (lastError == ERROR_NOACCESS) {
-                            ImGui::TextColored(ImVec4(1,0,0,1), "NO ACCESS");
-                        }
-                        else if (lastError == ERROR_INVALID_HANDLE) {
-                            ImGui::TextColored(ImVec4(1,0,0,1), "INV HANDLE");
-                        }
-                        else if (lastError == ERROR_INVALID_PARAMETER) {
-                            ImGui::TextColored(ImVec4(1,0,0,1), "INV PARAM");
-                        }
-                        else {
-                            const char* errorStr = GetLastErrorAsString(lastError);
-                            ImGui::TextColored(ImVec4(1,0,0,1), "ERR: %s", errorStr);
+
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::Text("%s", originalStr);
+
+                    ImGui::TableSetColumnIndex(3);
+                    if (refreshed && refreshed->lastChanged != 0) {
+                        float age = (float)(now - refreshed->lastChanged) / 1000.0f;
+                        if (age < 1.0f) {
+                            ImGui::TextColored(ImVec4(1,1,0,1), "%.1fs ago", age);
+                        } else {
+                            ImGui::Text("%.1fs ago", age);
                         }
+                    } else {
+                        ImGui::TextColored(ImVec4(0.7f,0.7f,0.7f,1), "-");
                     }
-                } else {
-                    ImGui::TextColored(ImVec4(0.7f,0.7f,0.7f,1), "%d [cached]", 
-                                    g_scanResults.entries[i].value);
                 }
-
-                ImGui::TableSetColumnIndex(2);
-                ImGui::Text("%d", g_scanResults.entries[i].originalValue);
             }
+            clipper.End();
+            releaseValueCache(&g_valueRefresher);
+
+            watchValues(&g_valueRefresher, processHandleValid ? visibleAddresses : std::vector<uintptr_t>(),
+                        g_scanResults.valueSize);
         } else {
+            watchValues(&g_valueRefresher, std::vector<uintptr_t>(), g_scanResults.valueSize);
             ImGui::TableNextRow();
             ImGui::TableSetColumnIndex(0);
             ImGui::TextColored(ImVec4(1,0.5f,0,1), 
@@ -2330,8 +1706,9 @@ void ShowScanProgressDialog() {
         float scanProgress = (g_totalRegionsToScan > 0) ? 
             (float)g_regionsScanned.load() / (float)g_totalRegionsToScan : 0.0f;
         
+        // Pages skipped by residency count as done.
         float memoryProgress = (g_totalMemoryToScan > 0) ?
-            (float)g_bytesScanned.load() / (float)g_totalMemoryToScan : 0.0f;
+            (float)(g_bytesScanned.load() + g_bytesSkipped.load()) / (float)g_totalMemoryToScan : 0.0f;
 
         char overlayText[32];
         
@@ -2364,6 +1741,7 @@ void ShowScanProgressDialog() {
         
         ImGui::Text("Scan Speed: %.2f MB/s", scanSpeed);
         ImGui::Text("Regions Skipped: %zu", g_regionsSkipped.load());
+        ImGui::Text("Pages Skipped: %.2f MB", g_bytesSkipped.load() / (1024.0f * 1024.0f));
         
         ImGui::Separator();
         ImGui::SetCursorPosX((ImGui::GetWindowWidth() - 120) * 0.5f);
@@ -0,0 +1,69 @@
+#include "memory_source.h"
+#include "logging.h"
+#include <thread>
+#include <chrono>
+
+bool IsReadableRegion(const MemoryRegion& region) {
+    return (region.state == MEM_COMMIT) &&
+           (region.protect & (PAGE_READONLY | PAGE_READWRITE | PAGE_WRITECOPY |
+                              PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)) &&
+           !(region.protect & (PAGE_GUARD | PAGE_NOACCESS));
+}
+
+bool SafeReadSourceWithRetry(MemorySource* source, uintptr_t address, void* buffer,
+                             size_t size, size_t* bytesRead, int maxRetries) {
+    if (maxRetries <= 0) maxRetries = 3;
+
+    *bytesRead = 0;
+    if (!source) {
+        return false;
+    }
+
+    MemoryRegion region;
+    if (!source->queryRegion(address, &region)) {
+        LOG_DEBUG("Cannot query memory at 0x%llx", (unsigned long long)address);
+        return false;
+    }
+
+    if (!IsReadableRegion(region)) {
+        LOG_DEBUG("Memory at 0x%llx is not readable (State: 0x%X, Protect: 0x%X)",
+                 (unsigned long long)address, region.state, region.protect);
+        return false;
+    }
+
+    for (int attempt = 0; attempt < maxRetries; attempt++) {
+        if (attempt > 0) {
+            LOG_DEBUG("Retry %d reading memory at 0x%llx", attempt, (unsigned long long)address);
+        }
+
+        size_t bytesReadThisTime = 0;
+        if (source->read(address, buffer, size, &bytesReadThisTime)) {
+            *bytesRead = bytesReadThisTime;
+            return true;
+        }
+
+        if (bytesReadThisTime > 0) {
+            *bytesRead = bytesReadThisTime;
+
+            size_t additionalBytesRead = 0;
+            source->read(address + bytesReadThisTime, (BYTE*)buffer + bytesReadThisTime,
+                         size - bytesReadThisTime, &additionalBytesRead);
+            *bytesRead += additionalBytesRead;
+            if (*bytesRead == size) {
+                return true;
+            }
+
+            LOG_DEBUG("Could only read %zu of %zu bytes at 0x%llx",
+                     *bytesRead, size, (unsigned long long)address);
+            return false;
+        }
+
+        if (attempt < maxRetries - 1) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    LOG_DEBUG("Failed to read memory at 0x%llx after %d attempts",
+             (unsigned long long)address, maxRetries);
+    return false;
+}
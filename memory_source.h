@@ -0,0 +1,107 @@
+#pragma once
+
+#include "platform.h"
+#include <stdint.h>
+#include <vector>
+
+// Region descriptor shared by every backend. Protection, state and type use
+// the Win32 PAGE_* / MEM_* values on all platforms so region filters such as
+// IsLikelyValidDataRegion behave identically on Windows and Linux.
+struct MemoryRegion {
+    uintptr_t base;   // First byte of the region
+    size_t size;      // Region size in bytes
+    DWORD protect;    // PAGE_* protection flags
+    DWORD state;      // MEM_COMMIT / MEM_RESERVE / MEM_FREE
+    DWORD type;       // MEM_PRIVATE / MEM_MAPPED / MEM_IMAGE
+};
+
+// One element of a scatter read. bytesRead is filled in by readScatter.
+struct ScatterEntry {
+    uintptr_t address;
+    void* buffer;
+    size_t size;
+    size_t bytesRead;
+};
+
+// Per-page residency flags from queryResidency. A page with none set is
+// mapped but was never touched: it reads as zero for private memory, and
+// as the file's bytes for image and mapped memory.
+const BYTE PAGE_RESIDENT = 0x01;    // In the target's working set
+const BYTE PAGE_SWAPPED = 0x02;     // Paged out; reading it pages it back in
+const BYTE PAGE_SHARED_ZERO = 0x04; // Resident, backed by the shared zero page
+const SIZE_T RESIDENCY_PAGE_SIZE = 4096;
+
+// A loaded executable image. The span covers every mapping of the image,
+// so its static data lies inside [base, base + size).
+struct ModuleInfo {
+    uintptr_t base;
+    size_t size;
+    char name[260];   // File name without directory
+};
+
+// Abstract access to the address space of a target process. The scan,
+// narrow and write engine only talks to this interface, so the same engine
+// runs on top of ReadProcessMemory on Windows and process_vm_readv on Linux.
+class MemorySource {
+public:
+    virtual ~MemorySource() {}
+
+    // Enumerate every region of the target in ascending address order.
+    virtual bool enumerateRegions(std::vector<MemoryRegion>& regions) = 0;
+
+    // Enumerate loaded modules in ascending base order.
+    virtual bool enumerateModules(std::vector<ModuleInfo>& modules) = 0;
+
+    // Describe the region containing address.
+    virtual bool queryRegion(uintptr_t address, MemoryRegion* region) = 0;
+
+    // Re-walk the address space if this source caches it. Sources that
+    // query the system on every call have nothing to do.
+    virtual bool refreshRegions() { return true; }
+
+    // Bulk read. Returns true only if all size bytes were copied; bytesRead
+    // receives the length of the readable prefix either way.
+    virtual bool read(uintptr_t address, void* buffer, size_t size, size_t* bytesRead) = 0;
+
+    // Read many small ranges at once. Returns the number of fully read entries.
+    virtual size_t readScatter(ScatterEntry* entries, size_t count) = 0;
+
+    // Fills one PAGE_* residency byte per page for pageCount pages from the
+    // page-aligned address, without touching the pages. Returns false when
+    // the backend cannot tell, in which case every page should be read.
+    virtual bool queryResidency(uintptr_t address, size_t pageCount, BYTE* flags) {
+        (void)address; (void)pageCount; (void)flags;
+        return false;
+    }
+
+    // Write tracking for incremental next scans. resetWrittenPages starts a
+    // fresh record of the pages the target writes; queryWrittenPages then
+    // sets one byte per page to 1 when the page may have changed since,
+    // counting pages discarded or unmapped in the meantime as changed.
+    // Both return false when the backend cannot track writes.
+    virtual bool resetWrittenPages() { return false; }
+    virtual bool queryWrittenPages(uintptr_t address, size_t pageCount, BYTE* written) {
+        (void)address; (void)pageCount; (void)written;
+        return false;
+    }
+
+    virtual bool write(uintptr_t address, const void* buffer, size_t size, size_t* bytesWritten) = 0;
+
+    virtual DWORD processId() const = 0;
+    virtual bool isValid() const = 0;
+};
+
+// Opens the platform backend for processId. Returns nullptr on failure.
+MemorySource* CreateMemorySource(DWORD processId);
+
+#ifdef _WIN32
+// Wraps an already opened handle. The handle stays owned by the caller.
+MemorySource* CreateMemorySourceFromHandle(HANDLE processHandle, DWORD processId);
+#endif
+
+// Returns true if the region can be read without faulting.
+bool IsReadableRegion(const MemoryRegion& region);
+
+// Read with retries through a MemorySource, checking the region first.
+bool SafeReadSourceWithRetry(MemorySource* source, uintptr_t address, void* buffer,
+                             size_t size, size_t* bytesRead, int maxRetries = 3);
@@ -0,0 +1,447 @@
+#ifdef __linux__
+
+#include "memory_source.h"
+#include "logging.h"
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// /proc/<pid>/pagemap entries: bit 63 present, bit 62 swapped, bit 55
+// soft-dirty (written since the last clear_refs), bits 0-54 the page frame
+// number (reported as 0 without CAP_SYS_ADMIN).
+const uint64_t PAGEMAP_PRESENT = 1ULL << 63;
+const uint64_t PAGEMAP_SWAPPED = 1ULL << 62;
+const uint64_t PAGEMAP_SOFT_DIRTY = 1ULL << 55;
+const uint64_t PAGEMAP_PFN_MASK = (1ULL << 55) - 1;
+
+// Frame of the kernel's shared zero page, found by read-faulting a fresh
+// anonymous page of our own. 0 when frame numbers are hidden from us.
+static uint64_t FindZeroPageFrame() {
+    void* page = mmap(nullptr, RESIDENCY_PAGE_SIZE, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED) {
+        return 0;
+    }
+    volatile BYTE touch = *(volatile BYTE*)page;
+    (void)touch;
+
+    uint64_t entry = 0;
+    int fd = open("/proc/self/pagemap", O_RDONLY);
+    if (fd >= 0) {
+        off_t offset = (off_t)((uintptr_t)page / RESIDENCY_PAGE_SIZE * sizeof(entry));
+        if (pread(fd, &entry, sizeof(entry), offset) != (ssize_t)sizeof(entry)) {
+            entry = 0;
+        }
+        close(fd);
+    }
+    munmap(page, RESIDENCY_PAGE_SIZE);
+    return (entry & PAGEMAP_PRESENT) ? (entry & PAGEMAP_PFN_MASK) : 0;
+}
+
+// Whether the kernel keeps soft-dirty bits (CONFIG_MEM_SOFT_DIRTY). Without
+// them bit 55 always reads clear, so it is tried once on a page of our own:
+// it has to be clean right after clear_refs and dirty once written.
+static bool ProbeSoftDirty() {
+    BYTE* page = (BYTE*)mmap(nullptr, RESIDENCY_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED) {
+        return false;
+    }
+    page[0] = 1;
+
+    bool supported = false;
+    int pagemap = open("/proc/self/pagemap", O_RDONLY);
+    int clearRefs = open("/proc/self/clear_refs", O_WRONLY);
+    if (pagemap >= 0 && clearRefs >= 0 && write(clearRefs, "4", 1) == 1) {
+        off_t offset = (off_t)((uintptr_t)page / RESIDENCY_PAGE_SIZE * sizeof(uint64_t));
+        uint64_t before = 0;
+        uint64_t after = 0;
+        if (pread(pagemap, &before, sizeof(before), offset) == (ssize_t)sizeof(before)) {
+            ((volatile BYTE*)page)[0] = 2;
+            supported = pread(pagemap, &after, sizeof(after), offset) == (ssize_t)sizeof(after) &&
+                        !(before & PAGEMAP_SOFT_DIRTY) && (after & PAGEMAP_SOFT_DIRTY);
+        }
+    }
+    if (pagemap >= 0) {
+        close(pagemap);
+    }
+    if (clearRefs >= 0) {
+        close(clearRefs);
+    }
+    munmap(page, RESIDENCY_PAGE_SIZE);
+    return supported;
+}
+
+static bool SoftDirtySupported() {
+    static const bool supported = ProbeSoftDirty();
+    return supported;
+}
+
+class LinuxMemorySource : public MemorySource {
+private:
+    pid_t pid;
+    char mapsPath[64];
+    char clearRefsPath[64];
+    int pagemapFd;          // -1 when the pagemap cannot be opened
+
+    // Reads count pagemap entries starting with the page at address.
+    bool readPagemap(uintptr_t address, size_t count, uint64_t* entries) {
+        off_t offset = (off_t)(address / RESIDENCY_PAGE_SIZE * sizeof(uint64_t));
+        return pread(pagemapFd, entries, count * sizeof(uint64_t), offset) == (ssize_t)(count * sizeof(uint64_t));
+    }
+
+    static DWORD translateProtection(const char* perms, const char* path) {
+        bool r = perms[0] == 'r';
+        bool w = perms[1] == 'w';
+        bool x = perms[2] == 'x';
+
+        // The vvar page is mapped readable but cannot be read through
+        // process_vm_readv, so keep it out of every scan.
+        if (strcmp(path, "[vvar]") == 0 || strcmp(path, "[vvar_vclock]") == 0) {
+            return PAGE_NOACCESS;
+        }
+
+        if (x) {
+            if (w) return PAGE_EXECUTE_READWRITE;
+            if (r) return PAGE_EXECUTE_READ;
+            return PAGE_EXECUTE;
+        }
+        if (w) return PAGE_READWRITE;
+        if (r) return PAGE_READONLY;
+        return PAGE_NOACCESS;
+    }
+
+    static DWORD translateType(const char* perms, unsigned long inode, const char* path) {
+        if (perms[3] == 's') return MEM_MAPPED;
+        if (inode != 0 && path[0] == '/') return MEM_IMAGE;
+        return MEM_PRIVATE;
+    }
+
+    static void fillFreeRegion(uintptr_t start, uintptr_t end, MemoryRegion* region) {
+        region->base = start;
+        region->size = end - start;
+        region->protect = PAGE_NOACCESS;
+        region->state = MEM_FREE;
+        region->type = 0;
+    }
+
+public:
+    explicit LinuxMemorySource(pid_t processId) : pid(processId) {
+        snprintf(mapsPath, sizeof(mapsPath), "/proc/%d/maps", (int)pid);
+        snprintf(clearRefsPath, sizeof(clearRefsPath), "/proc/%d/clear_refs", (int)pid);
+        char pagemapPath[64];
+        snprintf(pagemapPath, sizeof(pagemapPath), "/proc/%d/pagemap", (int)pid);
+        pagemapFd = open(pagemapPath, O_RDONLY);
+        if (pagemapFd < 0) {
+            LOG_WARNING("Cannot open %s (errno %d), scans read every page", pagemapPath, errno);
+        }
+    }
+
+    ~LinuxMemorySource() {
+        if (pagemapFd >= 0) {
+            close(pagemapFd);
+        }
+    }
+
+    bool enumerateRegions(std::vector<MemoryRegion>& regions) override {
+        regions.clear();
+
+        FILE* maps = fopen(mapsPath, "r");
+        if (!maps) {
+            LOG_ERROR("Failed to open %s (errno %d)", mapsPath, errno);
+            return false;
+        }
+
+        char line[PATH_MAX + 128];
+        uintptr_t previousEnd = 0;
+        while (fgets(line, sizeof(line), maps)) {
+            unsigned long long start = 0, end = 0, offset = 0;
+            unsigned long inode = 0;
+            char perms[8] = "";
+            char dev[16] = "";
+            char path[PATH_MAX] = "";
+
+            int fields = sscanf(line, "%llx-%llx %7s %llx %15s %lu %4095[^\n]",
+                                &start, &end, perms, &offset, dev, &inode, path);
+            if (fields < 6) {
+                continue;
+            }
+
+            // sscanf leaves the leading blanks of the path column in place.
+            const char* name = path;
+            while (*name == ' ') name++;
+
+            if (previousEnd != 0 && start > previousEnd) {
+                MemoryRegion gap;
+                fillFreeRegion(previousEnd, (uintptr_t)start, &gap);
+                regions.push_back(gap);
+            }
+
+            MemoryRegion region;
+            region.base = (uintptr_t)start;
+            region.size = (size_t)(end - start);
+            region.protect = translateProtection(perms, name);
+            region.state = MEM_COMMIT;
+            region.type = translateType(perms, inode, name);
+            regions.push_back(region);
+
+            previousEnd = (uintptr_t)end;
+        }
+
+        fclose(maps);
+        return !regions.empty();
+    }
+
+    bool enumerateModules(std::vector<ModuleInfo>& modules) override {
+        modules.clear();
+
+        FILE* maps = fopen(mapsPath, "r");
+        if (!maps) {
+            LOG_ERROR("Failed to open %s (errno %d)", mapsPath, errno);
+            return false;
+        }
+
+        // Consecutive mappings of one file form a module. The anonymous
+        // mapping right after it is the image's .bss and belongs to it too.
+        char line[PATH_MAX + 128];
+        char current[PATH_MAX] = "";
+        bool bssTaken = false;
+        while (fgets(line, sizeof(line), maps)) {
+            unsigned long long start = 0, end = 0, offset = 0;
+            unsigned long inode = 0;
+            char perms[8] = "";
+            char dev[16] = "";
+            char path[PATH_MAX] = "";
+            int fields = sscanf(line, "%llx-%llx %7s %llx %15s %lu %4095[^\n]",
+                                &start, &end, perms, &offset, dev, &inode, path);
+            if (fields < 6) {
+                continue;
+            }
+            const char* name = path;
+            while (*name == ' ') name++;
+
+            bool adjacent = !modules.empty() && modules.back().base + modules.back().size == (uintptr_t)start;
+            if (inode != 0 && name[0] == '/') {
+                if (adjacent && strcmp(current, name) == 0) {
+                    modules.back().size = (size_t)(end - modules.back().base);
+                    continue;
+                }
+                ModuleInfo module;
+                module.base = (uintptr_t)start;
+                module.size = (size_t)(end - start);
+                const char* slash = strrchr(name, '/');
+                snprintf(module.name, sizeof(module.name), "%s", slash ? slash + 1 : name);
+                modules.push_back(module);
+                snprintf(current, sizeof(current), "%s", name);
+                bssTaken = false;
+            } else if (adjacent && !bssTaken && inode == 0 && name[0] == '\0' && perms[1] == 'w') {
+                modules.back().size = (size_t)(end - modules.back().base);
+                bssTaken = true;
+            } else {
+                current[0] = '\0';
+            }
+        }
+
+        fclose(maps);
+        return !modules.empty();
+    }
+
+    bool queryRegion(uintptr_t address, MemoryRegion* region) override {
+        std::vector<MemoryRegion> regions;
+        if (!enumerateRegions(regions)) {
+            return false;
+        }
+
+        std::vector<MemoryRegion>::const_iterator it = std::upper_bound(
+            regions.begin(), regions.end(), address,
+            [](uintptr_t value, const MemoryRegion& r) { return value < r.base; });
+        if (it == regions.begin()) {
+            return false;
+        }
+        --it;
+        if (address >= it->base + it->size) {
+            return false;
+        }
+        *region = *it;
+        return true;
+    }
+
+    bool read(uintptr_t address, void* buffer, size_t size, size_t* bytesRead) override {
+        struct iovec local = { buffer, size };
+        struct iovec remote = { (void*)address, size };
+
+        ssize_t result = process_vm_readv(pid, &local, 1, &remote, 1, 0);
+        size_t actual = result > 0 ? (size_t)result : 0;
+        if (bytesRead) {
+            *bytesRead = actual;
+        }
+        if (result < 0 && errno == EPERM) {
+            LOG_ERROR("process_vm_readv denied for pid %d (ptrace permission required)", (int)pid);
+        }
+        return actual == size;
+    }
+
+    size_t readScatter(ScatterEntry* entries, size_t count) override {
+        struct iovec local[IOV_MAX];
+        struct iovec remote[IOV_MAX];
+        size_t completed = 0;
+        size_t index = 0;
+
+        while (index < count) {
+            size_t batch = std::min(count - index, (size_t)IOV_MAX);
+            for (size_t i = 0; i < batch; i++) {
+                local[i].iov_base = entries[index + i].buffer;
+                local[i].iov_len = entries[index + i].size;
+                remote[i].iov_base = (void*)entries[index + i].address;
+                remote[i].iov_len = entries[index + i].size;
+                entries[index + i].bytesRead = 0;
+            }
+
+            ssize_t result = process_vm_readv(pid, local, batch, remote, batch, 0);
+            size_t transferred = result > 0 ? (size_t)result : 0;
+
+            // The kernel stops at the first remote range that faults; credit
+            // whole entries up to that point and restart after the bad one.
+            size_t i = 0;
+            for (; i < batch && transferred > 0; i++) {
+                size_t chunk = std::min(transferred, entries[index + i].size);
+                entries[index + i].bytesRead = chunk;
+                transferred -= chunk;
+                if (chunk == entries[index + i].size) {
+                    completed++;
+                } else {
+                    break;
+                }
+            }
+
+            if (i == batch) {
+                index += batch;
+            } else {
+                // Entry index + i failed (fully or partially); skip past it.
+                index += i + 1;
+            }
+        }
+
+        return completed;
+    }
+
+    bool queryResidency(uintptr_t address, size_t pageCount, BYTE* flags) override {
+        static const uint64_t zeroFrame = FindZeroPageFrame();
+        if (pagemapFd < 0) {
+            return false;
+        }
+
+        uint64_t entries[512];
+        size_t done = 0;
+        while (done < pageCount) {
+            size_t batch = std::min(pageCount - done, sizeof(entries) / sizeof(entries[0]));
+            if (!readPagemap(address + done * RESIDENCY_PAGE_SIZE, batch, entries)) {
+                return false;
+            }
+            for (size_t i = 0; i < batch; i++) {
+                uint64_t entry = entries[i];
+                BYTE flag = 0;
+                if (entry & PAGEMAP_PRESENT) {
+                    flag = PAGE_RESIDENT;
+                    if (zeroFrame != 0 && (entry & PAGEMAP_PFN_MASK) == zeroFrame) {
+                        flag |= PAGE_SHARED_ZERO;
+                    }
+                } else if (entry & PAGEMAP_SWAPPED) {
+                    flag = PAGE_SWAPPED;
+                }
+                flags[done + i] = flag;
+            }
+            done += batch;
+        }
+        return true;
+    }
+
+    // Writing 4 to clear_refs clears every soft-dirty bit of the target
+    // and write-protects its pages, so the next write to each one faults
+    // once and sets the bit again.
+    bool resetWrittenPages() override {
+        if (pagemapFd < 0 || !SoftDirtySupported()) {
+            return false;
+        }
+        int fd = open(clearRefsPath, O_WRONLY);
+        if (fd < 0) {
+            LOG_WARNING("Cannot open %s (errno %d)", clearRefsPath, errno);
+            return false;
+        }
+        bool reset = ::write(fd, "4", 1) == 1;
+        close(fd);
+        return reset;
+    }
+
+    bool queryWrittenPages(uintptr_t address, size_t pageCount, BYTE* written) override {
+        if (pagemapFd < 0 || !SoftDirtySupported()) {
+            return false;
+        }
+
+        uint64_t entries[512];
+        size_t done = 0;
+        while (done < pageCount) {
+            size_t batch = std::min(pageCount - done, sizeof(entries) / sizeof(entries[0]));
+            if (!readPagemap(address + done * RESIDENCY_PAGE_SIZE, batch, entries)) {
+                return false;
+            }
+            // A page dropped by MADV_DONTNEED or munmap reads differently
+            // afterwards but leaves no soft-dirty bit, so only clean pages
+            // that are still present or swapped count as unwritten.
+            for (size_t i = 0; i < batch; i++) {
+                uint64_t entry = entries[i];
+                written[done + i] = (entry & PAGEMAP_SOFT_DIRTY) || !(entry & (PAGEMAP_PRESENT | PAGEMAP_SWAPPED));
+            }
+            done += batch;
+        }
+        return true;
+    }
+
+    bool write(uintptr_t address, const void* buffer, size_t size, size_t* bytesWritten) override {
+        struct iovec local = { const_cast<void*>(buffer), size };
+        struct iovec remote = { (void*)address, size };
+
+        ssize_t result = process_vm_writev(pid, &local, 1, &remote, 1, 0);
+        size_t actual = result > 0 ? (size_t)result : 0;
+        if (bytesWritten) {
+            *bytesWritten = actual;
+        }
+        if (actual != size) {
+            LOG_ERROR("Failed to write to address 0x%llx (errno %d - %s)",
+                     (unsigned long long)address, errno, strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    DWORD processId() const override {
+        return (DWORD)pid;
+    }
+
+    bool isValid() const override {
+        return pid > 0 && kill(pid, 0) == 0;
+    }
+};
+
+MemorySource* CreateMemorySource(DWORD processId) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%lu/maps", (unsigned long)processId);
+    FILE* maps = fopen(path, "r");
+    if (!maps) {
+        LOG_ERROR("Process %lu not found or not accessible", (unsigned long)processId);
+        return nullptr;
+    }
+    fclose(maps);
+    return new LinuxMemorySource((pid_t)processId);
+}
+
+#endif
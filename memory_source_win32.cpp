@@ -0,0 +1,198 @@
+#ifdef _WIN32
+
+#include <windows.h>
+#include <psapi.h>
+#include <string.h>
+#include <algorithm>
+#include "memory_source.h"
+#include "memory_protection.h"
+#include "logging.h"
+
+class WindowsMemorySource : public MemorySource {
+private:
+    HANDLE processHandle;   // Handle used for queries and reads
+    HANDLE writeHandle;     // Lazily opened handle with VM_WRITE access
+    DWORD pid;
+    bool ownsHandle;
+
+    static void fillRegion(const MEMORY_BASIC_INFORMATION& mbi, MemoryRegion* region) {
+        region->base = (uintptr_t)mbi.BaseAddress;
+        region->size = mbi.RegionSize;
+        region->protect = mbi.Protect;
+        region->state = mbi.State;
+        region->type = mbi.Type;
+    }
+
+public:
+    WindowsMemorySource(HANDLE handle, DWORD processId, bool ownsHandle)
+        : processHandle(handle), writeHandle(NULL), pid(processId), ownsHandle(ownsHandle) {}
+
+    ~WindowsMemorySource() {
+        if (writeHandle) {
+            CloseHandle(writeHandle);
+        }
+        if (ownsHandle && processHandle) {
+            CloseHandle(processHandle);
+        }
+    }
+
+    bool enumerateRegions(std::vector<MemoryRegion>& regions) override {
+        SYSTEM_INFO sysInfo;
+        GetSystemInfo(&sysInfo);
+
+        regions.clear();
+        uintptr_t address = (uintptr_t)sysInfo.lpMinimumApplicationAddress;
+        uintptr_t maxAddress = (uintptr_t)sysInfo.lpMaximumApplicationAddress;
+
+        while (address < maxAddress) {
+            MEMORY_BASIC_INFORMATION mbi;
+            if (VirtualQueryEx(processHandle, (LPCVOID)address, &mbi, sizeof(mbi)) == 0) {
+                break;
+            }
+
+            MemoryRegion region;
+            fillRegion(mbi, &region);
+            regions.push_back(region);
+
+            address = (uintptr_t)mbi.BaseAddress + mbi.RegionSize;
+        }
+
+        return !regions.empty();
+    }
+
+    bool enumerateModules(std::vector<ModuleInfo>& modules) override {
+        modules.clear();
+
+        DWORD needed = 0;
+        if (!EnumProcessModulesEx(processHandle, NULL, 0, &needed, LIST_MODULES_ALL) || needed == 0) {
+            LOG_ERROR("Failed to enumerate modules of process %lu, error code: %lu", pid, GetLastError());
+            return false;
+        }
+        std::vector<HMODULE> handles(needed / sizeof(HMODULE));
+        if (!EnumProcessModulesEx(processHandle, handles.data(), (DWORD)(handles.size() * sizeof(HMODULE)),
+                                  &needed, LIST_MODULES_ALL)) {
+            return false;
+        }
+        handles.resize(std::min(handles.size(), (size_t)(needed / sizeof(HMODULE))));
+
+        for (size_t i = 0; i < handles.size(); i++) {
+            MODULEINFO info;
+            if (!GetModuleInformation(processHandle, handles[i], &info, sizeof(info))) {
+                continue;
+            }
+            ModuleInfo module;
+            module.base = (uintptr_t)info.lpBaseOfDll;
+            module.size = info.SizeOfImage;
+            if (GetModuleBaseNameA(processHandle, handles[i], module.name, sizeof(module.name)) == 0) {
+                strcpy_s(module.name, sizeof(module.name), "?");
+            }
+            modules.push_back(module);
+        }
+
+        std::sort(modules.begin(), modules.end(),
+                  [](const ModuleInfo& a, const ModuleInfo& b) { return a.base < b.base; });
+        return !modules.empty();
+    }
+
+    bool queryRegion(uintptr_t address, MemoryRegion* region) override {
+        MEMORY_BASIC_INFORMATION mbi;
+        if (VirtualQueryEx(processHandle, (LPCVOID)address, &mbi, sizeof(mbi)) == 0) {
+            return false;
+        }
+        fillRegion(mbi, region);
+        return true;
+    }
+
+    bool read(uintptr_t address, void* buffer, size_t size, size_t* bytesRead) override {
+        SIZE_T actual = 0;
+        BOOL result = ReadProcessMemory(processHandle, (LPCVOID)address, buffer, size, &actual);
+        if (bytesRead) {
+            *bytesRead = actual;
+        }
+        return result && actual == size;
+    }
+
+    size_t readScatter(ScatterEntry* entries, size_t count) override {
+        // Windows has no vectored cross-process read, so this is a plain loop.
+        size_t completed = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (read(entries[i].address, entries[i].buffer, entries[i].size, &entries[i].bytesRead)) {
+                completed++;
+            }
+        }
+        return completed;
+    }
+
+    // The working set only says whether a page is mapped in right now, so
+    // every page outside it counts as paged out: trimmed pages still on the
+    // standby and modified lists, and untouched demand-zero pages, cannot
+    // be told apart from ones in the page file. skipSwappedPages is
+    // therefore off by default on Windows.
+    bool queryResidency(uintptr_t address, size_t pageCount, BYTE* flags) override {
+        PSAPI_WORKING_SET_EX_INFORMATION info[512];
+        size_t done = 0;
+        while (done < pageCount) {
+            size_t batch = std::min(pageCount - done, sizeof(info) / sizeof(info[0]));
+            for (size_t i = 0; i < batch; i++) {
+                info[i].VirtualAddress = (PVOID)(address + (done + i) * RESIDENCY_PAGE_SIZE);
+            }
+            if (!QueryWorkingSetEx(processHandle, info, (DWORD)(batch * sizeof(info[0])))) {
+                return false;
+            }
+            for (size_t i = 0; i < batch; i++) {
+                flags[done + i] = info[i].VirtualAttributes.Valid ? PAGE_RESIDENT : PAGE_SWAPPED;
+            }
+            done += batch;
+        }
+        return true;
+    }
+
+    bool write(uintptr_t address, const void* buffer, size_t size, size_t* bytesWritten) override {
+        if (!writeHandle) {
+            writeHandle = OpenProcess(PROCESS_VM_READ | PROCESS_VM_WRITE | PROCESS_VM_OPERATION |
+                                      PROCESS_QUERY_INFORMATION, FALSE, pid);
+            if (!writeHandle) {
+                LOG_ERROR("Failed to open process %lu with write permissions", pid);
+                return false;
+            }
+        }
+
+        SIZE_T actual = 0;
+        BOOL result = WriteProcessMemory(writeHandle, (LPVOID)address, buffer, size, &actual);
+        if (bytesWritten) {
+            *bytesWritten = actual;
+        }
+        if (!result) {
+            DWORD error = GetLastError();
+            LOG_ERROR("Failed to write to address 0x%p (Error: %lu - %s)",
+                     (LPVOID)address, error, GetLastErrorAsString(error));
+        }
+        return result && actual == size;
+    }
+
+    DWORD processId() const override {
+        return pid;
+    }
+
+    bool isValid() const override {
+        return processHandle != NULL;
+    }
+};
+
+MemorySource* CreateMemorySource(DWORD processId) {
+    HANDLE handle = OpenProcess(PROCESS_VM_READ | PROCESS_QUERY_INFORMATION, FALSE, processId);
+    if (!handle) {
+        LOG_ERROR("Failed to open process %lu, error code: %lu", processId, GetLastError());
+        return nullptr;
+    }
+    return new WindowsMemorySource(handle, processId, true);
+}
+
+MemorySource* CreateMemorySourceFromHandle(HANDLE processHandle, DWORD processId) {
+    if (!processHandle) {
+        return nullptr;
+    }
+    return new WindowsMemorySource(processHandle, processId, false);
+}
+
+#endif
@@ -0,0 +1,440 @@
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+
+#include "multi_scan.h"
+#include "scan_buffer_pool.h"
+#include "logging.h"
+
+static const struct {
+    const char* name;
+    ValueType type;
+} kTargetTypeNames[] = {
+    { "int", VALUE_TYPE_INT },
+    { "float", VALUE_TYPE_FLOAT },
+    { "double", VALUE_TYPE_DOUBLE },
+    { "short", VALUE_TYPE_SHORT },
+    { "byte", VALUE_TYPE_BYTE },
+    { "auto", VALUE_TYPE_AUTO },
+    { "int64", VALUE_TYPE_INT64 },
+    { "uint16", VALUE_TYPE_UINT16 },
+    { "uint32", VALUE_TYPE_UINT32 },
+    { "uint64", VALUE_TYPE_UINT64 },
+};
+
+const char* GetValueTypeName(ValueType type) {
+    for (size_t i = 0; i < sizeof(kTargetTypeNames) / sizeof(kTargetTypeNames[0]); i++) {
+        if (kTargetTypeNames[i].type == type) {
+            return kTargetTypeNames[i].name;
+        }
+    }
+    return "int";
+}
+
+bool parseValueTypeName(const char* name, size_t length, ValueType* type) {
+    for (size_t i = 0; i < sizeof(kTargetTypeNames) / sizeof(kTargetTypeNames[0]); i++) {
+        if (strlen(kTargetTypeNames[i].name) == length && _strnicmp(name, kTargetTypeNames[i].name, length) == 0) {
+            *type = kTargetTypeNames[i].type;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseScanTargets(const char* text, ValueType defaultType, std::vector<ScanTarget>& targets) {
+    targets.clear();
+    const char* p = text;
+    while (*p) {
+        while (*p == ' ' || *p == ',') p++;
+        if (!*p) break;
+
+        ScanTarget target = { defaultType, MakeScanValue(0) };
+        const char* colon = strchr(p, ':');
+        const char* comma = strchr(p, ',');
+        if (colon && (!comma || colon < comma)) {
+            if (!parseValueTypeName(p, colon - p, &target.type)) {
+                LOG_ERROR("Unknown value type in \"%s\"", text);
+                return false;
+            }
+            p = colon + 1;
+        }
+
+        const char* end = nullptr;
+        if (!parseScanValue(p, target.type, &target.value, &end) || (*end && *end != ',' && *end != ' ')) {
+            LOG_ERROR("Malformed value in \"%s\"", text);
+            return false;
+        }
+        targets.push_back(target);
+        p = end;
+    }
+
+    if (targets.empty() || targets.size() > MAX_SCAN_TARGETS) {
+        LOG_ERROR("Expected 1 to %zu values, got %zu", MAX_SCAN_TARGETS, targets.size());
+        return false;
+    }
+    return true;
+}
+
+static uint32_t TargetKey(const ScanValue& value, ValueType type) {
+    switch (type) {
+        case VALUE_TYPE_BYTE: return (uint32_t)value.i & 0xFF;
+        case VALUE_TYPE_SHORT:
+        case VALUE_TYPE_UINT16: return (uint32_t)value.i & 0xFFFF;
+        default: return (uint32_t)value.i;
+    }
+}
+
+// Finds a multiplier that sends every member key to its own slot, growing
+// the table when a size runs out of tries. Returns false if none is found.
+static bool BuildTargetTable(ValueType type, const std::vector<ScanTarget>& targets,
+                             const std::vector<size_t>& members, ScanTargetTable* table) {
+    table->type = type;
+    int bits = 4;
+    while (((size_t)1 << bits) < members.size() * 2) {
+        bits++;
+    }
+
+    uint32_t seed = 0x9E3779B1u;
+    for (; bits <= 16; bits++) {
+        size_t size = (size_t)1 << bits;
+        for (int attempt = 0; attempt < 256; attempt++) {
+            uint32_t multiplier = seed | 1;
+            seed = seed * 1664525u + 1013904223u;
+
+            table->keys.assign(size, 0);
+            table->targets.assign(size, -1);
+            bool perfect = true;
+            for (size_t m = 0; m < members.size() && perfect; m++) {
+                uint32_t key = TargetKey(targets[members[m]].value, type);
+                uint32_t slot = (key * multiplier) >> (32 - bits);
+                if (table->targets[slot] >= 0) {
+                    perfect = false;
+                } else {
+                    table->keys[slot] = key;
+                    table->targets[slot] = (int32_t)members[m];
+                }
+            }
+            if (perfect) {
+                table->multiplier = multiplier;
+                table->shift = 32 - bits;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static bool BuildMultiScanPlan(const std::vector<ScanTarget>& targets, MultiScanPlan* plan) {
+    plan->broadcast.clear();
+    plan->tables.clear();
+    plan->overlap = 0;
+
+    // Exact integer targets grouped by type; a repeated target never matches
+    // on its own, the first one with the same type and value takes its hits.
+    const ValueType exactTypes[] = { VALUE_TYPE_INT, VALUE_TYPE_UINT32, VALUE_TYPE_SHORT, VALUE_TYPE_UINT16,
+                                     VALUE_TYPE_BYTE };
+    const size_t exactGroups = sizeof(exactTypes) / sizeof(exactTypes[0]);
+    std::vector<size_t> exact[exactGroups];
+    for (size_t t = 0; t < targets.size(); t++) {
+        const ScanTarget& target = targets[t];
+        BYTE bytes[sizeof(uint64_t)];
+        size_t size = EncodeScanValue(target.value, target.type, bytes);
+        bool duplicate = false;
+        for (size_t u = 0; u < t && !duplicate; u++) {
+            BYTE other[sizeof(uint64_t)];
+            duplicate = targets[u].type == target.type &&
+                        EncodeScanValue(targets[u].value, target.type, other) == size &&
+                        memcmp(other, bytes, size) == 0 &&
+                        (target.type != VALUE_TYPE_AUTO || targets[u].value.f == target.value.f);
+        }
+        if (duplicate) {
+            LOG_WARNING("Target %zu repeats an earlier target and is skipped", t);
+            continue;
+        }
+
+        SIZE_T readSize = target.type == VALUE_TYPE_AUTO ? sizeof(double) : GetValueTypeSize(target.type);
+        plan->overlap = std::max(plan->overlap, readSize - 1);
+
+        size_t group = 0;
+        while (group < exactGroups && exactTypes[group] != target.type) {
+            group++;
+        }
+        if (group < exactGroups) {
+            exact[group].push_back(t);
+        } else {
+            plan->broadcast.push_back(t);
+        }
+    }
+
+    for (size_t group = 0; group < exactGroups; group++) {
+        if (exact[group].size() < MULTI_SCAN_HASH_MIN) {
+            plan->broadcast.insert(plan->broadcast.end(), exact[group].begin(), exact[group].end());
+            continue;
+        }
+        ScanTargetTable table;
+        if (BuildTargetTable(exactTypes[group], targets, exact[group], &table)) {
+            LOG_DEBUG("Hashing %zu %s targets into %zu slots", exact[group].size(),
+                      GetValueTypeName(exactTypes[group]), table.keys.size());
+            plan->tables.push_back(table);
+        } else {
+            plan->broadcast.insert(plan->broadcast.end(), exact[group].begin(), exact[group].end());
+        }
+    }
+    std::sort(plan->broadcast.begin(), plan->broadcast.end());
+    return !plan->broadcast.empty() || !plan->tables.empty();
+}
+
+// One probe per position: hash the value, then confirm the slot's key.
+template<typename T>
+static void LookupTargetTable(const ScanTargetTable& table, const BYTE* block, size_t limit, size_t available,
+                              size_t stride, std::vector<std::pair<uint32_t, uint32_t> >& hits) {
+    const uint32_t* keys = table.keys.data();
+    const int32_t* slots = table.targets.data();
+    const uint32_t multiplier = table.multiplier;
+    const int shift = table.shift;
+    size_t end = std::min(limit, available >= sizeof(T) ? available - sizeof(T) + 1 : 0);
+    for (size_t pos = 0; pos < end; pos += stride) {
+        T value;
+        memcpy(&value, block + pos, sizeof(T));
+        uint32_t key = value;
+        uint32_t slot = (key * multiplier) >> shift;
+        if (keys[slot] == key && slots[slot] >= 0) {
+            hits.push_back(std::make_pair((uint32_t)pos, (uint32_t)slots[slot]));
+        }
+    }
+}
+
+static bool compareMultiScanMatches(const MultiScanMatch& a, const MultiScanMatch& b) {
+    return a.address < b.address || (a.address == b.address && a.target < b.target);
+}
+
+size_t scanMultipleValues(ProcessInfo* process, const std::vector<ScanTarget>& targets,
+                          std::vector<MultiScanMatch>& matches) {
+    matches.clear();
+    if (!process || !process->memory || !process->settings) {
+        LOG_ERROR("Invalid process handle");
+        return 0;
+    }
+
+    MultiScanPlan plan;
+    if (targets.empty() || !BuildMultiScanPlan(targets, &plan)) {
+        return 0;
+    }
+
+    bool searchingForZero = false;
+    for (size_t t = 0; t < targets.size(); t++) {
+        searchingForZero = searchingForZero || (targets[t].value.i == 0 && targets[t].value.f == 0.0);
+    }
+
+    g_cancelScan = false;
+    g_scanInProgress = true;
+    g_regionsScanned = 0;
+    g_bytesScanned = 0;
+    g_bytesSkipped = 0;
+    g_matchesFound = 0;
+    g_regionsSkipped = 0;
+
+    std::vector<MemoryRegion> allRegions;
+    process->memory->refreshRegions();
+    process->memory->enumerateRegions(allRegions);
+
+    const SIZE_T chunkSize = GetScanChunkSize(process->settings);
+    std::vector<ScanChunk> chunks;
+    std::vector<size_t> chunksPerRegion;
+    size_t totalBytes = 0;
+    for (const auto& region : allRegions) {
+        if (IsLikelyValidDataRegion(region, searchingForZero)) {
+            chunksPerRegion.push_back(AddRegionChunks(region.base, region.size, chunksPerRegion.size(),
+                                                      chunkSize, chunks));
+            totalBytes += region.size;
+        } else if (region.state == MEM_COMMIT) {
+            g_regionsSkipped++;
+        }
+    }
+
+    std::unique_ptr<std::atomic<size_t>[]> regionChunksLeft(new std::atomic<size_t>[chunksPerRegion.size()]);
+    for (size_t r = 0; r < chunksPerRegion.size(); r++) {
+        regionChunksLeft[r] = chunksPerRegion[r];
+    }
+    std::unique_ptr<std::atomic<size_t>[]> targetMatches(new std::atomic<size_t>[targets.size()]);
+    for (size_t t = 0; t < targets.size(); t++) {
+        targetMatches[t] = 0;
+    }
+    g_totalRegionsToScan = chunksPerRegion.size();
+    g_totalMemoryToScan = totalBytes;
+
+    int threadCount = GetScanThreadCount(process->settings);
+    if ((size_t)threadCount > chunks.size()) {
+        threadCount = chunks.empty() ? 1 : (int)chunks.size();
+    }
+
+    LOG_INFO("Scanning %zu regions (%zu MB) for %zu values (%zu compared, %zu hashed) on %d threads",
+             chunksPerRegion.size(), totalBytes / (1024 * 1024), targets.size(), plan.broadcast.size(),
+             plan.tables.size(), threadCount);
+
+    WorkStealingQueue<ScanChunk> queue(threadCount);
+    queue.distribute(chunks);
+
+    std::vector<std::vector<MultiScanMatch> > shards(threadCount);
+    std::vector<MultiScanThreadData> threadData(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        threadData[i].process = process;
+        threadData[i].targets = &targets;
+        threadData[i].plan = &plan;
+        threadData[i].targetMatches = targetMatches.get();
+        threadData[i].shard = &shards[i];
+        threadData[i].queue = &queue;
+        threadData[i].workerIndex = i;
+        threadData[i].regionChunksLeft = regionChunksLeft.get();
+    }
+    RunScanWorkers(multiScanThreadFunc, threadData, process->settings);
+
+    g_scanInProgress = false;
+    g_scanProgress = 1.0;
+
+    size_t total = 0;
+    for (size_t i = 0; i < shards.size(); i++) {
+        total += shards[i].size();
+    }
+    matches.reserve(total);
+    for (size_t i = 0; i < shards.size(); i++) {
+        matches.insert(matches.end(), shards[i].begin(), shards[i].end());
+        std::vector<MultiScanMatch>().swap(shards[i]);
+    }
+    std::sort(matches.begin(), matches.end(), compareMultiScanMatches);
+
+    LOG_INFO("Multi-value scan %s: %zu matches in %zu MB (%zu steals)", g_cancelScan ? "cancelled" : "done",
+             matches.size(), g_bytesScanned.load() / (1024 * 1024), queue.steals());
+    return matches.size();
+}
+
+bool writeMultiScanMatches(const char* filename, const std::vector<ScanTarget>& targets,
+                           const std::vector<MultiScanMatch>& matches) {
+    FILE* file = filename ? fopen(filename, "w") : stdout;
+    if (!file) {
+        LOG_ERROR("Failed to open %s for writing", filename);
+        return false;
+    }
+
+    fprintf(file, "target,type,value,address\n");
+    for (size_t i = 0; i < matches.size(); i++) {
+        const ScanTarget& target = targets[matches[i].target];
+        BYTE bytes[sizeof(uint64_t)];
+        char value[32];
+        FormatScanValue(bytes, EncodeScanValue(target.value, target.type, bytes), target.type, value, sizeof(value));
+        fprintf(file, "%u,%s,%s,0x%llX\n", matches[i].target, GetValueTypeName(target.type), value,
+                (unsigned long long)matches[i].address);
+    }
+
+    bool ok = !ferror(file);
+    if (filename) {
+        ok = fclose(file) == 0 && ok;
+    }
+    if (!ok) {
+        LOG_ERROR("Failed to write multi-value matches to %s", filename ? filename : "stdout");
+    }
+    return ok;
+}
+
+unsigned __stdcall multiScanThreadFunc(void* arg) {
+    MultiScanThreadData* data = static_cast<MultiScanThreadData*>(arg);
+    if (!data || !data->process || !data->process->memory || !data->targets || !data->plan ||
+        !data->targetMatches || !data->shard || !data->queue) {
+        LOG_ERROR("Invalid thread data");
+        return 1;
+    }
+
+    DWORD threadId = GetCurrentThreadId();
+    MemorySource* memory = data->process->memory;
+    const Settings* settings = data->process->settings;
+    const std::vector<ScanTarget>& targets = *data->targets;
+    const MultiScanPlan& plan = *data->plan;
+    std::vector<MultiScanMatch>& shard = *data->shard;
+    const ScanKernelLevel kernelLevel = settings->useVectorizedOperations ?
+                                        GetScanKernelLevel() : SCAN_KERNEL_SCALAR;
+    const double epsilon = GetScanEpsilon(settings);
+
+    try {
+        const SIZE_T chunkSize = GetScanChunkSize(settings);
+        ScanBuffer buffer(chunkSize + plan.overlap, settings);
+        std::vector<uint32_t> offsets(MULTI_SCAN_BLOCK + 1);
+        std::vector<std::pair<uint32_t, uint32_t> > hits;  // Offset in block, target
+
+        ScanChunk chunk;
+        while (!g_cancelScan && data->queue->next(data->workerIndex, &chunk)) {
+            SIZE_T bytesToRead = chunk.size + std::min(plan.overlap, (SIZE_T)(chunk.regionEnd - chunk.address - chunk.size));
+            SIZE_T actualRead = 0;
+            memory->read(chunk.address, buffer.data(), bytesToRead, &actualRead);
+
+            // Every target sees a block while it is still in L1.
+            for (SIZE_T blockStart = 0; blockStart < chunk.size && blockStart < actualRead;
+                 blockStart += MULTI_SCAN_BLOCK) {
+                const BYTE* block = buffer.data() + blockStart;
+                size_t available = actualRead - blockStart;
+                size_t limit = std::min((size_t)MULTI_SCAN_BLOCK, (size_t)(chunk.size - blockStart));
+                hits.clear();
+
+                for (size_t b = 0; b < plan.broadcast.size(); b++) {
+                    size_t t = plan.broadcast[b];
+                    if (data->targetMatches[t] >= MULTI_SCAN_MAX_MATCHES) {
+                        continue;
+                    }
+                    const ScanTarget& target = targets[t];
+                    size_t count = FindValueOffsets(block, available, limit, target.value, target.type,
+                                                    GetScanStride(settings, target.type), epsilon,
+                                                    offsets.data(), kernelLevel);
+                    for (size_t h = 0; h < count; h++) {
+                        hits.push_back(std::make_pair(offsets[h], (uint32_t)t));
+                    }
+                }
+
+                for (size_t k = 0; k < plan.tables.size(); k++) {
+                    const ScanTargetTable& table = plan.tables[k];
+                    const size_t stride = GetScanStride(settings, table.type);
+                    switch (table.type) {
+                        case VALUE_TYPE_BYTE:
+                            LookupTargetTable<uint8_t>(table, block, limit, available, stride, hits);
+                            break;
+                        case VALUE_TYPE_SHORT:
+                        case VALUE_TYPE_UINT16:
+                            LookupTargetTable<uint16_t>(table, block, limit, available, stride, hits);
+                            break;
+                        default:
+                            LookupTargetTable<uint32_t>(table, block, limit, available, stride, hits);
+                            break;
+                    }
+                }
+
+                if (plan.broadcast.size() + plan.tables.size() > 1) {
+                    std::sort(hits.begin(), hits.end());
+                }
+                for (size_t h = 0; h < hits.size(); h++) {
+                    uint32_t t = hits[h].second;
+                    if (data->targetMatches[t]++ >= MULTI_SCAN_MAX_MATCHES) {
+                        continue;
+                    }
+                    MultiScanMatch match = { chunk.address + blockStart + hits[h].first, t };
+                    shard.push_back(match);
+                }
+                g_matchesFound += hits.size();
+            }
+
+            g_bytesScanned += std::min(actualRead, chunk.size);
+            if (--data->regionChunksLeft[chunk.regionIndex] == 0) {
+                g_regionsScanned++;
+                if (g_totalRegionsToScan > 0) {
+                    g_scanProgress = (double)g_regionsScanned / g_totalRegionsToScan;
+                }
+            }
+        }
+
+    } catch (const std::exception& e) {
+        LOG_ERROR("Thread %lu error: %s", threadId, e.what());
+    }
+
+    LOG_DEBUG("Thread %lu: Found %zu multi-value matches", threadId, shard.size());
+    return 0;
+}
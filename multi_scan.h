@@ -0,0 +1,77 @@
+#pragma once
+
+#include "platform.h"
+#include <stdint.h>
+#include <vector>
+
+#include "scan_engine.h"
+
+// Multi-value scan: one read pass over memory tests every chunk against a
+// small set of targets, each with its own value and type. Chunks are
+// walked in L1-sized blocks; inside a block each target runs the regular
+// broadcast-compare kernels (FindValueOffsets), so the set shares the
+// memory traffic of a single scan. Once MULTI_SCAN_HASH_MIN or more exact
+// integer targets share a type, they are looked up instead in a
+// collision-free multiplicative hash table, one probe per position
+// whatever the set size.
+// Matches are tagged with the index of the target they hit.
+
+const size_t MAX_SCAN_TARGETS = 256;
+const size_t MULTI_SCAN_BLOCK = 16 * 1024;
+const size_t MULTI_SCAN_HASH_MIN = 16;
+const size_t MULTI_SCAN_MAX_MATCHES = 1000000;    // Per target
+
+typedef struct {
+    ValueType type;
+    ScanValue value;
+} ScanTarget;
+
+typedef struct {
+    uintptr_t address;
+    uint32_t target;        // Index into the scanned targets
+} MultiScanMatch;
+
+// Exact targets of one integer type. slot = (key * multiplier) >> shift
+// holds its key and target, or target -1 when empty.
+typedef struct {
+    ValueType type;
+    uint32_t multiplier;
+    int shift;
+    std::vector<uint32_t> keys;
+    std::vector<int32_t> targets;
+} ScanTargetTable;
+
+typedef struct {
+    std::vector<size_t> broadcast;          // Targets compared one at a time
+    std::vector<ScanTargetTable> tables;    // Hashed exact targets, one per type
+    SIZE_T overlap;                         // Widest target size - 1
+} MultiScanPlan;
+
+typedef struct {
+    ProcessInfo* process;
+    const std::vector<ScanTarget>* targets;
+    const MultiScanPlan* plan;
+    std::atomic<size_t>* targetMatches;     // Matches so far per target
+    std::vector<MultiScanMatch>* shard;
+    WorkStealingQueue<ScanChunk>* queue;
+    int workerIndex;
+    std::atomic<size_t>* regionChunksLeft;
+} MultiScanThreadData;
+
+// Parses "100,250,float:3,short:-1": comma separated values, each with an
+// optional type prefix; values without one use defaultType.
+bool parseScanTargets(const char* text, ValueType defaultType, std::vector<ScanTarget>& targets);
+const char* GetValueTypeName(ValueType type);
+// Matches the first length characters of name against int, float, ...
+bool parseValueTypeName(const char* name, size_t length, ValueType* type);
+
+// Scans the same regions as scanMemory for every target. matches come back
+// sorted by address, then target.
+size_t scanMultipleValues(ProcessInfo* process, const std::vector<ScanTarget>& targets,
+                          std::vector<MultiScanMatch>& matches);
+
+// Writes target,type,value,address lines to filename (stdout when nullptr).
+bool writeMultiScanMatches(const char* filename, const std::vector<ScanTarget>& targets,
+                           const std::vector<MultiScanMatch>& matches);
+
+unsigned __stdcall multiScanThreadFunc(void* arg);
@@ -0,0 +1,480 @@
+#include "platform.h"
+#include <immintrin.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+#include <memory>
+
+#include "pattern_scan.h"
+#include "pointer_scan.h"
+#include "scan_buffer_pool.h"
+#include "logging.h"
+
+#define KERNEL_SSE2 __attribute__((target("sse2")))
+#define KERNEL_AVX2 __attribute__((target("avx2")))
+#define KERNEL_AVX512 __attribute__((target("avx512f,avx512bw")))
+#define KERNEL_INLINE inline __attribute__((always_inline))
+
+// Rough weight of a byte value in x86-64 code: REX prefixes, ModRM/SIB
+// bytes of common stack and register forms, the mov/lea/call/jcc opcodes
+// and the small displacements and immediates. Everything else weighs 1.
+static int CodeByteWeight(BYTE b) {
+    switch (b) {
+        case 0x00: return 64;
+        case 0xFF: case 0x48: case 0x8B: return 24;
+        case 0x89: case 0x24: case 0x44: case 0x4C: case 0x0F: case 0xE8: case 0xCC: return 12;
+        case 0x85: case 0xC0: case 0x01: case 0x83: case 0x74: case 0x75: case 0x8D: case 0x90:
+        case 0x10: case 0x20: case 0x08: case 0x40: case 0x41: case 0x45: case 0x49: case 0x4D:
+        case 0x33: case 0xC3: case 0xEB: case 0x18: case 0x28: case 0x30: case 0x38: case 0x5C:
+        case 0x54: case 0x6C: case 0x84: case 0xC7: case 0xF8: case 0x02: case 0x04: return 6;
+        default: return 1;
+    }
+}
+
+static int ParseHexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool compileBytePattern(const char* text, BytePattern* pattern) {
+    pattern->bytes.clear();
+    pattern->mask.clear();
+    pattern->length = 0;
+
+    const char* p = text;
+    while (*p) {
+        if (isspace((unsigned char)*p)) {
+            p++;
+            continue;
+        }
+
+        // A lone "?" is a whole wildcard byte, as is "??".
+        if (p[0] == '?' && (p[1] == '\0' || isspace((unsigned char)p[1]))) {
+            pattern->bytes.push_back(0);
+            pattern->mask.push_back(0);
+            p++;
+            continue;
+        }
+        if (!p[1] || (p[2] && !isspace((unsigned char)p[2]))) {
+            LOG_ERROR("Malformed byte in signature \"%s\" at offset %d", text, (int)(p - text));
+            return false;
+        }
+
+        BYTE value = 0;
+        BYTE mask = 0;
+        for (int n = 0; n < 2; n++) {
+            int shift = n == 0 ? 4 : 0;
+            if (p[n] == '?') {
+                continue;
+            }
+            int nibble = ParseHexNibble(p[n]);
+            if (nibble < 0) {
+                LOG_ERROR("Malformed byte in signature \"%s\" at offset %d", text, (int)(p - text));
+                return false;
+            }
+            value |= (BYTE)(nibble << shift);
+            mask |= (BYTE)(0xF << shift);
+        }
+        pattern->bytes.push_back(value);
+        pattern->mask.push_back(mask);
+        p += 2;
+    }
+
+    pattern->length = pattern->bytes.size();
+    if (pattern->length == 0 || pattern->length > MAX_PATTERN_LENGTH) {
+        LOG_ERROR("Signature \"%s\" must be 1 to %zu bytes long", text, MAX_PATTERN_LENGTH);
+        return false;
+    }
+
+    // The two rarest fixed bytes anchor the prefilter. A signature with a
+    // single fixed byte compares it twice.
+    size_t best[2] = { (size_t)-1, (size_t)-1 };
+    for (size_t i = 0; i < pattern->length; i++) {
+        if (pattern->mask[i] != 0xFF) {
+            continue;
+        }
+        int weight = CodeByteWeight(pattern->bytes[i]);
+        if (best[0] == (size_t)-1 || weight < CodeByteWeight(pattern->bytes[best[0]])) {
+            best[1] = best[0];
+            best[0] = i;
+        } else if (best[1] == (size_t)-1 || weight < CodeByteWeight(pattern->bytes[best[1]])) {
+            best[1] = i;
+        }
+    }
+    if (best[0] == (size_t)-1) {
+        LOG_ERROR("Signature \"%s\" needs at least one fully fixed byte", text);
+        return false;
+    }
+    if (best[1] == (size_t)-1) {
+        best[1] = best[0];
+    }
+    pattern->anchor[0] = std::min(best[0], best[1]);
+    pattern->anchor[1] = std::max(best[0], best[1]);
+
+    size_t padded = (pattern->length + 15) & ~(size_t)15;
+    pattern->bytes.resize(padded, 0);
+    pattern->mask.resize(padded, 0);
+    return true;
+}
+
+// Masked compare of a candidate, 16 bytes at a time. p may be read up to
+// the padded pattern length.
+static KERNEL_INLINE bool PatternVerify(const BytePattern& pattern, const BYTE* p) {
+    for (size_t i = 0; i < pattern.bytes.size(); i += 16) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i m = _mm_loadu_si128((const __m128i*)(pattern.mask.data() + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(pattern.bytes.data() + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(d, m), b)) != 0xFFFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Sse2PairKernel {
+    enum { WIDTH = 16 };
+    __m128i first, second;
+
+    KERNEL_SSE2 void init(BYTE a, BYTE b) {
+        first = _mm_set1_epi8((char)a);
+        second = _mm_set1_epi8((char)b);
+    }
+
+    KERNEL_SSE2 uint64_t candidates(const BYTE* p, size_t distance) const {
+        __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), first);
+        __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + distance)), second);
+        return (uint32_t)_mm_movemask_epi8(_mm_and_si128(a, b));
+    }
+};
+
+struct Avx2PairKernel {
+    enum { WIDTH = 32 };
+    __m256i first, second;
+
+    KERNEL_AVX2 void init(BYTE a, BYTE b) {
+        first = _mm256_set1_epi8((char)a);
+        second = _mm256_set1_epi8((char)b);
+    }
+
+    KERNEL_AVX2 uint64_t candidates(const BYTE* p, size_t distance) const {
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), first);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + distance)), second);
+        return (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(a, b));
+    }
+};
+
+struct Avx512PairKernel {
+    enum { WIDTH = 64 };
+    __m512i first, second;
+
+    KERNEL_AVX512 void init(BYTE a, BYTE b) {
+        first = _mm512_set1_epi8((char)a);
+        second = _mm512_set1_epi8((char)b);
+    }
+
+    KERNEL_AVX512 uint64_t candidates(const BYTE* p, size_t distance) const {
+        __mmask64 a = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void*)p), first);
+        return _mm512_mask_cmpeq_epi8_mask(a, _mm512_loadu_si512((const void*)(p + distance)), second);
+    }
+};
+
+// Appends the offset of every match starting in [0, limit), up to maxHits.
+// buffer must be readable up to limit + WIDTH + the padded pattern length.
+template<typename K>
+static KERNEL_INLINE void PatternRunBlocks(const BytePattern& pattern, const BYTE* buffer, size_t limit,
+                                           size_t maxHits, std::vector<uint32_t>& hits) {
+    K k;
+    k.init(pattern.bytes[pattern.anchor[0]], pattern.bytes[pattern.anchor[1]]);
+    const size_t distance = pattern.anchor[1] - pattern.anchor[0];
+    const BYTE* anchor = buffer + pattern.anchor[0];
+
+    for (size_t base = 0; base < limit; base += K::WIDTH) {
+        uint64_t mask = k.candidates(anchor + base, distance);
+        if (base + K::WIDTH > limit) {
+            mask &= (1ULL << (limit - base)) - 1;
+        }
+        while (mask) {
+            size_t offset = base + __builtin_ctzll(mask);
+            mask &= mask - 1;
+            if (PatternVerify(pattern, buffer + offset)) {
+                if (hits.size() >= maxHits) {
+                    return;
+                }
+                hits.push_back((uint32_t)offset);
+            }
+        }
+    }
+}
+
+KERNEL_SSE2 static void MatchPatternSse2(const BytePattern& pattern, const BYTE* buffer, size_t limit,
+                                         size_t maxHits, std::vector<uint32_t>& hits) {
+    PatternRunBlocks<Sse2PairKernel>(pattern, buffer, limit, maxHits, hits);
+}
+
+KERNEL_AVX2 static void MatchPatternAvx2(const BytePattern& pattern, const BYTE* buffer, size_t limit,
+                                         size_t maxHits, std::vector<uint32_t>& hits) {
+    PatternRunBlocks<Avx2PairKernel>(pattern, buffer, limit, maxHits, hits);
+}
+
+KERNEL_AVX512 static void MatchPatternAvx512(const BytePattern& pattern, const BYTE* buffer, size_t limit,
+                                             size_t maxHits, std::vector<uint32_t>& hits) {
+    PatternRunBlocks<Avx512PairKernel>(pattern, buffer, limit, maxHits, hits);
+}
+
+static void MatchPatternScalar(const BytePattern& pattern, const BYTE* buffer, size_t limit,
+                               size_t maxHits, std::vector<uint32_t>& hits) {
+    const BYTE first = pattern.bytes[pattern.anchor[0]];
+    const BYTE second = pattern.bytes[pattern.anchor[1]];
+    for (size_t offset = 0; offset < limit && hits.size() < maxHits; offset++) {
+        if (buffer[offset + pattern.anchor[0]] != first || buffer[offset + pattern.anchor[1]] != second) {
+            continue;
+        }
+        size_t i = 0;
+        while (i < pattern.length && (buffer[offset + i] & pattern.mask[i]) == pattern.bytes[i]) {
+            i++;
+        }
+        if (i == pattern.length) {
+            hits.push_back((uint32_t)offset);
+        }
+    }
+}
+
+static bool IsExecutableProtection(DWORD protect) {
+    return (protect & (PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)) != 0;
+}
+
+static bool comparePatternMatches(const PatternMatch& a, const PatternMatch& b) {
+    return a.pattern < b.pattern || (a.pattern == b.pattern && a.address < b.address);
+}
+
+size_t scanBytePatterns(ProcessInfo* process, const std::vector<BytePattern>& patterns, bool executableOnly,
+                        std::vector<PatternMatch>& matches, std::vector<ModuleInfo>& modules) {
+    matches.clear();
+    if (!process || !process->memory || !process->settings) {
+        LOG_ERROR("Invalid process handle");
+        return 0;
+    }
+    if (patterns.empty()) {
+        return 0;
+    }
+
+    std::vector<MemoryRegion> allRegions;
+    process->memory->refreshRegions();
+    if (!process->memory->enumerateRegions(allRegions)) {
+        LOG_ERROR("Failed to enumerate memory regions");
+        return 0;
+    }
+    process->memory->enumerateModules(modules);
+
+    size_t maxLength = 0;
+    for (size_t i = 0; i < patterns.size(); i++) {
+        maxLength = std::max(maxLength, patterns[i].length);
+    }
+
+    g_cancelScan = false;
+    g_scanInProgress = true;
+    g_regionsScanned = 0;
+    g_bytesScanned = 0;
+    g_bytesSkipped = 0;
+    g_matchesFound = 0;
+    g_regionsSkipped = 0;
+
+    const SIZE_T chunkSize = GetScanChunkSize(process->settings);
+    std::vector<ScanChunk> chunks;
+    std::vector<size_t> chunksPerRegion;
+    size_t totalBytes = 0;
+    for (const auto& region : allRegions) {
+        if (IsReadableRegion(region) && region.type == MEM_IMAGE &&
+            (!executableOnly || IsExecutableProtection(region.protect))) {
+            chunksPerRegion.push_back(AddRegionChunks(region.base, region.size, chunksPerRegion.size(),
+                                                      chunkSize, chunks));
+            totalBytes += region.size;
+        } else if (region.state == MEM_COMMIT) {
+            g_regionsSkipped++;
+        }
+    }
+
+    std::unique_ptr<std::atomic<size_t>[]> regionChunksLeft(new std::atomic<size_t>[chunksPerRegion.size()]);
+    for (size_t r = 0; r < chunksPerRegion.size(); r++) {
+        regionChunksLeft[r] = chunksPerRegion[r];
+    }
+    g_totalRegionsToScan = chunksPerRegion.size();
+    g_totalMemoryToScan = totalBytes;
+
+    int threadCount = GetScanThreadCount(process->settings);
+    if ((size_t)threadCount > chunks.size()) {
+        threadCount = chunks.empty() ? 1 : (int)chunks.size();
+    }
+
+    LOG_INFO("Scanning %zu image regions (%zu MB) for %zu signatures on %d threads",
+             chunksPerRegion.size(), totalBytes / (1024 * 1024), patterns.size(), threadCount);
+
+    WorkStealingQueue<ScanChunk> queue(threadCount);
+    queue.distribute(chunks);
+
+    std::vector<std::vector<PatternMatch> > shards(threadCount);
+    std::vector<PatternScanThreadData> threadData(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        threadData[i].process = process;
+        threadData[i].patterns = &patterns;
+        threadData[i].maxLength = maxLength;
+        threadData[i].shard = &shards[i];
+        threadData[i].queue = &queue;
+        threadData[i].workerIndex = i;
+        threadData[i].regionChunksLeft = regionChunksLeft.get();
+    }
+    RunScanWorkers(patternScanThreadFunc, threadData, process->settings);
+
+    g_scanInProgress = false;
+    g_scanProgress = 1.0;
+
+    for (size_t i = 0; i < shards.size(); i++) {
+        matches.insert(matches.end(), shards[i].begin(), shards[i].end());
+    }
+    std::sort(matches.begin(), matches.end(), comparePatternMatches);
+
+    // Workers each keep their own lowest matches; the cap is applied here
+    // so the survivors do not depend on which worker got which chunk.
+    size_t kept = 0;
+    size_t run = 0;
+    for (size_t i = 0; i < matches.size(); i++) {
+        run = (i > 0 && matches[i].pattern == matches[i - 1].pattern) ? run + 1 : 0;
+        if (run < PATTERN_SCAN_MAX_MATCHES) {
+            matches[kept++] = matches[i];
+        }
+    }
+    matches.resize(kept);
+    for (size_t i = 0; i < matches.size(); i++) {
+        matches[i].module = findPointerModule(modules, matches[i].address);
+    }
+    g_matchesFound = matches.size();
+
+    LOG_INFO("Signature scan %s: %zu matches in %zu MB",
+             g_cancelScan ? "cancelled" : "done", matches.size(), g_bytesScanned.load() / (1024 * 1024));
+    return matches.size();
+}
+
+bool writePatternMatches(const char* filename, const std::vector<PatternMatch>& matches,
+                         const std::vector<ModuleInfo>& modules) {
+    FILE* file = filename ? fopen(filename, "w") : stdout;
+    if (!file) {
+        LOG_ERROR("Failed to open %s for writing", filename);
+        return false;
+    }
+
+    fprintf(file, "pattern,address,module,offset\n");
+    for (size_t i = 0; i < matches.size(); i++) {
+        const PatternMatch& match = matches[i];
+        if (match.module != (size_t)-1) {
+            fprintf(file, "%zu,0x%llX,%s,0x%llX\n", match.pattern, (unsigned long long)match.address,
+                    modules[match.module].name,
+                    (unsigned long long)(match.address - modules[match.module].base));
+        } else {
+            fprintf(file, "%zu,0x%llX,,\n", match.pattern, (unsigned long long)match.address);
+        }
+    }
+
+    bool ok = !ferror(file);
+    if (filename) {
+        ok = fclose(file) == 0 && ok;
+    }
+    if (!ok) {
+        LOG_ERROR("Failed to write signature matches to %s", filename ? filename : "stdout");
+    }
+    return ok;
+}
+
+// Sorts addresses and keeps the lowest PATTERN_SCAN_MAX_MATCHES.
+static void TrimPatternMatches(std::vector<uintptr_t>& addresses) {
+    std::sort(addresses.begin(), addresses.end());
+    if (addresses.size() > PATTERN_SCAN_MAX_MATCHES) {
+        addresses.resize(PATTERN_SCAN_MAX_MATCHES);
+    }
+}
+
+unsigned __stdcall patternScanThreadFunc(void* arg) {
+    PatternScanThreadData* data = static_cast<PatternScanThreadData*>(arg);
+    if (!data || !data->process || !data->process->memory || !data->patterns || !data->shard || !data->queue) {
+        LOG_ERROR("Invalid thread data");
+        return 1;
+    }
+
+    DWORD threadId = GetCurrentThreadId();
+    MemorySource* memory = data->process->memory;
+    const std::vector<BytePattern>& patterns = *data->patterns;
+    std::vector<PatternMatch>& shard = *data->shard;
+    const ScanKernelLevel kernelLevel = data->process->settings->useVectorizedOperations ?
+                                        GetScanKernelLevel() : SCAN_KERNEL_SCALAR;
+
+    // Matches per pattern, trimmed to the lowest PATTERN_SCAN_MAX_MATCHES
+    // whenever twice that many pile up. Once trimmed, a chunk starting past
+    // the highest kept address cannot add a match that survives the merge.
+    std::vector<std::vector<uintptr_t> > found(patterns.size());
+    std::vector<uintptr_t> ceiling(patterns.size(), UINTPTR_MAX);
+
+    try {
+        // Room for a match that starts in the chunk and ends past it, plus
+        // the widest block and verify loads beyond the last start.
+        const SIZE_T chunkSize = GetScanChunkSize(data->process->settings);
+        ScanBuffer buffer(chunkSize + data->maxLength + MAX_PATTERN_LENGTH + 64, data->process->settings);
+        std::vector<uint32_t> hits;
+
+        ScanChunk chunk;
+        while (!g_cancelScan && data->queue->next(data->workerIndex, &chunk)) {
+            SIZE_T readSize = std::min((SIZE_T)(chunk.regionEnd - chunk.address), chunk.size + data->maxLength - 1);
+            SIZE_T actualRead = 0;
+            memory->read(chunk.address, buffer.data(), readSize, &actualRead);
+            memset(buffer.data() + actualRead, 0, buffer.size() - actualRead);
+
+            for (size_t p = 0; p < patterns.size(); p++) {
+                const BytePattern& pattern = patterns[p];
+                if (actualRead < pattern.length || chunk.address > ceiling[p]) {
+                    continue;
+                }
+                size_t limit = std::min((size_t)chunk.size, (size_t)(actualRead - pattern.length + 1));
+                // Hits come in address order, so these are the chunk's lowest.
+                const size_t maxHits = PATTERN_SCAN_MAX_MATCHES;
+
+                hits.clear();
+                switch (kernelLevel) {
+                    case SCAN_KERNEL_AVX512: MatchPatternAvx512(pattern, buffer.data(), limit, maxHits, hits); break;
+                    case SCAN_KERNEL_AVX2: MatchPatternAvx2(pattern, buffer.data(), limit, maxHits, hits); break;
+                    case SCAN_KERNEL_SSE2: MatchPatternSse2(pattern, buffer.data(), limit, maxHits, hits); break;
+                    default: MatchPatternScalar(pattern, buffer.data(), limit, maxHits, hits); break;
+                }
+                for (size_t h = 0; h < hits.size(); h++) {
+                    found[p].push_back(chunk.address + hits[h]);
+                }
+                if (found[p].size() >= 2 * PATTERN_SCAN_MAX_MATCHES) {
+                    TrimPatternMatches(found[p]);
+                    ceiling[p] = found[p].back();
+                }
+            }
+
+            g_bytesScanned += std::min(actualRead, chunk.size);
+            if (--data->regionChunksLeft[chunk.regionIndex] == 0) {
+                g_regionsScanned++;
+                if (g_totalRegionsToScan > 0) {
+                    g_scanProgress = (double)g_regionsScanned / g_totalRegionsToScan;
+                }
+            }
+        }
+
+    } catch (const std::exception& e) {
+        LOG_ERROR("Thread %lu error: %s", threadId, e.what());
+    }
+
+    for (size_t p = 0; p < found.size(); p++) {
+        TrimPatternMatches(found[p]);
+        for (size_t i = 0; i < found[p].size(); i++) {
+            PatternMatch match = { p, found[p][i], (size_t)-1 };
+            shard.push_back(match);
+        }
+    }
+
+    LOG_DEBUG("Thread %lu: Found %zu signature matches", threadId, shard.size());
+    return 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "platform.h"
+#include <stdint.h>
+#include <vector>
+
+#include "scan_engine.h"
+
+// Array-of-bytes signature scanner. A signature such as
+// "48 8B 05 ?? ?? ?? ?? 89" compiles into pattern bytes and a per-byte mask;
+// "??" (or "?") is a wildcard and "4?" / "?8" fix a single nibble. The scan
+// prefilters on the two rarest fully fixed bytes with SIMD compares and
+// verifies each candidate with a masked compare. Module images are split
+// into chunks on the scan worker pool and every signature is matched
+// against a chunk while it is in cache, so all of them share one read pass.
+
+const size_t MAX_PATTERN_LENGTH = 256;
+const size_t PATTERN_SCAN_MAX_MATCHES = 10000;     // Per signature, lowest addresses first
+
+// bytes and mask are zero-padded to a multiple of 16 so candidates are
+// verified 16 bytes at a time.
+typedef struct {
+    std::vector<BYTE> bytes;    // Pattern bytes, wildcard bits cleared
+    std::vector<BYTE> mask;     // 0xFF fixed, 0xF0 / 0x0F nibble, 0x00 wildcard
+    size_t length;              // Signature length in bytes
+    size_t anchor[2];           // Offsets of the two rarest fixed bytes, ascending
+} BytePattern;
+
+typedef struct {
+    size_t pattern;             // Index into the scanned signatures
+    uintptr_t address;
+    size_t module;              // Index into the scan's modules, (size_t)-1 if none
+} PatternMatch;
+
+typedef struct {
+    ProcessInfo* process;
+    const std::vector<BytePattern>* patterns;
+    size_t maxLength;                       // Longest pattern, read past each chunk
+    std::vector<PatternMatch>* shard;
+    WorkStealingQueue<ScanChunk>* queue;
+    int workerIndex;
+    std::atomic<size_t>* regionChunksLeft;
+} PatternScanThreadData;
+
+// Parses text into pattern. Fails on malformed tokens, on signatures longer
+// than MAX_PATTERN_LENGTH and on signatures without a fully fixed byte.
+bool compileBytePattern(const char* text, BytePattern* pattern);
+
+// Scans module images (only their executable regions when executableOnly)
+// for every pattern. matches come back sorted by pattern, then address,
+// with the PATTERN_SCAN_MAX_MATCHES lowest of each pattern kept; modules
+// receives the module list the match indices refer to.
+size_t scanBytePatterns(ProcessInfo* process, const std::vector<BytePattern>& patterns, bool executableOnly,
+                        std::vector<PatternMatch>& matches, std::vector<ModuleInfo>& modules);
+
+// Writes pattern,address,module,offset lines to filename (stdout when nullptr).
+bool writePatternMatches(const char* filename, const std::vector<PatternMatch>& matches,
+                         const std::vector<ModuleInfo>& modules);
+
+unsigned __stdcall patternScanThreadFunc(void* arg);
@@ -0,0 +1,105 @@
+#pragma once
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+#else
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// Minimal Win32 type and constant shim so the scan engine compiles unchanged
+// on Linux. Region flags keep their Windows values; the Linux memory source
+// translates /proc/<pid>/maps permissions into them.
+
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int BOOL;
+typedef size_t SIZE_T;
+typedef uintptr_t DWORD_PTR;
+typedef void* HANDLE;
+typedef void* LPVOID;
+typedef const void* LPCVOID;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define MAX_PATH 260
+
+#define __stdcall
+
+#define PAGE_NOACCESS          0x01
+#define PAGE_READONLY          0x02
+#define PAGE_READWRITE         0x04
+#define PAGE_WRITECOPY         0x08
+#define PAGE_EXECUTE           0x10
+#define PAGE_EXECUTE_READ      0x20
+#define PAGE_EXECUTE_READWRITE 0x40
+#define PAGE_EXECUTE_WRITECOPY 0x80
+#define PAGE_GUARD             0x100
+#define PAGE_NOCACHE           0x200
+
+#define MEM_COMMIT  0x1000
+#define MEM_RESERVE 0x2000
+#define MEM_FREE    0x10000
+
+#define MEM_PRIVATE 0x20000
+#define MEM_MAPPED  0x40000
+#define MEM_IMAGE   0x1000000
+
+#define _TRUNCATE ((size_t)-1)
+
+inline DWORD GetCurrentProcessId() { return (DWORD)getpid(); }
+
+inline DWORD GetCurrentThreadId() { return (DWORD)syscall(SYS_gettid); }
+
+inline DWORD GetTickCount() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (DWORD)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+inline void Sleep(DWORD milliseconds) {
+    usleep((useconds_t)milliseconds * 1000);
+}
+
+inline int strcpy_s(char* dest, size_t destSize, const char* src) {
+    snprintf(dest, destSize, "%s", src);
+    return 0;
+}
+
+inline int strcat_s(char* dest, size_t destSize, const char* src) {
+    size_t len = strlen(dest);
+    if (len < destSize) {
+        snprintf(dest + len, destSize - len, "%s", src);
+    }
+    return 0;
+}
+
+inline int strncpy_s(char* dest, size_t destSize, const char* src, size_t count) {
+    size_t len = strlen(src);
+    if (count != _TRUNCATE && count < len) len = count;
+    if (len >= destSize) len = destSize - 1;
+    memcpy(dest, src, len);
+    dest[len] = '\0';
+    return 0;
+}
+
+#define sprintf_s snprintf
+#define _stricmp strcasecmp
+#define _strnicmp strncasecmp
+#define ZeroMemory(dest, size) memset((dest), 0, (size))
+
+#endif
@@ -0,0 +1,186 @@
+#include "platform.h"
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "pointer_map_file.h"
+#include "logging.h"
+
+static const char POINTER_MAP_MAGIC[4] = { 'C', 'E', 'P', 'M' };
+
+bool savePointerMap(const char* filename, const PointerMap* map) {
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        LOG_ERROR("Failed to open %s for writing", filename);
+        return false;
+    }
+
+    PointerMapFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, POINTER_MAP_MAGIC, sizeof(header.magic));
+    header.version = POINTER_MAP_VERSION;
+    header.pointerSize = sizeof(uintptr_t);
+    header.moduleCount = (uint32_t)map->modules.size();
+    header.entryCount = map->entries.size();
+    header.moduleOffset = sizeof(header);
+    uint64_t modulesEnd = header.moduleOffset + map->modules.size() * sizeof(PointerMapFileModule);
+    header.entryOffset = (modulesEnd + POINTER_MAP_ALIGNMENT - 1) & ~(POINTER_MAP_ALIGNMENT - 1);
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (size_t i = 0; ok && i < map->modules.size(); i++) {
+        PointerMapFileModule record;
+        memset(&record, 0, sizeof(record));
+        record.base = map->modules[i].base;
+        record.size = map->modules[i].size;
+        memcpy(record.name, map->modules[i].name, sizeof(record.name));
+        record.name[sizeof(record.name) - 1] = '\0';
+        ok = fwrite(&record, sizeof(record), 1, file) == 1;
+    }
+
+    static const BYTE padding[POINTER_MAP_ALIGNMENT] = { 0 };
+    size_t paddingSize = (size_t)(header.entryOffset - modulesEnd);
+    if (ok && paddingSize > 0) {
+        ok = fwrite(padding, 1, paddingSize, file) == paddingSize;
+    }
+    if (ok && !map->entries.empty()) {
+        ok = fwrite(map->entries.data(), sizeof(PointerMapEntry), map->entries.size(), file) == map->entries.size();
+    }
+
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        LOG_ERROR("Failed to write pointer map to %s", filename);
+        return false;
+    }
+
+    LOG_INFO("Saved pointer map with %zu pointers and %zu modules to %s",
+             map->entries.size(), map->modules.size(), filename);
+    return true;
+}
+
+static void resetMappedPointerMap(MappedPointerMap* map) {
+    map->entries = nullptr;
+    map->entryCount = 0;
+    map->modules.clear();
+    map->view = nullptr;
+    map->viewSize = 0;
+#ifdef _WIN32
+    map->file = INVALID_HANDLE_VALUE;
+    map->mapping = NULL;
+#else
+    map->fd = -1;
+#endif
+}
+
+static bool mapPointerMapFile(const char* filename, MappedPointerMap* map) {
+#ifdef _WIN32
+    map->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+    if (map->file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("Failed to open %s, error code: %lu", filename, GetLastError());
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(map->file, &size) || size.QuadPart == 0) {
+        LOG_ERROR("Failed to get the size of %s", filename);
+        return false;
+    }
+    map->viewSize = (uint64_t)size.QuadPart;
+    map->mapping = CreateFileMappingA(map->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!map->mapping) {
+        LOG_ERROR("Failed to map %s, error code: %lu", filename, GetLastError());
+        return false;
+    }
+    map->view = MapViewOfFile(map->mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    map->fd = open(filename, O_RDONLY);
+    if (map->fd < 0) {
+        LOG_ERROR("Failed to open %s", filename);
+        return false;
+    }
+    struct stat info;
+    if (fstat(map->fd, &info) != 0 || info.st_size == 0) {
+        LOG_ERROR("Failed to get the size of %s", filename);
+        return false;
+    }
+    map->viewSize = (uint64_t)info.st_size;
+    map->view = mmap(nullptr, (size_t)map->viewSize, PROT_READ, MAP_SHARED, map->fd, 0);
+    if (map->view == MAP_FAILED) {
+        map->view = nullptr;
+    }
+#endif
+    if (!map->view) {
+        LOG_ERROR("Failed to map a view of %s", filename);
+        return false;
+    }
+    return true;
+}
+
+bool openPointerMap(const char* filename, MappedPointerMap* map) {
+    resetMappedPointerMap(map);
+    if (!mapPointerMapFile(filename, map)) {
+        closePointerMap(map);
+        return false;
+    }
+
+    const BYTE* data = (const BYTE*)map->view;
+    PointerMapFileHeader header;
+    if (map->viewSize < sizeof(header)) {
+        LOG_ERROR("%s is too small to be a pointer map", filename);
+        closePointerMap(map);
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, POINTER_MAP_MAGIC, sizeof(header.magic)) != 0) {
+        LOG_ERROR("%s is not a pointer map", filename);
+        closePointerMap(map);
+        return false;
+    }
+    if (header.version != POINTER_MAP_VERSION || header.pointerSize != sizeof(uintptr_t)) {
+        LOG_ERROR("%s is pointer map version %u with %u-byte pointers, expected version %u with %u-byte pointers",
+                  filename, header.version, header.pointerSize, POINTER_MAP_VERSION, (unsigned)sizeof(uintptr_t));
+        closePointerMap(map);
+        return false;
+    }
+    uint64_t modulesEnd = header.moduleOffset + (uint64_t)header.moduleCount * sizeof(PointerMapFileModule);
+    if (modulesEnd > map->viewSize || header.entryOffset % sizeof(uintptr_t) != 0 ||
+        header.entryOffset > map->viewSize ||
+        header.entryCount > (map->viewSize - header.entryOffset) / sizeof(PointerMapEntry)) {
+        LOG_ERROR("%s is truncated or corrupt", filename);
+        closePointerMap(map);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.moduleCount; i++) {
+        PointerMapFileModule record;
+        memcpy(&record, data + header.moduleOffset + i * sizeof(record), sizeof(record));
+        ModuleInfo module;
+        module.base = (uintptr_t)record.base;
+        module.size = (size_t)record.size;
+        memcpy(module.name, record.name, sizeof(module.name));
+        module.name[sizeof(module.name) - 1] = '\0';
+        map->modules.push_back(module);
+    }
+    map->entries = reinterpret_cast<const PointerMapEntry*>(data + header.entryOffset);
+    map->entryCount = (size_t)header.entryCount;
+
+    LOG_INFO("Mapped pointer map %s: %zu pointers, %zu modules",
+             filename, map->entryCount, map->modules.size());
+    return true;
+}
+
+void closePointerMap(MappedPointerMap* map) {
+#ifdef _WIN32
+    if (map->view) UnmapViewOfFile(map->view);
+    if (map->mapping) CloseHandle(map->mapping);
+    if (map->file != INVALID_HANDLE_VALUE) CloseHandle(map->file);
+#else
+    if (map->view) munmap(map->view, (size_t)map->viewSize);
+    if (map->fd >= 0) close(map->fd);
+#endif
+    resetMappedPointerMap(map);
+}
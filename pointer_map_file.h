@@ -0,0 +1,60 @@
+#pragma once
+
+#include "platform.h"
+#include <stdint.h>
+#include <vector>
+
+#include "pointer_scan.h"
+
+// On-disk pointer map. Saved after a pointer map pass so later searches
+// (other targets, depths or offsets) run without touching live memory. The
+// entries sit at a page-aligned offset in the writer's PointerMapEntry
+// layout, so an opened file is memory-mapped and searched in place; only
+// the small module table is copied out.
+//
+// Layout: PointerMapFileHeader, moduleCount PointerMapFileModule records,
+// padding to entryOffset, entryCount PointerMapEntry records sorted by
+// value then holder.
+
+const uint32_t POINTER_MAP_VERSION = 1;
+const uint64_t POINTER_MAP_ALIGNMENT = 4096;
+
+#pragma pack(push, 1)
+typedef struct {
+    char magic[4];          // "CEPM"
+    uint32_t version;       // POINTER_MAP_VERSION
+    uint32_t pointerSize;   // sizeof(uintptr_t) of the writer
+    uint32_t moduleCount;
+    uint64_t entryCount;
+    uint64_t moduleOffset;  // File offset of the module records
+    uint64_t entryOffset;   // File offset of the entries
+} PointerMapFileHeader;
+
+typedef struct {
+    uint64_t base;
+    uint64_t size;
+    char name[260];
+    uint32_t reserved;
+} PointerMapFileModule;
+#pragma pack(pop)
+
+typedef struct {
+    const PointerMapEntry* entries;     // Points into the mapping
+    size_t entryCount;
+    std::vector<ModuleInfo> modules;
+    void* view;                         // Start of the mapping
+    uint64_t viewSize;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+} MappedPointerMap;
+
+bool savePointerMap(const char* filename, const PointerMap* map);
+
+// Maps filename read-only. Fails on a bad magic, another version or a
+// pointer size other than this build's.
+bool openPointerMap(const char* filename, MappedPointerMap* map);
+void closePointerMap(MappedPointerMap* map);
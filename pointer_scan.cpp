@@ -0,0 +1,566 @@
+#include "platform.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <unordered_set>
+
+#include "pointer_scan.h"
+#include "pointer_map_file.h"
+#include "scan_buffer_pool.h"
+#include "logging.h"
+
+static bool comparePointerEntries(const PointerMapEntry& a, const PointerMapEntry& b) {
+    return a.value < b.value || (a.value == b.value && a.holder < b.holder);
+}
+
+// Readable regions merged into ascending [begin, end) ranges, the set of
+// addresses a word has to fall into to count as a pointer.
+static void collectPointerTargets(const std::vector<MemoryRegion>& regions,
+                                  std::vector<std::pair<uintptr_t, uintptr_t> >& targets) {
+    targets.clear();
+    for (size_t i = 0; i < regions.size(); i++) {
+        const MemoryRegion& region = regions[i];
+        if (!IsReadableRegion(region)) {
+            continue;
+        }
+        if (!targets.empty() && targets.back().second == region.base) {
+            targets.back().second = region.base + region.size;
+        } else {
+            targets.push_back(std::make_pair(region.base, region.base + region.size));
+        }
+    }
+}
+
+bool buildPointerMap(ProcessInfo* process, PointerMap* map) {
+    if (!process || !process->memory || !process->settings) {
+        LOG_ERROR("Invalid process handle");
+        return false;
+    }
+
+    freePointerMap(map);
+
+    std::vector<MemoryRegion> allRegions;
+    process->memory->refreshRegions();
+    if (!process->memory->enumerateRegions(allRegions)) {
+        LOG_ERROR("Failed to enumerate memory regions");
+        return false;
+    }
+    process->memory->enumerateModules(map->modules);
+
+    std::vector<std::pair<uintptr_t, uintptr_t> > targets;
+    collectPointerTargets(allRegions, targets);
+
+    g_cancelScan = false;
+    g_scanInProgress = true;
+    g_regionsScanned = 0;
+    g_bytesScanned = 0;
+    g_bytesSkipped = 0;
+    g_matchesFound = 0;
+    g_regionsSkipped = 0;
+
+    // Pointers are stored in writable memory: heaps, stacks and module data.
+    const SIZE_T chunkSize = GetScanChunkSize(process->settings);
+    std::vector<ScanChunk> chunks;
+    std::vector<size_t> chunksPerRegion;
+    size_t totalBytes = 0;
+    for (const auto& region : allRegions) {
+        if (IsReadableRegion(region) && IsWritableProtection(region.protect) && region.type != MEM_MAPPED) {
+            chunksPerRegion.push_back(AddRegionChunks(region.base, region.size, chunksPerRegion.size(),
+                                                      chunkSize, chunks));
+            totalBytes += region.size;
+        } else if (region.state == MEM_COMMIT) {
+            g_regionsSkipped++;
+        }
+    }
+
+    std::unique_ptr<std::atomic<size_t>[]> regionChunksLeft(new std::atomic<size_t>[chunksPerRegion.size()]);
+    for (size_t r = 0; r < chunksPerRegion.size(); r++) {
+        regionChunksLeft[r] = chunksPerRegion[r];
+    }
+    g_totalRegionsToScan = chunksPerRegion.size();
+    g_totalMemoryToScan = totalBytes;
+
+    int threadCount = GetScanThreadCount(process->settings);
+    if ((size_t)threadCount > chunks.size()) {
+        threadCount = chunks.empty() ? 1 : (int)chunks.size();
+    }
+
+    LOG_INFO("Building pointer map over %zu regions (%zu MB) on %d threads",
+             chunksPerRegion.size(), totalBytes / (1024 * 1024), threadCount);
+
+    WorkStealingQueue<ScanChunk> queue(threadCount);
+    queue.distribute(chunks);
+
+    std::vector<std::vector<PointerMapEntry> > shards(threadCount);
+    std::vector<PointerMapThreadData> threadData(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        threadData[i].process = process;
+        threadData[i].targets = &targets;
+        threadData[i].shard = &shards[i];
+        threadData[i].queue = &queue;
+        threadData[i].workerIndex = i;
+        threadData[i].regionChunksLeft = regionChunksLeft.get();
+    }
+    RunScanWorkers(pointerMapThreadFunc, threadData, process->settings);
+
+    g_scanInProgress = false;
+    g_scanProgress = 1.0;
+
+    if (g_cancelScan) {
+        LOG_INFO("Pointer map build cancelled");
+        return false;
+    }
+
+    // Shards come back sorted; merge them pairwise.
+    size_t total = 0;
+    for (size_t i = 0; i < shards.size(); i++) {
+        total += shards[i].size();
+    }
+    map->entries.reserve(total);
+    for (size_t i = 0; i < shards.size(); i++) {
+        size_t middle = map->entries.size();
+        map->entries.insert(map->entries.end(), shards[i].begin(), shards[i].end());
+        std::vector<PointerMapEntry>().swap(shards[i]);
+        std::inplace_merge(map->entries.begin(), map->entries.begin() + middle, map->entries.end(),
+                           comparePointerEntries);
+    }
+
+    LOG_INFO("Pointer map built: %zu pointers in %zu MB, %zu modules",
+             map->entries.size(), g_bytesScanned.load() / (1024 * 1024), map->modules.size());
+    return true;
+}
+
+void freePointerMap(PointerMap* map) {
+    std::vector<PointerMapEntry>().swap(map->entries);
+    std::vector<ModuleInfo>().swap(map->modules);
+}
+
+size_t findPointerModule(const std::vector<ModuleInfo>& modules, uintptr_t address) {
+    std::vector<ModuleInfo>::const_iterator it = std::upper_bound(
+        modules.begin(), modules.end(), address,
+        [](uintptr_t value, const ModuleInfo& module) { return value < module.base; });
+    if (it == modules.begin()) {
+        return (size_t)-1;
+    }
+    --it;
+    if (address >= it->base + it->size) {
+        return (size_t)-1;
+    }
+    return (size_t)(it - modules.begin());
+}
+
+size_t findPointerPaths(const PointerMapEntry* entries, size_t entryCount, const std::vector<ModuleInfo>& modules,
+                        uintptr_t target, int maxDepth, int maxOffset, size_t maxPaths,
+                        std::vector<PointerPath>& paths) {
+    typedef struct {
+        uintptr_t address;
+        size_t parent;      // Node this one points into, (size_t)-1 for the target
+        int32_t offset;     // From this node's pointer value to the parent
+    } PointerNode;
+
+    maxDepth = std::max(1, std::min(maxDepth, MAX_POINTER_DEPTH));
+    size_t found = 0;
+
+    std::vector<PointerNode> nodes;
+    std::unordered_set<uintptr_t> visited;
+    PointerNode root = { target, (size_t)-1, 0 };
+    nodes.push_back(root);
+    visited.insert(target);
+
+    size_t levelBegin = 0;
+    for (int depth = 1; depth <= maxDepth && found < maxPaths; depth++) {
+        size_t levelEnd = nodes.size();
+        for (size_t n = levelBegin; n < levelEnd && found < maxPaths; n++) {
+            uintptr_t address = nodes[n].address;
+            uintptr_t low = address > (uintptr_t)maxOffset ? address - maxOffset : 0;
+
+            PointerMapEntry key = { low, 0 };
+            const PointerMapEntry* end = entries + entryCount;
+            const PointerMapEntry* it = std::lower_bound(entries, end, key, comparePointerEntries);
+            for (; it != end && it->value <= address && found < maxPaths; ++it) {
+                int32_t offset = (int32_t)(address - it->value);
+                size_t module = findPointerModule(modules, it->holder);
+                if (module != (size_t)-1) {
+                    PointerPath path;
+                    memset(&path, 0, sizeof(path));
+                    path.module = module;
+                    path.baseOffset = it->holder - modules[module].base;
+                    path.depth = depth;
+                    path.offsets[0] = offset;
+                    size_t parent = n;
+                    for (int d = 1; d < depth; d++) {
+                        path.offsets[d] = nodes[parent].offset;
+                        parent = nodes[parent].parent;
+                    }
+                    paths.push_back(path);
+                    found++;
+                    continue;
+                }
+
+                // Each heap holder is expanded once, at its shallowest depth.
+                if (depth < maxDepth && nodes.size() < POINTER_SCAN_MAX_NODES &&
+                    visited.insert(it->holder).second) {
+                    PointerNode node = { it->holder, n, offset };
+                    nodes.push_back(node);
+                }
+            }
+        }
+        levelBegin = levelEnd;
+        if (levelBegin == nodes.size()) {
+            break;
+        }
+    }
+
+    LOG_INFO("Pointer search for 0x%llx: %zu paths, %zu nodes visited",
+             (unsigned long long)target, found, nodes.size());
+    return found;
+}
+
+bool writePointerPaths(const char* filename, const std::vector<ModuleInfo>& modules, uintptr_t target,
+                       const std::vector<PointerPath>& paths) {
+    FILE* file = filename ? fopen(filename, "w") : stdout;
+    if (!file) {
+        LOG_ERROR("Failed to open %s for writing", filename);
+        return false;
+    }
+
+    fprintf(file, "# Pointer paths to 0x%llX: module+base, then the offset added after each dereference\n",
+            (unsigned long long)target);
+    for (size_t i = 0; i < paths.size(); i++) {
+        const PointerPath& path = paths[i];
+        fprintf(file, "%s+0x%llX", modules[path.module].name, (unsigned long long)path.baseOffset);
+        for (int d = 0; d < path.depth; d++) {
+            fprintf(file, ",0x%X", (unsigned int)path.offsets[d]);
+        }
+        fputc('\n', file);
+    }
+
+    bool ok = !ferror(file);
+    if (filename) {
+        ok = fclose(file) == 0 && ok;
+    }
+    if (!ok) {
+        LOG_ERROR("Failed to write pointer paths to %s", filename ? filename : "stdout");
+    }
+    return ok;
+}
+
+bool readPointerPaths(const char* filename, std::vector<ModuleInfo>& modules, std::vector<PointerPath>& paths) {
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        LOG_ERROR("Failed to open %s", filename);
+        return false;
+    }
+
+    char line[1024];
+    size_t lineNumber = 0;
+    size_t skipped = 0;
+    while (fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r' || line[0] == '\0') {
+            continue;
+        }
+
+        // The module name may itself contain '+', so split at the last one
+        // before the first comma.
+        char* comma = strchr(line, ',');
+        if (comma) *comma = '\0';
+        char* plus = strrchr(line, '+');
+        if (comma) *comma = ',';
+        if (!plus || plus == line || (comma && plus > comma)) {
+            skipped++;
+            continue;
+        }
+        *plus = '\0';
+
+        // A cut name would never match the module at revalidation.
+        size_t nameLength = strlen(line);
+        if (nameLength >= sizeof(ModuleInfo::name)) {
+            LOG_WARNING("%s:%zu: module name longer than %zu characters", filename, lineNumber,
+                        sizeof(ModuleInfo::name) - 1);
+            skipped++;
+            continue;
+        }
+
+        PointerPath path;
+        memset(&path, 0, sizeof(path));
+        char* cursor = plus + 1;
+        path.baseOffset = (uintptr_t)strtoull(cursor, &cursor, 16);
+        while (*cursor == ',' && path.depth < MAX_POINTER_DEPTH) {
+            path.offsets[path.depth++] = (int32_t)strtoul(cursor + 1, &cursor, 16);
+        }
+        if (path.depth == 0 || (*cursor != '\n' && *cursor != '\r' && *cursor != '\0')) {
+            LOG_WARNING("%s:%zu: malformed pointer path", filename, lineNumber);
+            skipped++;
+            continue;
+        }
+
+        path.module = modules.size();
+        for (size_t m = 0; m < modules.size(); m++) {
+            if (strcmp(modules[m].name, line) == 0) {
+                path.module = m;
+                break;
+            }
+        }
+        if (path.module == modules.size()) {
+            ModuleInfo module;
+            memset(&module, 0, sizeof(module));
+            memcpy(module.name, line, nameLength + 1);
+            modules.push_back(module);
+        }
+        paths.push_back(path);
+    }
+    fclose(file);
+
+    if (skipped > 0) {
+        LOG_WARNING("Skipped %zu malformed lines in %s", skipped, filename);
+    }
+    LOG_INFO("Read %zu pointer paths over %zu modules from %s", paths.size(), modules.size(), filename);
+    return true;
+}
+
+size_t revalidatePointerPaths(ProcessInfo* process, const std::vector<ModuleInfo>& modules,
+                              std::vector<PointerPath>& paths, uintptr_t target) {
+    if (!process || !process->memory || !process->settings) {
+        LOG_ERROR("Invalid process handle");
+        return 0;
+    }
+
+    std::vector<ModuleInfo> current;
+    process->memory->enumerateModules(current);
+    std::vector<uintptr_t> moduleBases(modules.size(), 0);
+    for (size_t m = 0; m < modules.size(); m++) {
+        for (size_t c = 0; c < current.size(); c++) {
+            if (_stricmp(modules[m].name, current[c].name) == 0) {
+                moduleBases[m] = current[c].base;
+                break;
+            }
+        }
+        if (moduleBases[m] == 0) {
+            LOG_WARNING("Module %s is not loaded, its paths are dropped", modules[m].name);
+        }
+    }
+
+    g_cancelScan = false;
+    g_scanInProgress = true;
+
+    std::vector<PointerPathBatch> batches;
+    for (size_t begin = 0; begin < paths.size(); begin += POINTER_PATH_BATCH) {
+        PointerPathBatch batch = { begin, std::min(POINTER_PATH_BATCH, paths.size() - begin) };
+        batches.push_back(batch);
+    }
+
+    int threadCount = GetScanThreadCount(process->settings);
+    if ((size_t)threadCount > batches.size()) {
+        threadCount = batches.empty() ? 1 : (int)batches.size();
+    }
+
+    WorkStealingQueue<PointerPathBatch> queue(threadCount);
+    queue.distribute(batches);
+
+    std::vector<char> keep(paths.size(), 0);
+    std::vector<PointerRevalidateThreadData> threadData(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        threadData[i].process = process;
+        threadData[i].paths = &paths;
+        threadData[i].moduleBases = &moduleBases;
+        threadData[i].target = target;
+        threadData[i].keep = &keep;
+        threadData[i].queue = &queue;
+        threadData[i].workerIndex = i;
+    }
+    RunScanWorkers(pointerRevalidateThreadFunc, threadData, process->settings);
+
+    g_scanInProgress = false;
+
+    // A cancelled pass leaves the list untouched.
+    if (g_cancelScan) {
+        LOG_INFO("Pointer path revalidation cancelled");
+        return paths.size();
+    }
+
+    size_t before = paths.size();
+    size_t kept = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (keep[i]) {
+            paths[kept++] = paths[i];
+        }
+    }
+    paths.resize(kept);
+
+    LOG_INFO("Revalidated pointer paths to 0x%llx: kept %zu of %zu", (unsigned long long)target, kept, before);
+    return kept;
+}
+
+bool pointerScan(ProcessInfo* process, uintptr_t target, const char* filename, const char* mapFilename,
+                 size_t* pathCount) {
+    if (pathCount) {
+        *pathCount = 0;
+    }
+    PointerMap map;
+    if (!buildPointerMap(process, &map)) {
+        ShowStatusMessage("Pointer scan failed");
+        return false;
+    }
+    bool saved = true;
+    if (mapFilename && !savePointerMap(mapFilename, &map)) {
+        ShowStatusMessage("Failed to save pointer map");
+        saved = false;
+    }
+
+    std::vector<PointerPath> paths;
+    findPointerPaths(map.entries.data(), map.entries.size(), map.modules, target,
+                     process->settings->maxPointerDepth, process->settings->maxPointerOffset,
+                     POINTER_SCAN_MAX_PATHS, paths);
+    if (!writePointerPaths(filename, map.modules, target, paths)) {
+        ShowStatusMessage("Failed to write pointer paths");
+        return false;
+    }
+    if (pathCount) {
+        *pathCount = paths.size();
+    }
+
+    ShowFormattedStatusMessage("Found %zu pointer paths to 0x%llX", paths.size(), (unsigned long long)target);
+    return saved;
+}
+
+unsigned __stdcall pointerMapThreadFunc(void* arg) {
+    PointerMapThreadData* data = static_cast<PointerMapThreadData*>(arg);
+    if (!data || !data->process || !data->process->memory || !data->targets || !data->shard || !data->queue) {
+        LOG_ERROR("Invalid thread data");
+        return 1;
+    }
+
+    DWORD threadId = GetCurrentThreadId();
+    MemorySource* memory = data->process->memory;
+    const std::vector<std::pair<uintptr_t, uintptr_t> >& targets = *data->targets;
+    std::vector<PointerMapEntry>& shard = *data->shard;
+    if (targets.empty()) {
+        return 0;
+    }
+    const uintptr_t lowest = targets.front().first;
+    const uintptr_t highest = targets.back().second;
+
+    try {
+        ScanBuffer buffer(GetScanChunkSize(data->process->settings), data->process->settings);
+
+        ScanChunk chunk;
+        while (!g_cancelScan && data->queue->next(data->workerIndex, &chunk)) {
+            SIZE_T actualRead = 0;
+            memory->read(chunk.address, buffer.data(), chunk.size, &actualRead);
+
+            // Neighbouring words tend to point into the same range, so the
+            // last range is checked before searching.
+            size_t last = 0;
+            size_t words = actualRead / sizeof(uintptr_t);
+            const uintptr_t* values = reinterpret_cast<const uintptr_t*>(buffer.data());
+            for (size_t w = 0; w < words; w++) {
+                uintptr_t value = values[w];
+                if (value < lowest || value >= highest) {
+                    continue;
+                }
+                if (value < targets[last].first || value >= targets[last].second) {
+                    std::vector<std::pair<uintptr_t, uintptr_t> >::const_iterator it = std::upper_bound(
+                        targets.begin(), targets.end(), value,
+                        [](uintptr_t v, const std::pair<uintptr_t, uintptr_t>& range) { return v < range.first; });
+                    if (it == targets.begin() || value >= (it - 1)->second) {
+                        continue;
+                    }
+                    last = (size_t)(it - targets.begin()) - 1;
+                }
+                PointerMapEntry entry = { value, chunk.address + w * sizeof(uintptr_t) };
+                shard.push_back(entry);
+            }
+
+            g_bytesScanned += actualRead;
+            if (--data->regionChunksLeft[chunk.regionIndex] == 0) {
+                g_regionsScanned++;
+                if (g_totalRegionsToScan > 0) {
+                    g_scanProgress = (double)g_regionsScanned / g_totalRegionsToScan;
+                }
+            }
+        }
+
+        std::sort(shard.begin(), shard.end(), comparePointerEntries);
+
+    } catch (const std::exception& e) {
+        LOG_ERROR("Thread %lu error: %s", threadId, e.what());
+    }
+
+    LOG_DEBUG("Thread %lu: Collected %zu pointers", threadId, shard.size());
+    return 0;
+}
+
+unsigned __stdcall pointerRevalidateThreadFunc(void* arg) {
+    PointerRevalidateThreadData* data = static_cast<PointerRevalidateThreadData*>(arg);
+    if (!data || !data->process || !data->process->memory || !data->paths || !data->moduleBases ||
+        !data->keep || !data->queue) {
+        LOG_ERROR("Invalid thread data");
+        return 1;
+    }
+
+    DWORD threadId = GetCurrentThreadId();
+    MemorySource* memory = data->process->memory;
+    const std::vector<PointerPath>& paths = *data->paths;
+    const std::vector<uintptr_t>& moduleBases = *data->moduleBases;
+    size_t threadKept = 0;
+
+    try {
+        std::vector<uintptr_t> addresses(POINTER_PATH_BATCH);
+        std::vector<uintptr_t> pointers(POINTER_PATH_BATCH);
+        std::vector<size_t> live;
+        std::vector<ScatterEntry> entries;
+
+        PointerPathBatch batch;
+        while (!g_cancelScan && data->queue->next(data->workerIndex, &batch)) {
+            live.clear();
+            for (size_t i = 0; i < batch.count; i++) {
+                const PointerPath& path = paths[batch.begin + i];
+                uintptr_t base = moduleBases[path.module];
+                if (base != 0) {
+                    addresses[i] = base + path.baseOffset;
+                    live.push_back(i);
+                }
+            }
+
+            // Every live path of the batch takes its next step together:
+            // one scatter read of the pointers, then add that level's offset.
+            for (int depth = 0; depth < MAX_POINTER_DEPTH && !live.empty(); depth++) {
+                entries.resize(live.size());
+                for (size_t l = 0; l < live.size(); l++) {
+                    entries[l].address = addresses[live[l]];
+                    entries[l].buffer = &pointers[live[l]];
+                    entries[l].size = sizeof(uintptr_t);
+                    entries[l].bytesRead = 0;
+                }
+                memory->readScatter(entries.data(), entries.size());
+
+                size_t next = 0;
+                for (size_t l = 0; l < live.size(); l++) {
+                    size_t i = live[l];
+                    const PointerPath& path = paths[batch.begin + i];
+                    if (entries[l].bytesRead != sizeof(uintptr_t)) {
+                        continue;
+                    }
+                    addresses[i] = pointers[i] + path.offsets[depth];
+                    if (depth + 1 == path.depth) {
+                        if (addresses[i] == data->target) {
+                            (*data->keep)[batch.begin + i] = 1;
+                            threadKept++;
+                        }
+                        continue;
+                    }
+                    live[next++] = i;
+                }
+                live.resize(next);
+            }
+        }
+
+    } catch (const std::exception& e) {
+        LOG_ERROR("Thread %lu error: %s", threadId, e.what());
+    }
+
+    LOG_DEBUG("Thread %lu: Kept %zu pointer paths", threadId, threadKept);
+    return 0;
+}
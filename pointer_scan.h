@@ -0,0 +1,100 @@
+#pragma once
+
+#include "platform.h"
+#include <stdint.h>
+#include <vector>
+
+#include "scan_engine.h"
+
+// Pointer scanner. One parallel pass over every writable region collects
+// each aligned pointer-sized word that points into readable memory, giving
+// a reverse map sorted by pointed-to value. A breadth-first search then
+// walks backwards from a target address: every map entry pointing at most
+// maxPointerOffset bytes before the current address is a holder one level
+// up, until a holder lies inside a module (a static base).
+
+const int MAX_POINTER_DEPTH = 10;
+const size_t POINTER_SCAN_MAX_PATHS = 100000;
+const size_t POINTER_SCAN_MAX_NODES = 4 * 1024 * 1024;
+
+typedef struct {
+    uintptr_t value;        // Address the pointer points to
+    uintptr_t holder;       // Address the pointer is stored at
+} PointerMapEntry;
+
+typedef struct {
+    std::vector<PointerMapEntry> entries;   // Sorted by value, then holder
+    std::vector<ModuleInfo> modules;        // Ascending by base
+} PointerMap;
+
+// base = module base + baseOffset. Following the path reads a pointer at
+// base, adds offsets[0], reads a pointer there, adds offsets[1], and so
+// on; the last offset lands on the target.
+typedef struct {
+    size_t module;                          // Index into PointerMap::modules
+    uintptr_t baseOffset;
+    int depth;                              // Number of offsets
+    int32_t offsets[MAX_POINTER_DEPTH];
+} PointerPath;
+
+typedef struct {
+    ProcessInfo* process;
+    const std::vector<std::pair<uintptr_t, uintptr_t> >* targets;  // Readable ranges, ascending
+    std::vector<PointerMapEntry>* shard;
+    WorkStealingQueue<ScanChunk>* queue;
+    int workerIndex;
+    std::atomic<size_t>* regionChunksLeft;
+} PointerMapThreadData;
+
+// Paths are revalidated in batches; each level of a batch is one scatter read.
+typedef struct {
+    size_t begin;
+    size_t count;
+} PointerPathBatch;
+
+typedef struct {
+    ProcessInfo* process;
+    std::vector<PointerPath>* paths;
+    const std::vector<uintptr_t>* moduleBases;  // Base in the process per path module, 0 if missing
+    uintptr_t target;
+    std::vector<char>* keep;
+    WorkStealingQueue<PointerPathBatch>* queue;
+    int workerIndex;
+} PointerRevalidateThreadData;
+
+const size_t POINTER_PATH_BATCH = 4096;
+
+bool buildPointerMap(ProcessInfo* process, PointerMap* map);
+void freePointerMap(PointerMap* map);
+
+// Index of the module holding address, or (size_t)-1.
+size_t findPointerModule(const std::vector<ModuleInfo>& modules, uintptr_t address);
+
+// Appends up to maxPaths paths to target, shortest first, and returns how
+// many were found. entries may be a PointerMap's or a mapped map file's.
+size_t findPointerPaths(const PointerMapEntry* entries, size_t entryCount, const std::vector<ModuleInfo>& modules,
+                        uintptr_t target, int maxDepth, int maxOffset, size_t maxPaths,
+                        std::vector<PointerPath>& paths);
+
+// One path per line: module+0xBASE followed by the offsets, comma separated.
+// readPointerPaths parses that back; its modules carry names only.
+bool writePointerPaths(const char* filename, const std::vector<ModuleInfo>& modules, uintptr_t target,
+                       const std::vector<PointerPath>& paths);
+bool readPointerPaths(const char* filename, std::vector<ModuleInfo>& modules, std::vector<PointerPath>& paths);
+
+// Follows every path in process, which may be a later instance than the one
+// the paths were found in: modules are looked up again by name. Keeps the
+// paths that land on target and returns how many remain.
+size_t revalidatePointerPaths(ProcessInfo* process, const std::vector<ModuleInfo>& modules,
+                              std::vector<PointerPath>& paths, uintptr_t target);
+
+// Builds the map, searches with the process settings and writes the paths
+// to filename (stdout when nullptr). The map is also saved to mapFilename
+// unless that is nullptr. Stores the number of paths written in pathCount
+// (when given) and returns false if the map could not be built or saved or
+// the paths could not be written.
+bool pointerScan(ProcessInfo* process, uintptr_t target, const char* filename, const char* mapFilename,
+                 size_t* pathCount = nullptr);
+
+unsigned __stdcall pointerMapThreadFunc(void* arg);
+unsigned __stdcall pointerRevalidateThreadFunc(void* arg);
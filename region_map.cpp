@@ -0,0 +1,157 @@
+#include "region_map.h"
+#include "logging.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+class RegionMapSource : public MemorySource {
+private:
+    MemorySource* backend;
+    const Settings* settings;
+
+    std::mutex lock;                        // Guards regions and captureTime
+    std::vector<MemoryRegion> regions;      // Ascending, non-overlapping
+    DWORD captureTime;                      // GetTickCount() of the last walk
+    std::atomic<bool> refreshing;           // Set while one thread walks
+
+    static bool sameRegion(const MemoryRegion& a, const MemoryRegion& b) {
+        return a.base == b.base && a.size == b.size && a.protect == b.protect &&
+               a.state == b.state && a.type == b.type;
+    }
+
+    // Walks the address space outside the lock and swaps the result in.
+    bool capture() {
+        std::vector<MemoryRegion> fresh;
+        if (!backend->enumerateRegions(fresh)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        size_t changed = 0;
+        size_t oldIndex = 0;
+        for (size_t i = 0; i < fresh.size(); i++) {
+            while (oldIndex < regions.size() && regions[oldIndex].base < fresh[i].base) {
+                oldIndex++;
+            }
+            if (oldIndex == regions.size() || !sameRegion(regions[oldIndex], fresh[i])) {
+                changed++;
+            }
+        }
+        if (changed > 0 || fresh.size() != regions.size()) {
+            LOG_DEBUG("Region map of process %lu: %zu regions, %zu new or changed",
+                      backend->processId(), fresh.size(), changed);
+        }
+        regions.swap(fresh);
+        captureTime = GetTickCount();
+        return true;
+    }
+
+    // Re-walks when the list is older than the refresh interval. Only one
+    // caller walks; the others keep using the current list.
+    void refreshIfStale() {
+        int interval = settings ? settings->regionMapRefreshInterval : 0;
+        if (interval <= 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (GetTickCount() - captureTime < (DWORD)interval) {
+                return;
+            }
+        }
+        if (!refreshing.exchange(true)) {
+            capture();
+            refreshing = false;
+        }
+    }
+
+public:
+    RegionMapSource(MemorySource* source, const Settings* settings)
+        : backend(source), settings(settings), captureTime(0), refreshing(false) {}
+
+    ~RegionMapSource() {
+        delete backend;
+    }
+
+    bool initialize() {
+        return capture();
+    }
+
+    bool enumerateRegions(std::vector<MemoryRegion>& out) override {
+        refreshIfStale();
+        std::lock_guard<std::mutex> guard(lock);
+        out = regions;
+        return !out.empty();
+    }
+
+    bool enumerateModules(std::vector<ModuleInfo>& modules) override {
+        return backend->enumerateModules(modules);
+    }
+
+    bool queryRegion(uintptr_t address, MemoryRegion* region) override {
+        refreshIfStale();
+        std::lock_guard<std::mutex> guard(lock);
+        std::vector<MemoryRegion>::const_iterator it = std::upper_bound(
+            regions.begin(), regions.end(), address,
+            [](uintptr_t value, const MemoryRegion& r) { return value < r.base; });
+        if (it == regions.begin()) {
+            return false;
+        }
+        --it;
+        if (address >= it->base + it->size) {
+            return false;
+        }
+        *region = *it;
+        return true;
+    }
+
+    bool refreshRegions() override {
+        return capture();
+    }
+
+    bool read(uintptr_t address, void* buffer, size_t size, size_t* bytesRead) override {
+        return backend->read(address, buffer, size, bytesRead);
+    }
+
+    size_t readScatter(ScatterEntry* entries, size_t count) override {
+        return backend->readScatter(entries, count);
+    }
+
+    bool queryResidency(uintptr_t address, size_t pageCount, BYTE* flags) override {
+        return backend->queryResidency(address, pageCount, flags);
+    }
+
+    bool resetWrittenPages() override {
+        return backend->resetWrittenPages();
+    }
+
+    bool queryWrittenPages(uintptr_t address, size_t pageCount, BYTE* written) override {
+        return backend->queryWrittenPages(address, pageCount, written);
+    }
+
+    bool write(uintptr_t address, const void* buffer, size_t size, size_t* bytesWritten) override {
+        return backend->write(address, buffer, size, bytesWritten);
+    }
+
+    DWORD processId() const override {
+        return backend->processId();
+    }
+
+    bool isValid() const override {
+        return backend->isValid();
+    }
+};
+
+MemorySource* CreateRegionMapSource(MemorySource* backend, const Settings* settings) {
+    if (!backend) {
+        return nullptr;
+    }
+
+    RegionMapSource* source = new RegionMapSource(backend, settings);
+    if (!source->initialize()) {
+        LOG_ERROR("Failed to map the regions of process %lu", backend->processId());
+        delete source;
+        return nullptr;
+    }
+    return source;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "platform.h"
+#include <stdint.h>
+
+#include "memory_source.h"
+#include "settings.h"
+
+// Region-caching wrapper around a platform MemorySource. The address space
+// is walked once into a sorted interval list; queryRegion and therefore
+// IsReadableMemory, isValidMemoryRegion and SafeReadSourceWithRetry become
+// a binary search with no syscall. The list is walked again when a scan
+// asks for it through refreshRegions, or when it is older than the
+// regionMapRefreshInterval setting. A refresh swaps in the new list under
+// a short lock, so lookups never wait on a walk.
+//
+// Takes ownership of backend. Returns nullptr (and deletes backend) when
+// backend is nullptr or the first walk fails.
+MemorySource* CreateRegionMapSource(MemorySource* backend, const Settings* settings);
@@ -0,0 +1,266 @@
+#include "scan_buffer_pool.h"
+#include "logging.h"
+#include "scan_threads.h"
+
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <linux/mempolicy.h>
+#include <errno.h>
+#endif
+
+namespace {
+
+typedef struct {
+    BYTE* base;
+    size_t capacity;
+    bool largePages;
+    int node;
+} PoolBlock;
+
+std::mutex g_poolLock;
+std::vector<PoolBlock> g_idleBlocks;
+size_t g_idleBytes = 0;
+std::atomic<bool> g_largePagesFailed(false);    // Stop asking once the OS refused
+
+const size_t LARGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+#ifdef _WIN32
+const char* LARGE_PAGE_FALLBACK = "regular pages";
+#else
+const char* LARGE_PAGE_FALLBACK = "transparent huge pages";
+#endif
+
+size_t RoundUp(size_t size, size_t granularity) {
+    return (size + granularity - 1) / granularity * granularity;
+}
+
+size_t GetBufferAlignment(const Settings* settings) {
+    size_t alignment = 4096;
+    if (settings && settings->bufferAlignment > 4096) {
+        alignment = (size_t)settings->bufferAlignment;
+    }
+    // Only powers of two can be aligned to.
+    while (alignment & (alignment - 1)) {
+        alignment &= alignment - 1;
+    }
+    return alignment;
+}
+
+#ifdef _WIN32
+
+// Large pages need SeLockMemoryPrivilege granted to the account; enabling
+// it here fails harmlessly when it is not. Returns 0 without it.
+size_t QueryLargePageSize() {
+    size_t largePageSize = 0;
+    HANDLE token;
+    if (OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+        TOKEN_PRIVILEGES privileges;
+        privileges.PrivilegeCount = 1;
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        if (LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid)) {
+            AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr);
+            if (GetLastError() == ERROR_SUCCESS) {
+                largePageSize = GetLargePageMinimum();
+            }
+        }
+        CloseHandle(token);
+    }
+    return largePageSize;
+}
+
+BYTE* AllocateOnNode(size_t capacity, DWORD type, int node) {
+    if (node >= 0) {
+        return (BYTE*)VirtualAllocExNuma(GetCurrentProcess(), nullptr, capacity, type, PAGE_READWRITE, (DWORD)node);
+    }
+    return (BYTE*)VirtualAlloc(nullptr, capacity, type, PAGE_READWRITE);
+}
+
+BYTE* MapLargePages(size_t* capacity, int node) {
+    static const size_t largePageSize = QueryLargePageSize();
+    if (largePageSize == 0) {
+        return nullptr;
+    }
+    *capacity = RoundUp(*capacity, largePageSize);
+    return AllocateOnNode(*capacity, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, node);
+}
+
+// VirtualAlloc hands out 64 KB aligned addresses, which covers every
+// alignment the settings allow. Windows has no transparent large pages.
+BYTE* MapPages(size_t* capacity, size_t alignment, bool largePages, int node) {
+    (void)alignment;
+    (void)largePages;
+    return AllocateOnNode(*capacity, MEM_RESERVE | MEM_COMMIT, node);
+}
+
+void UnmapPages(BYTE* base, size_t capacity) {
+    (void)capacity;
+    VirtualFree(base, 0, MEM_RELEASE);
+}
+
+#else
+
+// Prefers node for the mapping's pages, which are only placed when first
+// touched. Calls mbind directly so the build needs no libnuma.
+void BindToNode(void* base, size_t capacity, int node) {
+    const size_t maskBits = sizeof(unsigned long) * 8;
+    unsigned long mask[4] = {};
+    if (node < 0 || (size_t)node >= sizeof(mask) * 8) {
+        return;
+    }
+    mask[node / maskBits] = 1UL << (node % maskBits);
+    if (syscall(SYS_mbind, base, capacity, MPOL_PREFERRED, mask, sizeof(mask) * 8 + 1, 0) != 0) {
+        LOG_DEBUG("Cannot place scan buffer on node %d (errno %d)", node, errno);
+    }
+}
+
+BYTE* MapLargePages(size_t* capacity, int node) {
+    *capacity = RoundUp(*capacity, LARGE_PAGE_SIZE);
+    void* p = mmap(nullptr, *capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p == MAP_FAILED) {
+        return nullptr;
+    }
+    BindToNode(p, *capacity, node);
+    return (BYTE*)p;
+}
+
+// Over-maps by the alignment and trims both ends. Transparent huge pages
+// only back 2 MB aligned ranges, so large page requests get that.
+BYTE* MapPages(size_t* capacity, size_t alignment, bool largePages, int node) {
+    if (largePages) {
+        *capacity = RoundUp(*capacity, LARGE_PAGE_SIZE);
+        alignment = std::max(alignment, LARGE_PAGE_SIZE);
+    }
+    size_t span = *capacity + alignment;
+    void* p = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return nullptr;
+    }
+    uintptr_t start = (uintptr_t)p;
+    uintptr_t aligned = RoundUp(start, alignment);
+    if (aligned > start) {
+        munmap(p, aligned - start);
+    }
+    if (start + span > aligned + *capacity) {
+        munmap((void*)(aligned + *capacity), start + span - (aligned + *capacity));
+    }
+    if (largePages) {
+        madvise((void*)aligned, *capacity, MADV_HUGEPAGE);
+    }
+    BindToNode((void*)aligned, *capacity, node);
+    return (BYTE*)aligned;
+}
+
+void UnmapPages(BYTE* base, size_t capacity) {
+    munmap(base, capacity);
+}
+
+#endif
+
+void FreeBlock(const PoolBlock& block) {
+    UnmapPages(block.base, block.capacity);
+}
+
+}
+
+void ScanBuffer::allocate(size_t size, const Settings* settings) {
+    release();
+    if (size == 0) {
+        return;
+    }
+
+    const size_t alignment = GetBufferAlignment(settings);
+    poolLimit = settings && settings->useBufferPooling ? settings->bufferPoolSize * 1024 * 1024 : 0;
+    const bool wantLargePages = settings && settings->useLargePages && size >= LARGE_PAGE_SIZE / 2;
+    const int wantNode = GetNumaNodeCount() > 1 ? GetScanThreadPlacement().node : -1;
+
+    // Smallest idle block that fits without wasting more than the request.
+    {
+        std::lock_guard<std::mutex> lock(g_poolLock);
+        size_t best = g_idleBlocks.size();
+        for (size_t i = 0; i < g_idleBlocks.size(); i++) {
+            const PoolBlock& block = g_idleBlocks[i];
+            if (block.capacity < size || block.capacity > size * 2 ||
+                ((uintptr_t)block.base & (alignment - 1)) != 0 || (wantNode >= 0 && block.node != wantNode)) {
+                continue;
+            }
+            if (best == g_idleBlocks.size() || block.capacity < g_idleBlocks[best].capacity) {
+                best = i;
+            }
+        }
+        if (best < g_idleBlocks.size()) {
+            base = g_idleBlocks[best].base;
+            capacity = g_idleBlocks[best].capacity;
+            largePages = g_idleBlocks[best].largePages;
+            node = g_idleBlocks[best].node;
+            length = size;
+            g_idleBytes -= capacity;
+            g_idleBlocks[best] = g_idleBlocks.back();
+            g_idleBlocks.pop_back();
+            return;
+        }
+    }
+
+    capacity = RoundUp(size, alignment);
+    if (wantLargePages && !g_largePagesFailed) {
+        size_t largeCapacity = capacity;
+        base = MapLargePages(&largeCapacity, wantNode);
+        if (base) {
+            capacity = largeCapacity;
+            largePages = true;
+        } else {
+            g_largePagesFailed = true;
+            LOG_INFO("Large pages unavailable, scan buffers use %s", LARGE_PAGE_FALLBACK);
+        }
+    }
+    if (!base) {
+        base = MapPages(&capacity, alignment, wantLargePages, wantNode);
+    }
+    if (!base) {
+        capacity = 0;
+        throw std::bad_alloc();
+    }
+    length = size;
+    node = wantNode;
+    LOG_DEBUG("Mapped %zu KB scan buffer%s", capacity / 1024, largePages ? " on large pages" : "");
+}
+
+void ScanBuffer::release() {
+    if (!base) {
+        return;
+    }
+    PoolBlock block = { base, capacity, largePages, node };
+    size_t limit = poolLimit;
+    base = nullptr;
+    length = 0;
+    capacity = 0;
+    largePages = false;
+    node = -1;
+
+    {
+        std::lock_guard<std::mutex> lock(g_poolLock);
+        if (g_idleBytes + block.capacity <= limit) {
+            g_idleBlocks.push_back(block);
+            g_idleBytes += block.capacity;
+            return;
+        }
+    }
+    FreeBlock(block);
+}
+
+void TrimScanBufferPool() {
+    std::vector<PoolBlock> blocks;
+    {
+        std::lock_guard<std::mutex> lock(g_poolLock);
+        blocks.swap(g_idleBlocks);
+        g_idleBytes = 0;
+    }
+    for (size_t i = 0; i < blocks.size(); i++) {
+        FreeBlock(blocks[i]);
+    }
+}
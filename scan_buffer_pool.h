@@ -0,0 +1,52 @@
+#pragma once
+
+#include "platform.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#include "settings.h"
+
+// Process-wide pool of chunk buffers shared by every scan worker. Buffers
+// come straight from the OS (mmap / VirtualAlloc), aligned to the
+// bufferAlignment setting and never zero-filled by the pool, so callers
+// must not rely on their contents. With useLargePages, buffers of at least
+// half a large page are backed by 2 MB pages when the OS grants them
+// (MAP_HUGETLB, falling back to transparent huge pages; MEM_LARGE_PAGES,
+// which needs the lock pages privilege). Released buffers stay idle in
+// the pool for the next scan, up to bufferPoolSize MB; with
+// useBufferPooling off they are freed on release. On NUMA machines a
+// pinned scan thread gets buffers placed on its own node.
+class ScanBuffer {
+private:
+    BYTE* base;
+    size_t length;          // Requested bytes
+    size_t capacity;        // Mapped bytes
+    bool largePages;
+    int node;               // NUMA node the pages were placed on, -1 if any
+    size_t poolLimit;       // Idle pool bytes allowed when this one is released
+
+    ScanBuffer(const ScanBuffer&);
+    ScanBuffer& operator=(const ScanBuffer&);
+
+public:
+    ScanBuffer() : base(nullptr), length(0), capacity(0), largePages(false), node(-1), poolLimit(0) {}
+    ScanBuffer(size_t size, const Settings* settings)
+        : base(nullptr), length(0), capacity(0), largePages(false), node(-1), poolLimit(0) {
+        allocate(size, settings);
+    }
+    ~ScanBuffer() { release(); }
+
+    // Releases the current buffer and takes one of at least size bytes.
+    // Throws std::bad_alloc when the OS has no memory left.
+    void allocate(size_t size, const Settings* settings);
+    void release();
+
+    BYTE* data() { return base; }
+    const BYTE* data() const { return base; }
+    size_t size() const { return length; }
+    BYTE& operator[](size_t index) { return base[index]; }
+    const BYTE& operator[](size_t index) const { return base[index]; }
+};
+
+// Frees every idle pooled buffer, e.g. after the settings change.
+void TrimScanBufferPool();
@@ -0,0 +1,1905 @@
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <cmath>
+#include <cfloat>
+#include <cerrno>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <immintrin.h>
+
+#include "scan_engine.h"
+#include "scan_pipeline.h"
+#include "scan_buffer_pool.h"
+#include "write_tracking.h"
+#include "logging.h"
+#ifdef _WIN32
+#include "memory_protection.h"
+#endif
+
+ScanResults g_scanResults = { VALUE_TYPE_INT, sizeof(int), 0, std::vector<ResultRegion>(), std::vector<ResultBlock>() };
+MemorySnapshot g_memorySnapshot;
+ValueType currentValueType = VALUE_TYPE_INT;
+std::mutex scanResultsMutex;
+
+std::atomic<bool> g_cancelScan{false};
+std::atomic<bool> g_scanInProgress{false};
+std::atomic<bool> g_resultsUpdated{false};
+std::atomic<size_t> g_regionsScanned{0};
+std::atomic<size_t> g_matchesFound{0};
+std::atomic<size_t> g_bytesScanned{0};
+std::atomic<size_t> g_regionsSkipped{0};
+std::atomic<size_t> g_bytesSkipped{0};
+std::atomic<size_t> g_totalMemoryToScan{0};
+size_t g_totalRegionsToScan = 0;
+double g_scanProgress = 0.0;
+
+template<typename T>
+T min_val(T a, T b) {
+    return (a < b) ? a : b;
+}
+
+template<typename T>
+T max_val(T a, T b) {
+    return (a > b) ? a : b;
+}
+
+SIZE_T min_val(SIZE_T a, DWORD b) {
+    return (a < static_cast<SIZE_T>(b)) ? a : static_cast<SIZE_T>(b);
+}
+
+std::atomic<bool> g_threadAlive{true};
+const DWORD THREAD_CHECK_INTERVAL = 500; // milliseconds
+
+int GetValueTypeSize(ValueType type) {
+    switch (type) {
+        case VALUE_TYPE_INT: return sizeof(int32_t);
+        case VALUE_TYPE_FLOAT: return sizeof(float);
+        case VALUE_TYPE_DOUBLE: return sizeof(double);
+        case VALUE_TYPE_SHORT: return sizeof(int16_t);
+        case VALUE_TYPE_BYTE: return sizeof(uint8_t);
+        case VALUE_TYPE_AUTO: return sizeof(int32_t);
+        case VALUE_TYPE_INT64: return sizeof(int64_t);
+        case VALUE_TYPE_UINT16: return sizeof(uint16_t);
+        case VALUE_TYPE_UINT32: return sizeof(uint32_t);
+        case VALUE_TYPE_UINT64: return sizeof(uint64_t);
+    }
+    return sizeof(int32_t);
+}
+
+static bool IsUnsignedType(ValueType type) {
+    return type == VALUE_TYPE_BYTE || type == VALUE_TYPE_UINT16 || type == VALUE_TYPE_UINT32 ||
+           type == VALUE_TYPE_UINT64;
+}
+
+ScanValue MakeScanValue(int64_t value) {
+    ScanValue result = { value, (double)value };
+    return result;
+}
+
+double GetScanEpsilon(const Settings* settings) {
+    return settings && settings->floatEpsilon > 0.0 ? settings->floatEpsilon : DEFAULT_SCAN_EPSILON;
+}
+
+bool parseScanValue(const char* text, ValueType type, ScanValue* value, const char** end) {
+    while (*text == ' ') text++;
+    char* stop = nullptr;
+    errno = 0;
+
+    if (type == VALUE_TYPE_FLOAT || type == VALUE_TYPE_DOUBLE) {
+        double parsed = strtod(text, &stop);
+        if (stop == text || errno == ERANGE || !std::isfinite(parsed) ||
+            (type == VALUE_TYPE_FLOAT && std::fabs(parsed) > FLT_MAX)) {
+            return false;
+        }
+        value->f = parsed;
+        value->i = std::fabs(parsed) < 9.2e18 ? (int64_t)parsed : 0;
+    } else {
+        // Integers of every width take either their signed or unsigned
+        // range, so 255 and -1 are both valid bytes.
+        int bits = (type == VALUE_TYPE_AUTO ? (int)sizeof(int32_t) : GetValueTypeSize(type)) * 8;
+        if (*text == '-') {
+            long long parsed = strtoll(text, &stop, 0);
+            if (stop == text || errno == ERANGE || (bits < 64 && parsed < -(1LL << (bits - 1)))) {
+                return false;
+            }
+            value->i = parsed;
+        } else {
+            unsigned long long parsed = strtoull(text, &stop, 0);
+            if (stop == text || errno == ERANGE || (bits < 64 && parsed > (1ULL << bits) - 1)) {
+                return false;
+            }
+            value->i = (int64_t)parsed;
+        }
+        value->f = IsUnsignedType(type) ? (double)(uint64_t)value->i : (double)value->i;
+
+        // Auto scans also look for floats, so a fraction is allowed there.
+        if (type == VALUE_TYPE_AUTO && (*stop == '.' || *stop == 'e' || *stop == 'E')) {
+            double parsed = strtod(text, &stop);
+            if (!std::isfinite(parsed) || std::fabs(parsed) > FLT_MAX) {
+                return false;
+            }
+            value->f = parsed;
+            value->i = (int64_t)parsed;
+        }
+    }
+
+    if (end) {
+        *end = stop;
+        return true;
+    }
+    while (*stop == ' ') stop++;
+    return *stop == '\0';
+}
+
+size_t EncodeScanValue(const ScanValue& value, ValueType type, BYTE* out) {
+    switch (type) {
+        case VALUE_TYPE_FLOAT: {
+            float v = (float)value.f;
+            memcpy(out, &v, sizeof(v));
+            return sizeof(v);
+        }
+        case VALUE_TYPE_DOUBLE:
+            memcpy(out, &value.f, sizeof(value.f));
+            return sizeof(value.f);
+        default: {
+            // Little-endian: the low bytes of i are the value at any width.
+            size_t size = GetValueTypeSize(type);
+            memcpy(out, &value.i, size);
+            return size;
+        }
+    }
+}
+
+void FormatScanValue(const BYTE* p, size_t available, ValueType type, char* text, size_t size) {
+    BYTE raw[sizeof(uint64_t)] = { 0 };
+    memcpy(raw, p, min_val(available, sizeof(raw)));
+    switch (type) {
+        case VALUE_TYPE_FLOAT: {
+            float v;
+            memcpy(&v, raw, sizeof(v));
+            snprintf(text, size, "%.7g", v);
+            break;
+        }
+        case VALUE_TYPE_DOUBLE: {
+            double v;
+            memcpy(&v, raw, sizeof(v));
+            snprintf(text, size, "%.15g", v);
+            break;
+        }
+        case VALUE_TYPE_SHORT: {
+            int16_t v;
+            memcpy(&v, raw, sizeof(v));
+            snprintf(text, size, "%d", v);
+            break;
+        }
+        case VALUE_TYPE_UINT16: {
+            uint16_t v;
+            memcpy(&v, raw, sizeof(v));
+            snprintf(text, size, "%u", v);
+            break;
+        }
+        case VALUE_TYPE_BYTE:
+            snprintf(text, size, "%u", raw[0]);
+            break;
+        case VALUE_TYPE_UINT32: {
+            uint32_t v;
+            memcpy(&v, raw, sizeof(v));
+            snprintf(text, size, "%u", v);
+            break;
+        }
+        case VALUE_TYPE_INT64: {
+            int64_t v;
+            memcpy(&v, raw, sizeof(v));
+            snprintf(text, size, "%lld", (long long)v);
+            break;
+        }
+        case VALUE_TYPE_UINT64: {
+            uint64_t v;
+            memcpy(&v, raw, sizeof(v));
+            snprintf(text, size, "%llu", (unsigned long long)v);
+            break;
+        }
+        default: {
+            int32_t v;
+            memcpy(&v, raw, sizeof(v));
+            snprintf(text, size, "%d", v);
+            break;
+        }
+    }
+}
+
+static void FormatValueText(const ScanValue& value, ValueType type, char* text, size_t size) {
+    BYTE bytes[sizeof(uint64_t)];
+    size_t length = EncodeScanValue(value, type, bytes);
+    FormatScanValue(bytes, length, type, text, size);
+}
+
+template<typename T> static inline T ScanValueAs(const ScanValue& value) { return (T)value.i; }
+template<> inline float ScanValueAs<float>(const ScanValue& value) { return (float)value.f; }
+template<> inline double ScanValueAs<double>(const ScanValue& value) { return value.f; }
+
+template<typename T>
+static inline bool TypedEquals(T a, T b, double) { return a == b; }
+static inline bool TypedEquals(float a, float b, double epsilon) { return std::fabs(a - b) < (float)epsilon; }
+static inline bool TypedEquals(double a, double b, double epsilon) { return std::fabs(a - b) < epsilon; }
+
+// Integer deltas wrap at the type's width, like the values themselves.
+template<typename T>
+static inline bool TypedDeltaEquals(T current, T previous, T delta, double) {
+    return (T)(current - previous) == delta;
+}
+static inline bool TypedDeltaEquals(float current, float previous, float delta, double epsilon) {
+    return std::fabs((current - previous) - delta) < (float)epsilon;
+}
+static inline bool TypedDeltaEquals(double current, double previous, double delta, double epsilon) {
+    return std::fabs((current - previous) - delta) < epsilon;
+}
+
+template<typename T, int COMPARE>
+static inline bool CompareTyped(T current, T previous, T value, double epsilon) {
+    switch (COMPARE) {
+        case SCAN_COMPARE_EXACT: return TypedEquals(current, value, epsilon);
+        case SCAN_COMPARE_CHANGED: return memcmp(&current, &previous, sizeof(T)) != 0;
+        case SCAN_COMPARE_UNCHANGED: return memcmp(&current, &previous, sizeof(T)) == 0;
+        case SCAN_COMPARE_INCREASED: return current > previous;
+        case SCAN_COMPARE_DECREASED: return current < previous;
+        case SCAN_COMPARE_INCREASED_BY: return TypedDeltaEquals(current, previous, value, epsilon);
+        case SCAN_COMPARE_DECREASED_BY: return TypedDeltaEquals(previous, current, value, epsilon);
+    }
+    return false;
+}
+
+// Offsets of every value starting below limit, at multiples of stride,
+// that passes COMPARE. Both buffers must hold every such value in full.
+// Identical 64-byte blocks are settled with one memcmp, which is what
+// makes changed/unchanged scans over mostly idle memory cheap.
+template<typename T, int COMPARE>
+static size_t CompareTypedBuffers(const BYTE* current, const BYTE* previous, size_t limit, size_t stride,
+                                  T value, double epsilon, uint32_t* offsets) {
+    const size_t BLOCK = 64;
+    const size_t blockBytes = BLOCK - stride + sizeof(T);
+    const bool sameMatches = COMPARE == SCAN_COMPARE_UNCHANGED ||
+                             ((COMPARE == SCAN_COMPARE_INCREASED_BY || COMPARE == SCAN_COMPARE_DECREASED_BY) &&
+                              TypedEquals(value, (T)0, epsilon));
+    size_t count = 0;
+    size_t offset = 0;
+    while (offset < limit) {
+        if (COMPARE != SCAN_COMPARE_EXACT && (offset & (BLOCK - 1)) == 0 && offset + BLOCK <= limit &&
+            memcmp(&current[offset], &previous[offset], blockBytes) == 0) {
+            if (sameMatches) {
+                for (size_t slot = offset; slot < offset + BLOCK; slot += stride) {
+                    offsets[count++] = (uint32_t)slot;
+                }
+            }
+            offset += BLOCK;
+            continue;
+        }
+
+        T currentValue;
+        T previousValue;
+        memcpy(&currentValue, &current[offset], sizeof(T));
+        memcpy(&previousValue, &previous[offset], sizeof(T));
+        if (CompareTyped<T, COMPARE>(currentValue, previousValue, value, epsilon)) {
+            offsets[count++] = (uint32_t)offset;
+        }
+        offset += stride;
+    }
+    return count;
+}
+
+template<typename T>
+static size_t CompareBuffersAs(const BYTE* current, const BYTE* previous, size_t limit, size_t stride,
+                               ScanCompareType compare, const ScanValue& value, double epsilon,
+                               uint32_t* offsets) {
+    T typed = ScanValueAs<T>(value);
+    switch (compare) {
+        case SCAN_COMPARE_EXACT:
+            return CompareTypedBuffers<T, SCAN_COMPARE_EXACT>(current, previous, limit, stride, typed, epsilon, offsets);
+        case SCAN_COMPARE_CHANGED:
+            return CompareTypedBuffers<T, SCAN_COMPARE_CHANGED>(current, previous, limit, stride, typed, epsilon, offsets);
+        case SCAN_COMPARE_UNCHANGED:
+            return CompareTypedBuffers<T, SCAN_COMPARE_UNCHANGED>(current, previous, limit, stride, typed, epsilon, offsets);
+        case SCAN_COMPARE_INCREASED:
+            return CompareTypedBuffers<T, SCAN_COMPARE_INCREASED>(current, previous, limit, stride, typed, epsilon, offsets);
+        case SCAN_COMPARE_DECREASED:
+            return CompareTypedBuffers<T, SCAN_COMPARE_DECREASED>(current, previous, limit, stride, typed, epsilon, offsets);
+        case SCAN_COMPARE_INCREASED_BY:
+            return CompareTypedBuffers<T, SCAN_COMPARE_INCREASED_BY>(current, previous, limit, stride, typed, epsilon, offsets);
+        case SCAN_COMPARE_DECREASED_BY:
+            return CompareTypedBuffers<T, SCAN_COMPARE_DECREASED_BY>(current, previous, limit, stride, typed, epsilon, offsets);
+        // Range compares are tested by FindRangeOffsets against the range
+        // from GetScanRange and never reach the buffer compares.
+        case SCAN_COMPARE_GREATER:
+        case SCAN_COMPARE_LESS:
+        case SCAN_COMPARE_BETWEEN:
+            break;
+    }
+    return 0;
+}
+
+// The type and compare are resolved here, once per buffer. Auto scans have
+// no single type to compare as, so they compare as int.
+static size_t CompareValueBuffers(const BYTE* current, const BYTE* previous, size_t limit, size_t stride,
+                                  ValueType type, ScanCompareType compare, const ScanValue& value,
+                                  double epsilon, uint32_t* offsets) {
+    switch (type) {
+        case VALUE_TYPE_FLOAT:
+            return CompareBuffersAs<float>(current, previous, limit, stride, compare, value, epsilon, offsets);
+        case VALUE_TYPE_DOUBLE:
+            return CompareBuffersAs<double>(current, previous, limit, stride, compare, value, epsilon, offsets);
+        case VALUE_TYPE_SHORT:
+            return CompareBuffersAs<int16_t>(current, previous, limit, stride, compare, value, epsilon, offsets);
+        case VALUE_TYPE_UINT16:
+            return CompareBuffersAs<uint16_t>(current, previous, limit, stride, compare, value, epsilon, offsets);
+        case VALUE_TYPE_BYTE:
+            return CompareBuffersAs<uint8_t>(current, previous, limit, stride, compare, value, epsilon, offsets);
+        case VALUE_TYPE_UINT32:
+            return CompareBuffersAs<uint32_t>(current, previous, limit, stride, compare, value, epsilon, offsets);
+        case VALUE_TYPE_INT64:
+            return CompareBuffersAs<int64_t>(current, previous, limit, stride, compare, value, epsilon, offsets);
+        case VALUE_TYPE_UINT64:
+            return CompareBuffersAs<uint64_t>(current, previous, limit, stride, compare, value, epsilon, offsets);
+        default:
+            return CompareBuffersAs<int32_t>(current, previous, limit, stride, compare, value, epsilon, offsets);
+    }
+}
+
+bool CompareScanValue(const BYTE* current, const BYTE* previous, ValueType type, ScanCompareType compare,
+                      const ScanValue& value, double epsilon, const ScanValue& high) {
+    // Range bounds do not depend on the settings, only fuzzy exact ones do.
+    ScanRange range;
+    if (GetScanRange(nullptr, type, compare, value, high, &range)) {
+        return MatchesRange(current, (size_t)GetValueTypeSize(type), range, type);
+    }
+    uint32_t offset;
+    return CompareValueBuffers(current, previous, 1, 1, type, compare, value, epsilon, &offset) == 1;
+}
+
+const char* GetScanCompareName(ScanCompareType compare) {
+    switch (compare) {
+        case SCAN_COMPARE_EXACT: return "exact";
+        case SCAN_COMPARE_CHANGED: return "changed";
+        case SCAN_COMPARE_UNCHANGED: return "unchanged";
+        case SCAN_COMPARE_INCREASED: return "increased";
+        case SCAN_COMPARE_DECREASED: return "decreased";
+        case SCAN_COMPARE_INCREASED_BY: return "increased by";
+        case SCAN_COMPARE_DECREASED_BY: return "decreased by";
+        case SCAN_COMPARE_GREATER: return "greater than";
+        case SCAN_COMPARE_LESS: return "less than";
+        case SCAN_COMPARE_BETWEEN: return "between";
+    }
+    return "unknown";
+}
+
+bool IsValueCompare(ScanCompareType compare) {
+    return compare == SCAN_COMPARE_EXACT || compare == SCAN_COMPARE_GREATER || compare == SCAN_COMPARE_LESS ||
+           compare == SCAN_COMPARE_BETWEEN;
+}
+
+// An empty range (low above high) when nothing can pass, e.g. greater
+// than the type's maximum.
+template<typename T>
+static void IntegerScanRange(ScanCompareType compare, const ScanValue& value, const ScanValue& high,
+                             ScanRange* range) {
+    const T min = std::numeric_limits<T>::min();
+    const T max = std::numeric_limits<T>::max();
+    T v = (T)value.i;
+    T low = min;
+    T top = max;
+    switch (compare) {
+        case SCAN_COMPARE_GREATER:
+            if (v == max) {
+                top = min;
+                low = max;
+            } else {
+                low = (T)(v + 1);
+            }
+            break;
+        case SCAN_COMPARE_LESS:
+            if (v == min) {
+                top = min;
+                low = max;
+            } else {
+                top = (T)(v - 1);
+            }
+            break;
+        default:
+            low = v;
+            top = (T)high.i;
+            break;
+    }
+    range->low = MakeScanValue((int64_t)low);
+    range->high = MakeScanValue((int64_t)top);
+}
+
+template<typename T>
+static void RealScanRange(ScanCompareType compare, const ScanValue& value, const ScanValue& high,
+                          double tolerance, double epsilon, ScanRange* range) {
+    const T infinity = std::numeric_limits<T>::infinity();
+    T v = (T)value.f;
+    T low = -infinity;
+    T top = infinity;
+    switch (compare) {
+        case SCAN_COMPARE_GREATER:
+            low = std::nextafter(v, infinity);
+            break;
+        case SCAN_COMPARE_LESS:
+            top = std::nextafter(v, -infinity);
+            break;
+        case SCAN_COMPARE_BETWEEN:
+            low = v;
+            top = (T)high.f;
+            break;
+        default: {
+            T slack = (T)std::max(std::fabs(value.f) * tolerance, epsilon);
+            low = v - slack;
+            top = v + slack;
+            break;
+        }
+    }
+    range->low.i = 0;
+    range->low.f = low;
+    range->high.i = 0;
+    range->high.f = top;
+}
+
+bool GetScanRange(const Settings* settings, ValueType type, ScanCompareType compare, const ScanValue& value,
+                  const ScanValue& high, ScanRange* range) {
+    if (compare == SCAN_COMPARE_EXACT) {
+        if ((type != VALUE_TYPE_FLOAT && type != VALUE_TYPE_DOUBLE) || !settings || !settings->useFuzzyScanning) {
+            return false;
+        }
+    } else if (compare != SCAN_COMPARE_GREATER && compare != SCAN_COMPARE_LESS && compare != SCAN_COMPARE_BETWEEN) {
+        return false;
+    }
+
+    double tolerance = settings ? settings->fuzzyThreshold : 0.0;
+    double epsilon = GetScanEpsilon(settings);
+    switch (type) {
+        case VALUE_TYPE_BYTE: IntegerScanRange<uint8_t>(compare, value, high, range); break;
+        case VALUE_TYPE_SHORT: IntegerScanRange<int16_t>(compare, value, high, range); break;
+        case VALUE_TYPE_UINT16: IntegerScanRange<uint16_t>(compare, value, high, range); break;
+        case VALUE_TYPE_UINT32: IntegerScanRange<uint32_t>(compare, value, high, range); break;
+        case VALUE_TYPE_INT64: IntegerScanRange<int64_t>(compare, value, high, range); break;
+        case VALUE_TYPE_UINT64: IntegerScanRange<uint64_t>(compare, value, high, range); break;
+        case VALUE_TYPE_FLOAT: RealScanRange<float>(compare, value, high, tolerance, epsilon, range); break;
+        case VALUE_TYPE_DOUBLE: RealScanRange<double>(compare, value, high, tolerance, epsilon, range); break;
+        default: IntegerScanRange<int32_t>(compare, value, high, range); break;
+    }
+    return true;
+}
+
+ResidencyPolicy GetResidencyPolicy(const Settings* settings, const std::vector<MemoryRegion>* regions,
+                                   bool searchingForZero) {
+    ResidencyPolicy policy;
+    policy.skipZeroPages = settings && settings->skipZeroRegions && !searchingForZero;
+    policy.skipSwappedPages = settings && settings->skipSwappedPages;
+    policy.regions = regions;
+    return policy;
+}
+
+bool IsLikelyValidDataRegion(const MemoryRegion& region, bool isSearchingForZero) {
+    if (region.size < 4096)
+        return false;
+    if (region.state != MEM_COMMIT)
+        return false;
+    if (!(region.protect & (PAGE_READONLY | PAGE_READWRITE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE)))
+        return false;
+    if (region.protect & (PAGE_GUARD | PAGE_NOACCESS))
+        return false;
+        
+    if (isSearchingForZero) {
+        if (region.type == MEM_MAPPED)
+            return false;           
+        if (region.type != MEM_PRIVATE)
+            return false;
+    }
+    
+    return true;
+}
+
+void validateScanResults() {
+    LOG_DEBUG("Validating scan results...");
+    if (g_scanResults.count > g_scanResults.blocks.size() * RESULT_BLOCK_ENTRIES) {
+        LOG_ERROR("Invalid scan results: %zu entries but only %zu blocks",
+                  g_scanResults.count, g_scanResults.blocks.size());
+        g_scanResults.count = 0;
+        g_scanResults.regions.clear();
+        return;
+    }
+
+    LOG_DEBUG("Scan results: %zu entries in %zu regions, %zu KB",
+              g_scanResults.count, g_scanResults.regions.size(),
+              getScanResultsMemoryUsage(&g_scanResults) / 1024);
+    if (g_scanResults.count > 0) {
+        LOG_DEBUG("First entry: 0x%llX = %d",
+                 (unsigned long long)getScanResultAddress(&g_scanResults, 0),
+                 getScanResultValueInt(&g_scanResults, 0));
+        LOG_DEBUG("Last entry: 0x%llX = %d",
+                 (unsigned long long)getScanResultAddress(&g_scanResults, g_scanResults.count - 1),
+                 getScanResultValueInt(&g_scanResults, g_scanResults.count - 1));
+    }
+}
+
+// True when every region under [address, address + size) passes accept.
+template<typename Accept>
+static bool EveryRegionUnder(MemorySource* source, uintptr_t address, SIZE_T size, Accept accept) {
+    const uintptr_t end = address + (size > 0 ? size : 1);
+    if (end < address) {
+        return false;
+    }
+    while (address < end) {
+        MemoryRegion region;
+        if (!source->queryRegion(address, &region) || region.base + region.size <= address || !accept(region)) {
+            return false;
+        }
+        address = region.base + region.size;
+    }
+    return true;
+}
+
+bool IsReadableMemory(MemorySource* source, uintptr_t address, SIZE_T size) {
+    return EveryRegionUnder(source, address, size, [](const MemoryRegion& region) {
+        return (region.state == MEM_COMMIT) &&
+               (region.protect & (PAGE_READONLY | PAGE_READWRITE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE)) &&
+               !(region.protect & (PAGE_GUARD | PAGE_NOACCESS));
+    });
+}
+
+bool SafeReadMemory(MemorySource* source, uintptr_t address, LPVOID buffer, SIZE_T size, SIZE_T* bytesRead) {
+    *bytesRead = 0;
+    if (!IsReadableMemory(source, address, size)) {
+        return false;
+    }
+    source->read(address, buffer, size, bytesRead);
+    return *bytesRead > 0;
+}
+
+int GetScanThreadCount(const Settings* settings) {
+    int threads = settings ? settings->threadCount : 1;
+    if (settings && settings->maxThreadCount > 0 && threads > settings->maxThreadCount) {
+        threads = settings->maxThreadCount;
+    }
+    return threads < 1 ? 1 : threads;
+}
+
+SIZE_T GetScanChunkSize(const Settings* settings) {
+    SIZE_T chunkSize = SCAN_CHUNK_SIZE;
+    if (settings && settings->scanChunkSize >= MIN_SCAN_CHUNK_SIZE) {
+        chunkSize = settings->scanChunkSize;
+    }
+    // Keep chunks page-aligned so aligned strides line up across chunks.
+    return (chunkSize + 4095) & ~(SIZE_T)4095;
+}
+
+SIZE_T GetScanStride(const Settings* settings, ValueType type) {
+    if (type == VALUE_TYPE_AUTO || (settings && settings->scanUnalignedAddresses)) {
+        return 1;
+    }
+    return GetValueTypeSize(type);
+}
+
+size_t AddRegionChunks(uintptr_t base, SIZE_T size, size_t regionIndex, SIZE_T chunkSize,
+                       std::vector<ScanChunk>& chunks) {
+    size_t count = 0;
+    for (SIZE_T offset = 0; offset < size; offset += chunkSize) {
+        ScanChunk chunk;
+        chunk.address = base + offset;
+        chunk.size = min_val(chunkSize, size - offset);
+        chunk.regionEnd = base + size;
+        chunk.regionIndex = regionIndex;
+        chunk.index = chunks.size();
+        chunks.push_back(chunk);
+        count++;
+    }
+    return count;
+}
+
+void scanMemory(ProcessInfo* process, const ScanValue& valueToFind, ScanCompareType compare,
+                const ScanValue& high) {
+    if (!process || !process->memory || !process->settings) {
+        LOG_ERROR("Invalid process handle");
+        ShowStatusMessage("Invalid process handle");
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(scanResultsMutex);
+        freeScanResults(&g_scanResults);
+        initScanResults(&g_scanResults, currentValueType);
+    }
+    freeMemorySnapshot(&g_memorySnapshot);
+
+    g_cancelScan = false;
+    g_scanInProgress = true;
+    g_regionsScanned = 0;
+    g_bytesScanned = 0;
+    g_matchesFound = 0;
+    g_regionsSkipped = 0;
+    g_bytesSkipped = 0;
+
+    std::vector<MemoryRegion> allRegions;
+    process->memory->refreshRegions();
+    process->memory->enumerateRegions(allRegions);
+
+    ScanRange range;
+    bool useRange = GetScanRange(process->settings, currentValueType, compare, valueToFind, high, &range);
+    BYTE zero[sizeof(uint64_t)] = { 0 };
+    bool searchingForZero = useRange ? MatchesRange(zero, sizeof(zero), range, currentValueType)
+                                     : valueToFind.i == 0 && valueToFind.f == 0.0;
+
+    std::vector<MemoryRegion> regions;
+    size_t totalBytes = 0;
+    for (const auto& region : allRegions) {
+        if (IsLikelyValidDataRegion(region, searchingForZero)) {
+            regions.push_back(region);
+            totalBytes += region.size;
+        } else if (region.state == MEM_COMMIT) {
+            g_regionsSkipped++;
+        }
+    }
+
+    const SIZE_T chunkSize = GetScanChunkSize(process->settings);
+    std::vector<ScanChunk> chunks;
+    std::unique_ptr<std::atomic<size_t>[]> regionChunksLeft(new std::atomic<size_t>[regions.size()]);
+    for (size_t r = 0; r < regions.size(); r++) {
+        regionChunksLeft[r] = AddRegionChunks(regions[r].base, regions[r].size, r, chunkSize, chunks);
+    }
+
+    g_totalRegionsToScan = regions.size();
+    g_totalMemoryToScan = totalBytes;
+
+    int threadCount = GetScanThreadCount(process->settings);
+    if ((size_t)threadCount > chunks.size()) {
+        threadCount = chunks.empty() ? 1 : (int)chunks.size();
+    }
+
+    LOG_INFO("Scanning %zu regions (%zu MB) as %zu chunks of %zu KB on %d threads",
+             regions.size(), totalBytes / (1024 * 1024), chunks.size(), chunkSize / 1024, threadCount);
+
+    WorkStealingQueue<ScanChunk> queue(threadCount);
+    queue.distribute(chunks);
+
+    const ResidencyPolicy residency = GetResidencyPolicy(process->settings, &regions, searchingForZero);
+    std::vector<ScanShard> shards(threadCount);
+    std::vector<ScanThreadData> threadData(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        threadData[i].process = process;
+        threadData[i].valueToFind = valueToFind;
+        threadData[i].useRange = useRange;
+        threadData[i].range = range;
+        threadData[i].residency = residency;
+        threadData[i].shard = &shards[i];
+        threadData[i].settings = process->settings;
+        threadData[i].queue = &queue;
+        threadData[i].workerIndex = i;
+        threadData[i].regionChunksLeft = regionChunksLeft.get();
+    }
+
+    // Every value kept is read from here on, so next scans can trust
+    // pages the target leaves alone after this.
+    if (process->settings->incrementalNextScan) {
+        beginWriteTracking(process->memory);
+    }
+    RunScanWorkers(scanMemoryThreadFunc, threadData, process->settings);
+
+    g_scanInProgress = false;
+    g_scanProgress = 1.0;
+
+    // The shards only cover the chunks finished before the cancel, so none
+    // are kept and the results stay empty.
+    if (g_cancelScan) {
+        endWriteTracking();
+        LOG_INFO("Scan cancelled, discarding partial results");
+        ShowStatusMessage("Scan cancelled");
+        return;
+    }
+
+    MergeScanShards(shards, chunks, GetScanStride(process->settings, currentValueType), &g_scanResults);
+    validateScanResults();
+    
+    size_t resultCount = g_scanResults.count;
+    size_t regionsScannedCount = g_regionsScanned.load();
+    LOG_INFO("Scan completed: Found %zu matches in %zu regions (%zu steals, %zu KB of pages skipped)",
+             resultCount, regionsScannedCount, queue.steals(), g_bytesSkipped.load() / 1024);
+    
+    ShowFormattedStatusMessage("Found %zu matches", resultCount);
+}
+
+// Rebuilds the store from the narrowing shards. Batches are laid out in
+// result order; each source region's survivors become one region starting
+// at its first survivor, re-picking its encoding for the new density.
+static bool MergeNarrowShards(std::vector<ScanShard>& shards, const std::vector<NarrowBatch>& batches,
+                              const ScanResults* source, ScanResults* narrowed) {
+    std::vector<const ScanShardRun*> runByBatch(batches.size(), nullptr);
+    std::vector<const ScanShard*> shardByBatch(batches.size(), nullptr);
+    for (size_t s = 0; s < shards.size(); s++) {
+        for (size_t r = 0; r < shards[s].runs.size(); r++) {
+            const ScanShardRun& run = shards[s].runs[r];
+            runByBatch[run.chunkIndex] = &run;
+            shardByBatch[run.chunkIndex] = &shards[s];
+        }
+    }
+
+    const size_t valueSize = source->valueSize;
+    for (size_t b = 0; b < batches.size(); ) {
+        size_t region = batches[b].region;
+        size_t end = b;
+        size_t count = 0;
+        size_t firstBatch = batches.size();
+        size_t lastBatch = 0;
+        for (; end < batches.size() && batches[end].region == region; end++) {
+            if (runByBatch[end]) {
+                count += runByBatch[end]->count;
+                if (firstBatch == batches.size()) firstBatch = end;
+                lastBatch = end;
+            }
+        }
+
+        if (count > 0) {
+            const ResultRegion& from = source->regions[region];
+            const ScanShardRun* firstRun = runByBatch[firstBatch];
+            const ScanShardRun* lastRun = runByBatch[lastBatch];
+            uint32_t first = shardByBatch[firstBatch]->offsets[firstRun->begin];
+            uint32_t last = shardByBatch[lastBatch]->offsets[lastRun->begin + lastRun->count - 1];
+            if (!addScanResultRegion(narrowed, from.base + first, last - first + 1, from.stride, count)) {
+                return false;
+            }
+
+            size_t target = narrowed->regions.size() - 1;
+            size_t entry = 0;
+            for (size_t i = firstBatch; i <= lastBatch; i++) {
+                const ScanShardRun* run = runByBatch[i];
+                if (!run) {
+                    continue;
+                }
+                const ScanShard* shard = shardByBatch[i];
+                storeScanResults(narrowed, target, entry, &shard->offsets[run->begin], 0U - first,
+                                 &shard->values[run->begin * valueSize],
+                                 &shard->originalValues[run->begin * valueSize], run->count);
+                entry += run->count;
+            }
+            closeScanResultRegion(narrowed, target);
+        }
+        b = end;
+    }
+    return true;
+}
+
+void narrowResults(ProcessInfo* process, ScanResults* results, const ScanValue& newValue, ScanCompareType compare,
+                   const ScanValue& high) {
+    if (!process || !process->memory || !process->settings || results->count == 0) {
+        LOG_WARNING("Cannot narrow results: invalid process or empty results");
+        return;
+    }
+
+    char valueText[32];
+    FormatValueText(newValue, results->valueType, valueText, sizeof(valueText));
+    LOG_INFO("Narrowing results from %zu entries: %s %s", results->count, GetScanCompareName(compare), valueText);
+
+    ScanRange range;
+    bool useRange = GetScanRange(process->settings, results->valueType, compare, newValue, high, &range);
+
+    std::vector<NarrowBatch> batches;
+    for (size_t r = 0; r < results->regions.size(); r++) {
+        for (size_t entry = 0; entry < results->regions[r].count; entry += NARROW_BATCH_ENTRIES) {
+            NarrowBatch batch;
+            batch.region = r;
+            batch.entry = entry;
+            batch.count = min_val(NARROW_BATCH_ENTRIES, results->regions[r].count - entry);
+            batch.index = batches.size();
+            batches.push_back(batch);
+        }
+    }
+
+    // Incremental steps only read results on pages written since the
+    // last full read; the rest keep their stored values.
+    std::vector<MemoryRegion> regions;
+    const bool incremental = process->settings->incrementalNextScan;
+    const bool reuseUnwritten = incremental && startIncrementalStep(process->memory);
+    if (reuseUnwritten) {
+        process->memory->refreshRegions();
+        process->memory->enumerateRegions(regions);
+    }
+    std::atomic<size_t> writtenHits(0);
+
+    g_cancelScan = false;
+    g_scanInProgress = true;
+    g_scanProgress = 0.0;
+    g_regionsScanned = 0;
+    g_bytesScanned = 0;
+    g_bytesSkipped = 0;
+    g_totalRegionsToScan = batches.size();
+
+    int threadCount = GetScanThreadCount(process->settings);
+    if ((size_t)threadCount > batches.size()) {
+        threadCount = batches.empty() ? 1 : (int)batches.size();
+    }
+
+    WorkStealingQueue<NarrowBatch> queue(threadCount);
+    queue.distribute(batches);
+
+    std::vector<ScanShard> shards(threadCount);
+    std::vector<NarrowThreadData> threadData(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        threadData[i].process = process;
+        threadData[i].results = results;
+        threadData[i].newValue = newValue;
+        threadData[i].compare = compare;
+        threadData[i].useRange = useRange;
+        threadData[i].range = range;
+        threadData[i].shard = &shards[i];
+        threadData[i].settings = process->settings;
+        threadData[i].queue = &queue;
+        threadData[i].workerIndex = i;
+        threadData[i].reuseUnwritten = reuseUnwritten;
+        threadData[i].regions = &regions;
+        threadData[i].writtenHits = &writtenHits;
+    }
+
+    RunScanWorkers(narrowResultsThreadFunc, threadData, process->settings);
+
+    g_scanInProgress = false;
+    g_scanProgress = 1.0;
+
+    // A cancelled narrow keeps every candidate rather than a partial set.
+    // Their values predate a record this step started, so it is dropped.
+    if (g_cancelScan) {
+        if (incremental && !reuseUnwritten) {
+            endWriteTracking();
+        }
+        LOG_INFO("Narrowing cancelled, keeping %zu entries", results->count);
+        ShowStatusMessage("Narrowing cancelled");
+        return;
+    }
+
+    ScanResults narrowed;
+    initScanResults(&narrowed, results->valueType);
+    if (!MergeNarrowShards(shards, batches, results, &narrowed)) {
+        LOG_ERROR("Failed to allocate narrowed results");
+        ShowStatusMessage("Out of memory while narrowing");
+        freeScanResults(&narrowed);
+        return;
+    }
+
+    if (reuseUnwritten) {
+        noteWrittenShare(writtenHits, results->count);
+    }
+
+    size_t before = results->count;
+    {
+        std::lock_guard<std::mutex> lock(scanResultsMutex);
+        std::swap(*results, narrowed);
+    }
+    freeScanResults(&narrowed);
+    g_resultsUpdated = true;
+    
+    LOG_INFO("Narrowing complete. Removed %zu entries, kept %zu entries (%zu batches, %zu steals, %zu KB reused).", 
+             before - results->count, results->count, batches.size(), queue.steals(), g_bytesSkipped.load() / 1024);
+    ShowFormattedStatusMessage("Narrowed to %zu results", results->count);
+}
+
+bool IsWritableProtection(DWORD protect) {
+    return (protect & (PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)) != 0;
+}
+
+void scanUnknownInitialValue(ProcessInfo* process) {
+    if (!process || !process->memory || !process->settings) {
+        LOG_ERROR("Invalid process handle");
+        ShowStatusMessage("Invalid process handle");
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(scanResultsMutex);
+        freeScanResults(&g_scanResults);
+        initScanResults(&g_scanResults, currentValueType);
+    }
+    freeMemorySnapshot(&g_memorySnapshot);
+    g_memorySnapshot.memoryLimit = process->settings->snapshotMemoryMB * 1024 * 1024;
+
+    g_cancelScan = false;
+    g_scanInProgress = true;
+    g_regionsScanned = 0;
+    g_bytesScanned = 0;
+    g_bytesSkipped = 0;
+    g_matchesFound = 0;
+    g_regionsSkipped = 0;
+
+    std::vector<MemoryRegion> allRegions;
+    process->memory->refreshRegions();
+    process->memory->enumerateRegions(allRegions);
+
+    const SIZE_T chunkSize = GetScanChunkSize(process->settings);
+    std::vector<ScanChunk> chunks;
+    std::vector<size_t> chunksPerRegion;
+    size_t totalBytes = 0;
+    for (const auto& region : allRegions) {
+        if (IsLikelyValidDataRegion(region, false) && IsWritableProtection(region.protect)) {
+            size_t r = addSnapshotRegion(&g_memorySnapshot, region.base, region.size);
+            chunksPerRegion.push_back(AddRegionChunks(region.base, region.size, r, chunkSize, chunks));
+            totalBytes += region.size;
+        } else if (region.state == MEM_COMMIT) {
+            g_regionsSkipped++;
+        }
+    }
+
+    std::unique_ptr<std::atomic<size_t>[]> regionChunksLeft(new std::atomic<size_t>[chunksPerRegion.size()]);
+    for (size_t r = 0; r < chunksPerRegion.size(); r++) {
+        regionChunksLeft[r] = chunksPerRegion[r];
+    }
+    g_totalRegionsToScan = chunksPerRegion.size();
+    g_totalMemoryToScan = totalBytes;
+
+    int threadCount = GetScanThreadCount(process->settings);
+    if ((size_t)threadCount > chunks.size()) {
+        threadCount = chunks.empty() ? 1 : (int)chunks.size();
+    }
+
+    LOG_INFO("Capturing snapshot of %zu writable regions (%zu MB) on %d threads",
+             chunksPerRegion.size(), totalBytes / (1024 * 1024), threadCount);
+
+    WorkStealingQueue<ScanChunk> queue(threadCount);
+    queue.distribute(chunks);
+
+    std::vector<SnapshotThreadData> threadData(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        threadData[i].process = process;
+        threadData[i].snapshot = &g_memorySnapshot;
+        threadData[i].shard = nullptr;
+        threadData[i].settings = process->settings;
+        threadData[i].queue = &queue;
+        threadData[i].workerIndex = i;
+        threadData[i].regionChunksLeft = regionChunksLeft.get();
+        threadData[i].compare = SCAN_COMPARE_UNCHANGED;
+        threadData[i].value = MakeScanValue(0);
+        threadData[i].useRange = false;
+        threadData[i].reuseUnwritten = false;
+        threadData[i].regions = nullptr;
+        threadData[i].writtenPages = nullptr;
+        threadData[i].checkedPages = nullptr;
+    }
+    if (process->settings->incrementalNextScan) {
+        beginWriteTracking(process->memory);
+    }
+    RunScanWorkers(snapshotCaptureThreadFunc, threadData, process->settings);
+
+    g_scanInProgress = false;
+    g_scanProgress = 1.0;
+    g_resultsUpdated = true;
+
+    if (g_cancelScan) {
+        freeMemorySnapshot(&g_memorySnapshot);
+        LOG_INFO("Snapshot capture cancelled");
+        ShowStatusMessage("Snapshot cancelled");
+        return;
+    }
+
+    LOG_INFO("Snapshot captured: %zu MB in %zu pages, %zu MB in memory, %llu MB on disk",
+             g_memorySnapshot.capturedBytes / (1024 * 1024), g_memorySnapshot.pages.size(),
+             g_memorySnapshot.memoryBytes / (1024 * 1024),
+             (unsigned long long)(g_memorySnapshot.spillBytes / (1024 * 1024)));
+    ShowFormattedStatusMessage("Captured %zu MB snapshot (%zu MB compressed)",
+                               g_memorySnapshot.capturedBytes / (1024 * 1024),
+                               (size_t)((g_memorySnapshot.memoryBytes + g_memorySnapshot.spillBytes) / (1024 * 1024)));
+}
+
+// First compare after an unknown initial value scan: every stride slot of
+// the snapshot is a candidate, so results are built here rather than
+// narrowed. The snapshot values become the results' original values.
+static void scanSnapshot(ProcessInfo* process, ScanCompareType compare, const ScanValue& value,
+                         const ScanValue& high) {
+    MemorySnapshot* snapshot = &g_memorySnapshot;
+
+    {
+        std::lock_guard<std::mutex> lock(scanResultsMutex);
+        freeScanResults(&g_scanResults);
+        initScanResults(&g_scanResults, currentValueType);
+    }
+
+    g_cancelScan = false;
+    g_scanInProgress = true;
+    g_regionsScanned = 0;
+    g_bytesScanned = 0;
+    g_bytesSkipped = 0;
+    g_matchesFound = 0;
+
+    const SIZE_T chunkSize = GetScanChunkSize(process->settings);
+    std::vector<ScanChunk> chunks;
+    std::unique_ptr<std::atomic<size_t>[]> regionChunksLeft(new std::atomic<size_t>[snapshot->regions.size()]);
+    for (size_t r = 0; r < snapshot->regions.size(); r++) {
+        regionChunksLeft[r] = AddRegionChunks(snapshot->regions[r].base, snapshot->regions[r].size, r,
+                                              chunkSize, chunks);
+    }
+    g_totalRegionsToScan = snapshot->regions.size();
+
+    int threadCount = GetScanThreadCount(process->settings);
+    if ((size_t)threadCount > chunks.size()) {
+        threadCount = chunks.empty() ? 1 : (int)chunks.size();
+    }
+
+    char valueText[32];
+    FormatValueText(value, currentValueType, valueText, sizeof(valueText));
+    LOG_INFO("Comparing against snapshot: %s %s over %zu regions on %d threads",
+             GetScanCompareName(compare), valueText, snapshot->regions.size(), threadCount);
+
+    ScanRange range;
+    bool useRange = GetScanRange(process->settings, currentValueType, compare, value, high, &range);
+
+    // Pages the target has not written since the capture still equal the
+    // snapshot, so incremental steps only read the written ones.
+    std::vector<MemoryRegion> regions;
+    const bool incremental = process->settings->incrementalNextScan;
+    const bool reuseUnwritten = incremental && startIncrementalStep(process->memory);
+    if (reuseUnwritten) {
+        process->memory->refreshRegions();
+        process->memory->enumerateRegions(regions);
+    }
+    std::atomic<size_t> writtenPages(0);
+    std::atomic<size_t> checkedPages(0);
+
+    WorkStealingQueue<ScanChunk> queue(threadCount);
+    queue.distribute(chunks);
+
+    std::vector<ScanShard> shards(threadCount);
+    std::vector<SnapshotThreadData> threadData(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        threadData[i].process = process;
+        threadData[i].snapshot = snapshot;
+        threadData[i].shard = &shards[i];
+        threadData[i].settings = process->settings;
+        threadData[i].queue = &queue;
+        threadData[i].workerIndex = i;
+        threadData[i].regionChunksLeft = regionChunksLeft.get();
+        threadData[i].compare = compare;
+        threadData[i].value = value;
+        threadData[i].useRange = useRange;
+        threadData[i].range = range;
+        threadData[i].reuseUnwritten = reuseUnwritten;
+        threadData[i].regions = &regions;
+        threadData[i].writtenPages = &writtenPages;
+        threadData[i].checkedPages = &checkedPages;
+    }
+    RunScanWorkers(snapshotCompareThreadFunc, threadData, process->settings);
+
+    g_scanInProgress = false;
+    g_scanProgress = 1.0;
+
+    // A cancelled compare leaves the snapshot in place for another try,
+    // which predates a record this step started.
+    if (g_cancelScan) {
+        if (incremental && !reuseUnwritten) {
+            endWriteTracking();
+        }
+        LOG_INFO("Snapshot compare cancelled");
+        ShowStatusMessage("Scan cancelled");
+        return;
+    }
+
+    MergeScanShards(shards, chunks, GetScanStride(process->settings, currentValueType), &g_scanResults);
+    freeMemorySnapshot(snapshot);
+    if (reuseUnwritten) {
+        noteWrittenShare(writtenPages, checkedPages);
+    }
+
+    LOG_INFO("Snapshot compare completed: %zu matches (%zu KB reused)", g_scanResults.count,
+             g_bytesSkipped.load() / 1024);
+    ShowFormattedStatusMessage("Found %zu matches", g_scanResults.count);
+}
+
+void nextScan(ProcessInfo* process, ScanCompareType compare, const ScanValue& value, const ScanValue& high) {
+    if (!process || !process->memory || !process->settings) {
+        LOG_ERROR("Invalid process handle");
+        ShowStatusMessage("Invalid process handle");
+        return;
+    }
+
+    if (hasMemorySnapshot(&g_memorySnapshot)) {
+        scanSnapshot(process, compare, value, high);
+    } else {
+        narrowResults(process, &g_scanResults, value, compare, high);
+    }
+}
+
+void updateMemoryValue(ProcessInfo* process, uintptr_t address, const ScanValue& newValue) {
+    if (!process || !process->memory) {
+        LOG_ERROR("Invalid process for memory write");
+        ShowStatusMessage("Invalid process for memory write");
+        return;
+    }
+
+    bool needProtectionChange = false;
+    
+    MemoryRegion region;
+    if (process->memory->queryRegion((uintptr_t)address, &region)) {
+        LOG_DEBUG("Memory at 0x%llX has protection: 0x%X", (unsigned long long)address, region.protect);
+        
+        if (!(region.protect & PAGE_READWRITE) && 
+            !(region.protect & PAGE_EXECUTE_READWRITE) &&
+            !(region.protect & PAGE_WRITECOPY) &&
+            !(region.protect & PAGE_EXECUTE_WRITECOPY)) {
+            
+            needProtectionChange = true;
+        }
+    }
+    
+#ifdef _WIN32
+    HANDLE processHandle = OpenProcess(PROCESS_VM_READ | PROCESS_VM_WRITE | PROCESS_VM_OPERATION, 
+                                     FALSE, process->processId);
+    if (!processHandle) {
+        LOG_ERROR("Failed to open process with write permissions");
+        ShowStatusMessage("Failed to get write permissions");
+        return;
+    }
+
+    MemoryProtectionContext* protContext = CreateProtectionContext(processHandle, 
+        (LPVOID)(uintptr_t)address, GetValueTypeSize(currentValueType));
+
+    if (needProtectionChange && process->settings->overwriteMemoryProtection) {
+        LOG_DEBUG("Attempting to modify memory protection for address 0x%llX", (unsigned long long)address);
+        
+        if (!ModifyMemoryProtection(protContext, PAGE_READWRITE)) {
+            LOG_ERROR("Failed to modify memory protection for address 0x%llX", (unsigned long long)address);
+            ShowFormattedStatusMessage("Failed to modify memory protection for address 0x%llX", (unsigned long long)address);
+            DestroyProtectionContext(protContext);
+            CloseHandle(processHandle);
+            return;
+        }
+        
+        LOG_DEBUG("Successfully modified memory protection for address 0x%llX", (unsigned long long)address);
+    }
+#else
+    if (needProtectionChange) {
+        LOG_WARNING("Address 0x%llX is not writable; protection changes are not supported on this platform", 
+                   (unsigned long long)address);
+    }
+#endif
+
+    BYTE bytes[sizeof(uint64_t)];
+    size_t size = EncodeScanValue(newValue, currentValueType, bytes);
+    char valueText[32];
+    FormatScanValue(bytes, size, currentValueType, valueText, sizeof(valueText));
+
+    size_t bytesWritten = 0;
+    if (process->memory->write((uintptr_t)address, bytes, size, &bytesWritten)) {
+        LOG_INFO("Successfully wrote value %s to address 0x%llX", valueText, (unsigned long long)address);
+        ShowFormattedStatusMessage("Value %s written successfully to 0x%llX", valueText, (unsigned long long)address);
+        
+        BYTE verifyBytes[sizeof(uint64_t)];
+        size_t verifyBytesRead;
+        if (SafeReadSourceWithRetry(process->memory, (uintptr_t)address, 
+                                 verifyBytes, size, &verifyBytesRead, 3)) {
+            if (memcmp(verifyBytes, bytes, size) == 0) {
+                LOG_DEBUG("Write verified successfully: value %s at 0x%llX", valueText, (unsigned long long)address);
+            } else {
+                char verifyText[32];
+                FormatScanValue(verifyBytes, size, currentValueType, verifyText, sizeof(verifyText));
+                LOG_WARNING("Write verification failed: expected %s, read %s at 0x%llX", 
+                           valueText, verifyText, (unsigned long long)address);
+            }
+        }
+    } else {
+        ShowFormattedStatusMessage("Failed to write value to 0x%llX", (unsigned long long)address);
+    }
+
+#ifdef _WIN32
+    RestoreMemoryProtection(protContext);
+    
+    DestroyProtectionContext(protContext);
+    CloseHandle(processHandle);
+#endif
+}
+
+bool isValidMemoryRegion(MemorySource* source, uintptr_t address, SIZE_T size) {
+    return EveryRegionUnder(source, address, size, [](const MemoryRegion& region) {
+        return region.state == MEM_COMMIT &&
+               (region.protect & (PAGE_READONLY | PAGE_READWRITE | PAGE_EXECUTE_READ |
+                                  PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)) &&
+               !(region.protect & PAGE_GUARD) &&
+               !(region.protect & PAGE_NOACCESS);
+    });
+}
+
+// Snapshot check for one chunk's hits: re-reads only the pages that hold
+// hits (or the chunk's runs whole when most of them do, never the pages
+// the residency policy skipped) and keeps a hit only if its bytes are
+// unchanged since the bulk read. Compacts offsets in place and returns the
+// surviving count.
+static size_t VerifyChunkHits(MemorySource* memory, const ScanChunk& chunk, const std::vector<ChunkRun>& runs,
+                              const BYTE* buffer, SIZE_T bufferSize, SIZE_T valueSize, uint32_t* offsets,
+                              size_t hitCount, std::vector<BYTE>& verifyBuffer,
+                              std::vector<ScatterEntry>& scatter) {
+    const SIZE_T PAGE_SIZE = 4096;
+    if (verifyBuffer.size() < bufferSize) {
+        verifyBuffer.resize(bufferSize);
+    }
+
+    // Consecutive hit pages become one run; each run also covers the
+    // first valueSize-1 bytes after it so straddling values are complete,
+    // as far as the chunk run holding the hit was read.
+    scatter.clear();
+    SIZE_T runBytes = 0;
+    size_t chunkRun = 0;
+    for (size_t h = 0; h < hitCount; h++) {
+        while (chunkRun + 1 < runs.size() && offsets[h] >= runs[chunkRun].end) {
+            chunkRun++;
+        }
+        SIZE_T pageStart = max_val(offsets[h] & ~(PAGE_SIZE - 1), runs[chunkRun].begin);
+        SIZE_T pageEnd = min_val(min_val(pageStart + PAGE_SIZE + valueSize - 1, runs[chunkRun].valid), bufferSize);
+        if (!scatter.empty()) {
+            ScatterEntry& last = scatter.back();
+            SIZE_T lastStart = last.address - chunk.address;
+            if (pageStart <= lastStart + last.size) {
+                if (pageEnd > lastStart + last.size) {
+                    runBytes += pageEnd - (lastStart + last.size);
+                    last.size = pageEnd - lastStart;
+                }
+                continue;
+            }
+        }
+        ScatterEntry entry = { chunk.address + pageStart, &verifyBuffer[pageStart], pageEnd - pageStart, 0 };
+        scatter.push_back(entry);
+        runBytes += entry.size;
+    }
+
+    SIZE_T readBytes = 0;
+    for (size_t r = 0; r < runs.size(); r++) {
+        readBytes += min_val(runs[r].valid, bufferSize) - min_val(runs[r].begin, bufferSize);
+    }
+    if (runBytes > readBytes / 2) {
+        // A run's tail may reach into the next run, so those are joined.
+        scatter.clear();
+        for (size_t r = 0; r < runs.size(); r++) {
+            SIZE_T begin = runs[r].begin;
+            SIZE_T end = min_val(runs[r].valid, bufferSize);
+            if (end <= begin) {
+                continue;
+            }
+            if (!scatter.empty()) {
+                ScatterEntry& last = scatter.back();
+                SIZE_T lastStart = last.address - chunk.address;
+                if (begin <= lastStart + last.size) {
+                    last.size = max_val(last.size, end - lastStart);
+                    continue;
+                }
+            }
+            ScatterEntry entry = { chunk.address + begin, &verifyBuffer[begin], end - begin, 0 };
+            scatter.push_back(entry);
+        }
+    }
+    memory->readScatter(scatter.data(), scatter.size());
+
+    size_t kept = 0;
+    size_t run = 0;
+    for (size_t h = 0; h < hitCount; h++) {
+        SIZE_T offset = offsets[h];
+        while (run < scatter.size() &&
+               offset >= (scatter[run].address - chunk.address) + scatter[run].size) {
+            run++;
+        }
+        if (run == scatter.size()) {
+            break;
+        }
+
+        SIZE_T compareSize = min_val(valueSize, bufferSize - offset);
+        SIZE_T validEnd = (scatter[run].address - chunk.address) + scatter[run].bytesRead;
+        if (offset + compareSize <= validEnd &&
+            memcmp(&buffer[offset], &verifyBuffer[offset], compareSize) == 0) {
+            offsets[kept++] = (uint32_t)offset;
+        }
+    }
+    return kept;
+}
+
+unsigned __stdcall scanMemoryThreadFunc(void* arg) {
+    ScanThreadData* data = static_cast<ScanThreadData*>(arg);
+    if (!data || !data->process || !data->process->memory || !data->settings || 
+        !data->shard || !data->queue) {
+        LOG_ERROR("Invalid thread data");
+        return 1;
+    }
+    
+    DWORD threadId = GetCurrentThreadId();
+    MemorySource* memory = data->process->memory;
+    LOG_DEBUG("Thread %lu: Scan worker %d started", threadId, data->workerIndex);
+    
+    ScanShard* shard = data->shard;
+    
+    size_t threadBytesScanned = 0;
+    size_t threadMatchesFound = 0;
+    size_t threadChunksScanned = 0;
+    
+    try {
+        const int valueTypeSize = GetValueTypeSize(currentValueType);
+        // Auto scans also try doubles, so they need a wider overlap.
+        const SIZE_T overlap = (currentValueType == VALUE_TYPE_AUTO ? sizeof(double) : valueTypeSize) - 1;
+        const SIZE_T chunkSize = GetScanChunkSize(data->settings);
+        const SIZE_T stride = GetScanStride(data->settings, currentValueType);
+        const ScanKernelLevel kernelLevel = data->settings->useVectorizedOperations ?
+                                            GetScanKernelLevel() : SCAN_KERNEL_SCALAR;
+        
+        const bool verify = data->settings->verifyScanHits;
+        const double epsilon = GetScanEpsilon(data->settings);
+        
+        // With a pipeline depth the reads happen on the ring's reader
+        // thread, a few chunks ahead of the compares below.
+        const size_t pipelineDepth = GetScanPipelineDepth(data->settings);
+        std::unique_ptr<ChunkReadRing> ring;
+        if (pipelineDepth > 0) {
+            ring.reset(new ChunkReadRing(memory, data->queue, data->workerIndex, pipelineDepth, chunkSize, overlap,
+                                         data->residency, data->settings, &g_cancelScan));
+        }
+        ChunkRead inlineRead;
+        if (!ring) {
+            inlineRead.buffer.allocate(chunkSize + overlap, data->settings);
+        }
+        // Each run may need one entry past its own share.
+        const size_t maxOffsets = chunkSize / stride + chunkSize / RESIDENCY_PAGE_SIZE + 2;
+        ScanBuffer offsetBuffer(maxOffsets * sizeof(uint32_t), data->settings);
+        uint32_t* offsets = reinterpret_cast<uint32_t*>(offsetBuffer.data());
+        std::vector<BYTE> verifyBuffer;
+        std::vector<ScatterEntry> scatter;
+
+        for (;;) {
+            ChunkRead* read;
+            if (ring) {
+                read = ring->acquire();
+                if (!read) {
+                    break;
+                }
+            } else {
+                ScanChunk next;
+                if (g_cancelScan || !data->queue->next(data->workerIndex, &next)) {
+                    break;
+                }
+                ReadScanChunk(memory, next, overlap, data->residency, &inlineRead);
+                read = &inlineRead;
+            }
+            const ScanChunk chunk = read->chunk;
+            const BYTE* buffer = read->buffer.data();
+            size_t runBegin = shard->offsets.size();
+
+            if (data->settings->prefetchMemory) {
+                _mm_prefetch(reinterpret_cast<const char*>(buffer), _MM_HINT_T0);
+            }
+
+            // Only hits that start inside this chunk belong to it; the
+            // overlap tail is owned by the next chunk. Runs come in address
+            // order, so their hits stay sorted.
+            size_t hitCount = 0;
+            SIZE_T validEnd = 0;
+            for (size_t r = 0; r < read->runs.size(); r++) {
+                const ChunkRun& run = read->runs[r];
+                if (run.valid < run.begin + valueTypeSize) {
+                    continue;
+                }
+                uint32_t* runOffsets = offsets + hitCount;
+                size_t count = data->useRange
+                    ? FindRangeOffsets(buffer + run.begin, run.valid - run.begin, run.end - run.begin, data->range,
+                                       currentValueType, stride, runOffsets, kernelLevel)
+                    : FindValueOffsets(buffer + run.begin, run.valid - run.begin, run.end - run.begin,
+                                       data->valueToFind, currentValueType, stride, epsilon, runOffsets, kernelLevel);
+                for (size_t h = 0; h < count; h++) {
+                    runOffsets[h] += (uint32_t)run.begin;
+                }
+                hitCount += count;
+                validEnd = run.valid;
+            }
+
+            // Only the kept bytes are checked: for auto that is the int
+            // width, not the double the overlap allows for.
+            if (verify && hitCount > 0) {
+                hitCount = VerifyChunkHits(memory, chunk, read->runs, buffer, validEnd, valueTypeSize,
+                                           offsets, hitCount, verifyBuffer, scatter);
+            }
+
+            shard->offsets.insert(shard->offsets.end(), offsets, offsets + hitCount);
+            for (size_t h = 0; h < hitCount; h++) {
+                const BYTE* value = &buffer[offsets[h]];
+                shard->values.insert(shard->values.end(), value, value + valueTypeSize);
+            }
+
+            SIZE_T scanned = read->bytesScanned;
+            g_bytesSkipped += read->bytesSkipped;
+            if (ring) {
+                ring->release(read);
+            }
+
+            size_t runCount = shard->offsets.size() - runBegin;
+            if (runCount > 0) {
+                ScanShardRun run = { chunk.index, runBegin, runCount };
+                shard->runs.push_back(run);
+                threadMatchesFound += runCount;
+                g_matchesFound += runCount;
+            }
+
+            g_bytesScanned += scanned;
+            threadBytesScanned += scanned;
+            threadChunksScanned++;
+
+            if (--data->regionChunksLeft[chunk.regionIndex] == 0) {
+                g_regionsScanned++;
+                if (g_totalRegionsToScan > 0) {
+                    g_scanProgress = (double)g_regionsScanned / g_totalRegionsToScan;
+                }
+            }
+        }
+
+    } catch (const std::exception& e) {
+        LOG_ERROR("Thread %lu error: %s", threadId, e.what());
+    }
+    
+    LOG_DEBUG("Thread %lu: Scanned %zu chunks (%zu bytes), found %zu matches", 
+              threadId, threadChunksScanned, threadBytesScanned, threadMatchesFound);
+    return 0;
+}
+
+unsigned __stdcall narrowResultsThreadFunc(void* arg) {
+    NarrowThreadData* data = static_cast<NarrowThreadData*>(arg);
+    if (!data || !data->process || !data->process->memory || !data->results ||
+        !data->settings || !data->shard || !data->queue) {
+        LOG_ERROR("Invalid thread data");
+        return 1;
+    }
+
+    DWORD threadId = GetCurrentThreadId();
+    MemorySource* memory = data->process->memory;
+    const ScanResults* results = data->results;
+    ScanShard* shard = data->shard;
+    size_t threadBatches = 0;
+    size_t threadKept = 0;
+    size_t threadReused = 0;
+
+    try {
+        const size_t valueSize = results->valueSize;
+        const double epsilon = GetScanEpsilon(data->settings);
+        const ScanKernelLevel kernelLevel = data->settings->useVectorizedOperations ?
+                                            GetScanKernelLevel() : SCAN_KERNEL_SCALAR;
+
+        std::vector<uint32_t> offsets(NARROW_BATCH_ENTRIES);
+        std::vector<ScatterEntry> scatter;
+        std::vector<size_t> runFirstHit;
+        std::vector<SIZE_T> runBufferOffset;
+        std::vector<BYTE> buffer;
+        std::vector<BYTE> packed(NARROW_BATCH_ENTRIES * valueSize);
+        std::vector<BYTE> previous(IsValueCompare(data->compare) ? 0 : NARROW_BATCH_ENTRIES * valueSize);
+        std::vector<uint32_t> packedHit(NARROW_BATCH_ENTRIES);
+        std::vector<uint32_t> matches(NARROW_BATCH_ENTRIES + 1);
+        std::vector<BYTE> written(NARROW_BATCH_ENTRIES);
+        std::vector<BYTE> pageFlags;
+
+        NarrowBatch batch;
+        while (!g_cancelScan && data->queue->next(data->workerIndex, &batch)) {
+            const ResultRegion& region = results->regions[batch.region];
+            size_t n = getScanResultOffsets(results, batch.region, batch.entry, offsets.data(), batch.count);
+            if (!data->reuseUnwritten || !findWrittenValues(memory, *data->regions, region.base, offsets.data(), n,
+                                                            valueSize, written.data(), pageFlags)) {
+                memset(written.data(), 1, n);
+            }
+
+            // Hits closer than NARROW_MERGE_GAP share a read; every run
+            // lands back to back in buffer and one readScatter fills them.
+            // Hits on unwritten pages are not read at all.
+            scatter.clear();
+            runFirstHit.clear();
+            runBufferOffset.clear();
+            SIZE_T bufferBytes = 0;
+            for (size_t h = 0; h < n; h++) {
+                if (!written[h]) {
+                    continue;
+                }
+                if (!scatter.empty()) {
+                    ScatterEntry& last = scatter.back();
+                    SIZE_T lastEnd = (SIZE_T)(last.address - region.base) + last.size;
+                    if (offsets[h] <= lastEnd + NARROW_MERGE_GAP) {
+                        SIZE_T end = max_val(lastEnd, (SIZE_T)offsets[h] + valueSize);
+                        bufferBytes += end - lastEnd;
+                        last.size = end - (SIZE_T)(last.address - region.base);
+                        continue;
+                    }
+                }
+                ScatterEntry entry = { region.base + offsets[h], nullptr, valueSize, 0 };
+                scatter.push_back(entry);
+                runFirstHit.push_back(h);
+                runBufferOffset.push_back(bufferBytes);
+                bufferBytes += valueSize;
+            }
+            if (buffer.size() < bufferBytes) {
+                buffer.resize(bufferBytes);
+            }
+            for (size_t r = 0; r < scatter.size(); r++) {
+                scatter[r].buffer = &buffer[runBufferOffset[r]];
+            }
+            memory->readScatter(scatter.data(), scatter.size());
+
+            // Pack every fully read or reused value contiguously, in hit
+            // order, so the scan kernels can compare the whole batch at the
+            // value's own stride.
+            size_t packedCount = 0;
+            size_t reused = 0;
+            size_t r = 0;
+            for (size_t h = 0; h < n; h++) {
+                const BYTE* source;
+                if (!written[h]) {
+                    source = getScanResultValue(results, region.firstEntry + batch.entry + h);
+                    reused++;
+                } else {
+                    while (r + 1 < scatter.size() && runFirstHit[r + 1] <= h) {
+                        r++;
+                    }
+                    SIZE_T at = offsets[h] - (SIZE_T)(scatter[r].address - region.base);
+                    if (at + valueSize > scatter[r].bytesRead) {
+                        continue;
+                    }
+                    source = (const BYTE*)scatter[r].buffer + at;
+                }
+                memcpy(&packed[packedCount * valueSize], source, valueSize);
+                packedHit[packedCount++] = (uint32_t)h;
+            }
+            SIZE_T batchRead = 0;
+            for (size_t i = 0; i < scatter.size(); i++) {
+                batchRead += scatter[i].bytesRead;
+            }
+            g_bytesScanned += batchRead;
+            g_bytesSkipped += reused * valueSize;
+            if (data->reuseUnwritten) {
+                *data->writtenHits += n - reused;
+            }
+            threadReused += reused;
+
+            size_t matchCount = 0;
+            if (data->useRange) {
+                matchCount = FindRangeOffsets(packed.data(), packedCount * valueSize, packedCount * valueSize,
+                                              data->range, results->valueType, valueSize, matches.data(),
+                                              kernelLevel);
+            } else if (!IsValueCompare(data->compare)) {
+                for (size_t i = 0; i < packedCount; i++) {
+                    size_t index = region.firstEntry + batch.entry + packedHit[i];
+                    memcpy(&previous[i * valueSize], getScanResultValue(results, index), valueSize);
+                }
+                matchCount = CompareValueBuffers(packed.data(), previous.data(), packedCount * valueSize, valueSize,
+                                                 results->valueType, data->compare, data->newValue, epsilon,
+                                                 matches.data());
+            } else if (results->valueType == VALUE_TYPE_AUTO) {
+                // Auto hits only kept their first valueSize bytes, so each
+                // is checked as the types that fit in those.
+                for (size_t i = 0; i < packedCount; i++) {
+                    if (MatchesValue(&packed[i * valueSize], valueSize, data->newValue, VALUE_TYPE_AUTO, epsilon)) {
+                        matches[matchCount++] = (uint32_t)(i * valueSize);
+                    }
+                }
+            } else {
+                matchCount = FindValueOffsets(packed.data(), packedCount * valueSize, packedCount * valueSize,
+                                              data->newValue, results->valueType, valueSize, epsilon,
+                                              matches.data(), kernelLevel);
+            }
+
+            size_t runBegin = shard->offsets.size();
+            for (size_t m = 0; m < matchCount; m++) {
+                size_t p = matches[m] / valueSize;
+                size_t h = packedHit[p];
+                const BYTE* value = &packed[p * valueSize];
+                const BYTE* original = getScanResultOriginal(results, region.firstEntry + batch.entry + h);
+                shard->offsets.push_back(offsets[h]);
+                shard->values.insert(shard->values.end(), value, value + valueSize);
+                shard->originalValues.insert(shard->originalValues.end(), original, original + valueSize);
+            }
+
+            size_t runCount = shard->offsets.size() - runBegin;
+            if (runCount > 0) {
+                ScanShardRun run = { batch.index, runBegin, runCount };
+                shard->runs.push_back(run);
+                threadKept += runCount;
+            }
+            threadBatches++;
+
+            g_regionsScanned++;
+            if (g_totalRegionsToScan > 0) {
+                g_scanProgress = (double)g_regionsScanned / g_totalRegionsToScan;
+            }
+        }
+
+    } catch (const std::exception& e) {
+        LOG_ERROR("Thread %lu error: %s", threadId, e.what());
+    }
+
+    LOG_DEBUG("Thread %lu: Narrowed %zu batches, kept %zu entries, reused %zu", threadId, threadBatches, threadKept,
+              threadReused);
+    return 0;
+}
+
+unsigned __stdcall snapshotCaptureThreadFunc(void* arg) {
+    SnapshotThreadData* data = static_cast<SnapshotThreadData*>(arg);
+    if (!data || !data->process || !data->process->memory || !data->snapshot ||
+        !data->settings || !data->queue) {
+        LOG_ERROR("Invalid thread data");
+        return 1;
+    }
+
+    DWORD threadId = GetCurrentThreadId();
+    MemorySource* memory = data->process->memory;
+    MemorySnapshot* snapshot = data->snapshot;
+    size_t threadBytes = 0;
+
+    try {
+        ScanBuffer buffer(GetScanChunkSize(data->settings), data->settings);
+        std::vector<BYTE> scratch;
+
+        ScanChunk chunk;
+        while (!g_cancelScan && data->queue->next(data->workerIndex, &chunk)) {
+            const SnapshotRegion& region = snapshot->regions[chunk.regionIndex];
+            SIZE_T actualRead = 0;
+            memory->read(chunk.address, buffer.data(), chunk.size, &actualRead);
+
+            // Pages past a short read stay missing and never match.
+            size_t pageCount = actualRead / SNAPSHOT_PAGE_SIZE;
+            size_t firstPage = region.firstPage + (chunk.address - region.base) / SNAPSHOT_PAGE_SIZE;
+            if (pageCount > 0 && !storeSnapshotPages(snapshot, firstPage, buffer.data(), pageCount, scratch)) {
+                g_cancelScan = true;
+                ShowStatusMessage("Failed to store snapshot");
+                break;
+            }
+
+            g_bytesScanned += actualRead;
+            threadBytes += actualRead;
+            if (--data->regionChunksLeft[chunk.regionIndex] == 0) {
+                g_regionsScanned++;
+                if (g_totalRegionsToScan > 0) {
+                    g_scanProgress = (double)g_regionsScanned / g_totalRegionsToScan;
+                }
+            }
+        }
+
+    } catch (const std::exception& e) {
+        LOG_ERROR("Thread %lu error: %s", threadId, e.what());
+    }
+
+    LOG_DEBUG("Thread %lu: Captured %zu bytes", threadId, threadBytes);
+    return 0;
+}
+
+unsigned __stdcall snapshotCompareThreadFunc(void* arg) {
+    SnapshotThreadData* data = static_cast<SnapshotThreadData*>(arg);
+    if (!data || !data->process || !data->process->memory || !data->snapshot ||
+        !data->settings || !data->queue || !data->shard) {
+        LOG_ERROR("Invalid thread data");
+        return 1;
+    }
+
+    DWORD threadId = GetCurrentThreadId();
+    MemorySource* memory = data->process->memory;
+    MemorySnapshot* snapshot = data->snapshot;
+    ScanShard* shard = data->shard;
+    size_t threadMatches = 0;
+
+    try {
+        const SIZE_T valueSize = GetValueTypeSize(currentValueType);
+        const SIZE_T chunkSize = GetScanChunkSize(data->settings);
+        const SIZE_T stride = GetScanStride(data->settings, currentValueType);
+        const double epsilon = GetScanEpsilon(data->settings);
+        const ScanKernelLevel kernelLevel = data->settings->useVectorizedOperations ?
+                                            GetScanKernelLevel() : SCAN_KERNEL_SCALAR;
+        // One extra page holds the overlap tail for values straddling chunks.
+        const size_t maxPages = chunkSize / SNAPSHOT_PAGE_SIZE + 1;
+
+        ScanBuffer current(maxPages * SNAPSHOT_PAGE_SIZE, data->settings);
+        ScanBuffer previous(maxPages * SNAPSHOT_PAGE_SIZE, data->settings);
+        std::unique_ptr<bool[]> valid(new bool[maxPages]);
+        std::unique_ptr<BYTE[]> written(new BYTE[maxPages]);
+        ScanBuffer offsetBuffer((chunkSize / stride + 1) * sizeof(uint32_t), data->settings);
+        uint32_t* offsets = reinterpret_cast<uint32_t*>(offsetBuffer.data());
+        std::vector<BYTE> scratch;
+
+        ScanChunk chunk;
+        while (!g_cancelScan && data->queue->next(data->workerIndex, &chunk)) {
+            const SnapshotRegion& region = snapshot->regions[chunk.regionIndex];
+            SIZE_T span = chunk.size + min_val(valueSize - 1, (SIZE_T)(chunk.regionEnd - chunk.address - chunk.size));
+            size_t pageCount = (span + SNAPSHOT_PAGE_SIZE - 1) / SNAPSHOT_PAGE_SIZE;
+            size_t firstPage = region.firstPage + (chunk.address - region.base) / SNAPSHOT_PAGE_SIZE;
+
+            loadSnapshotPages(snapshot, firstPage, pageCount, previous.data(), valid.get(), scratch);
+            SIZE_T actualRead = 0;
+            if (data->reuseUnwritten &&
+                queryWrittenPages(memory, *data->regions, chunk.address, pageCount, written.get())) {
+                // Unwritten pages still hold their snapshot bytes. Written
+                // ones are read in runs, and pages a run fails to reach
+                // stop counting as valid.
+                SIZE_T bytesRead = 0;
+                SIZE_T bytesReused = 0;
+                size_t pagesWritten = 0;
+                size_t pagesChecked = 0;
+                for (size_t page = 0; page < pageCount; ) {
+                    SIZE_T start = page * SNAPSHOT_PAGE_SIZE;
+                    if (!valid[page]) {
+                        page++;
+                        continue;
+                    }
+                    if (!written[page]) {
+                        SIZE_T pageEnd = min_val(start + SNAPSHOT_PAGE_SIZE, span);
+                        memcpy(&current[start], &previous[start], pageEnd - start);
+                        bytesReused += min_val(pageEnd, chunk.size) - min_val(start, chunk.size);
+                        pagesChecked++;
+                        page++;
+                        continue;
+                    }
+
+                    size_t end = page + 1;
+                    while (end < pageCount && valid[end] && written[end]) {
+                        end++;
+                    }
+                    SIZE_T runEnd = min_val(end * SNAPSHOT_PAGE_SIZE, span);
+                    SIZE_T runRead = 0;
+                    memory->read(chunk.address + start, &current[start], runEnd - start, &runRead);
+                    for (size_t p = page; p < end; p++) {
+                        valid[p] = valid[p] && start + runRead >= min_val((p + 1) * SNAPSHOT_PAGE_SIZE, span);
+                    }
+                    bytesRead += min_val(start + runRead, chunk.size) - min_val(start, chunk.size);
+                    pagesWritten += end - page;
+                    pagesChecked += end - page;
+                    page = end;
+                }
+                *data->writtenPages += pagesWritten;
+                *data->checkedPages += pagesChecked;
+                g_bytesScanned += bytesRead;
+                g_bytesSkipped += bytesReused;
+                actualRead = span;
+            } else {
+                memory->read(chunk.address, current.data(), span, &actualRead);
+                g_bytesScanned += min_val(actualRead, chunk.size);
+            }
+
+            // Compare each stretch of pages that is present in both the
+            // snapshot and the current read.
+            size_t runBegin = shard->offsets.size();
+            for (size_t page = 0; page * SNAPSHOT_PAGE_SIZE < chunk.size; ) {
+                SIZE_T start = page * SNAPSHOT_PAGE_SIZE;
+                if (!valid[page] || start >= actualRead) {
+                    page++;
+                    continue;
+                }
+                size_t end = page;
+                while (end < pageCount && valid[end]) {
+                    end++;
+                }
+                SIZE_T validEnd = min_val(min_val(end * SNAPSHOT_PAGE_SIZE, actualRead), span);
+                if (validEnd >= start + valueSize) {
+                    SIZE_T limit = min_val(validEnd - valueSize + 1, chunk.size) - start;
+                    size_t count = data->useRange
+                        ? FindRangeOffsets(&current[start], validEnd - start, limit, data->range, currentValueType,
+                                           stride, offsets, kernelLevel)
+                        : CompareValueBuffers(&current[start], &previous[start], limit, stride, currentValueType,
+                                              data->compare, data->value, epsilon, offsets);
+                    for (size_t h = 0; h < count; h++) {
+                        SIZE_T offset = start + offsets[h];
+                        shard->offsets.push_back((uint32_t)offset);
+                        shard->values.insert(shard->values.end(), &current[offset], &current[offset] + valueSize);
+                        shard->originalValues.insert(shard->originalValues.end(), &previous[offset],
+                                                     &previous[offset] + valueSize);
+                    }
+                }
+                page = end;
+            }
+
+            size_t runCount = shard->offsets.size() - runBegin;
+            if (runCount > 0) {
+                ScanShardRun run = { chunk.index, runBegin, runCount };
+                shard->runs.push_back(run);
+                threadMatches += runCount;
+                g_matchesFound += runCount;
+            }
+
+            if (--data->regionChunksLeft[chunk.regionIndex] == 0) {
+                g_regionsScanned++;
+                if (g_totalRegionsToScan > 0) {
+                    g_scanProgress = (double)g_regionsScanned / g_totalRegionsToScan;
+                }
+            }
+        }
+
+    } catch (const std::exception& e) {
+        LOG_ERROR("Thread %lu error: %s", threadId, e.what());
+    }
+
+    LOG_DEBUG("Thread %lu: Found %zu snapshot matches", threadId, threadMatches);
+    return 0;
+}
+
+bool MergeScanShards(std::vector<ScanShard>& shards, const std::vector<ScanChunk>& chunks, SIZE_T stride,
+                     ScanResults* results) {
+    // Each chunk produced at most one run, so laying the runs out by chunk
+    // index and prefix-summing their counts gives every run its final slot
+    // and keeps the merged results in address order.
+    const size_t chunkCount = chunks.size();
+    std::vector<const ScanShardRun*> runByChunk(chunkCount, nullptr);
+    std::vector<const ScanShard*> shardByChunk(chunkCount, nullptr);
+    for (size_t s = 0; s < shards.size(); s++) {
+        for (size_t r = 0; r < shards[s].runs.size(); r++) {
+            const ScanShardRun& run = shards[s].runs[r];
+            runByChunk[run.chunkIndex] = &run;
+            shardByChunk[run.chunkIndex] = &shards[s];
+        }
+    }
+
+    std::vector<size_t> offsets(chunkCount + 1, 0);
+    for (size_t c = 0; c < chunkCount; c++) {
+        offsets[c + 1] = offsets[c] + (runByChunk[c] ? runByChunk[c]->count : 0);
+    }
+    size_t total = offsets[chunkCount];
+
+    // One result region per scanned memory region, split further if hits
+    // would lie more than 4 GB past the region's base. Each region's hit
+    // count is known before it is filled, so it can pick its encoding.
+    typedef struct {
+        size_t firstChunk;
+        size_t lastChunk;
+        size_t count;
+    } RegionSpan;
+    std::vector<RegionSpan> spans;
+    for (size_t c = 0; c < chunkCount; c++) {
+        if (!runByChunk[c]) {
+            continue;
+        }
+        const ScanChunk& chunk = chunks[c];
+        if (spans.empty() || chunk.regionIndex != chunks[spans.back().firstChunk].regionIndex ||
+            (uint64_t)(chunk.address + chunk.size - chunks[spans.back().firstChunk].address) > RESULT_MAX_REGION_SPAN) {
+            RegionSpan span = { c, c, 0 };
+            spans.push_back(span);
+        }
+        spans.back().lastChunk = c;
+        spans.back().count += runByChunk[c]->count;
+    }
+
+    ScanResults merged;
+    initScanResults(&merged, results->valueType);
+    for (size_t r = 0; r < spans.size(); r++) {
+        const ScanChunk& first = chunks[spans[r].firstChunk];
+        const ScanChunk& last = chunks[spans[r].lastChunk];
+        if (!addScanResultRegion(&merged, first.address, last.address + last.size - first.address,
+                                 stride, spans[r].count)) {
+            LOG_ERROR("Failed to allocate %zu scan results", total);
+            freeScanResults(&merged);
+            return false;
+        }
+
+        size_t entry = 0;
+        for (size_t c = spans[r].firstChunk; c <= spans[r].lastChunk; c++) {
+            const ScanShardRun* run = runByChunk[c];
+            if (!run) {
+                continue;
+            }
+            const ScanShard* shard = shardByChunk[c];
+            storeScanResults(&merged, r, entry, &shard->offsets[run->begin],
+                             (uint32_t)(chunks[c].address - first.address),
+                             &shard->values[run->begin * merged.valueSize],
+                             shard->originalValues.empty() ? nullptr : &shard->originalValues[run->begin * merged.valueSize],
+                             run->count);
+            entry += run->count;
+        }
+        closeScanResultRegion(&merged, r);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(scanResultsMutex);
+        std::swap(*results, merged);
+    }
+    freeScanResults(&merged);
+    g_resultsUpdated = true;
+
+    size_t bitmapRegions = 0;
+    for (size_t r = 0; r < results->regions.size(); r++) {
+        if (results->regions[r].encoding == RESULT_REGION_BITMAP) {
+            bitmapRegions++;
+        }
+    }
+    LOG_DEBUG("Merged %zu results from %zu shards into %zu regions (%zu bitmap)",
+              total, shards.size(), results->regions.size(), bitmapRegions);
+    return true;
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "platform.h"
+#include <stdint.h>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <memory>
+
+#include "settings.h"
+#include "advanced_scanning.h"
+#include "memory_source.h"
+#include "work_queue.h"
+#include "scan_results.h"
+#include "snapshot.h"
+#include "scan_threads.h"
+
+// Scan, narrow and write engine shared by the GUI (main.cpp) and the
+// headless CLI (cli_main.cpp). Nothing in here depends on ImGui or D3D.
+
+typedef struct {
+    DWORD processId;
+    HANDLE processHandle;
+    char processName[MAX_PATH];
+    Settings* settings;
+    MemorySource* memory;
+} ProcessInfo;
+
+// How a scan tests each candidate. EXACT, GREATER, LESS and BETWEEN test
+// the current value against the given value (BETWEEN against an inclusive
+// pair); the rest compare the current value with the previous one (the
+// snapshot after an unknown initial value scan, otherwise the last scan).
+typedef enum {
+    SCAN_COMPARE_EXACT,
+    SCAN_COMPARE_CHANGED,
+    SCAN_COMPARE_UNCHANGED,
+    SCAN_COMPARE_INCREASED,
+    SCAN_COMPARE_DECREASED,
+    SCAN_COMPARE_INCREASED_BY,  // Grew by exactly the given value
+    SCAN_COMPARE_DECREASED_BY,  // Shrank by exactly the given value
+    SCAN_COMPARE_GREATER,
+    SCAN_COMPARE_LESS,
+    SCAN_COMPARE_BETWEEN
+} ScanCompareType;
+
+// A fixed-size slice of a region handed to one scan worker. Reads extend
+// up to typeSize-1 bytes past the chunk (clamped to the region) so values
+// straddling a chunk boundary are still found, but only hits starting
+// inside [address, address + size) are reported.
+typedef struct {
+    uintptr_t address;      // First byte owned by this chunk
+    SIZE_T size;            // Number of bytes owned by this chunk
+    uintptr_t regionEnd;    // End of the containing region
+    size_t regionIndex;     // Index into the scan's region list
+    size_t index;           // Position in address order
+} ScanChunk;
+
+// Pages a scan leaves unread, decided from the target's page residency
+// (MemorySource::queryResidency) before each chunk is read.
+typedef struct {
+    bool skipZeroPages;     // Untouched private pages and the shared zero page
+    bool skipSwappedPages;  // Pages paged out of the target
+    const std::vector<MemoryRegion>* regions;   // Scan regions, indexed by ScanChunk::regionIndex
+} ResidencyPolicy;
+
+// Hits from one chunk, stored contiguously in a worker's shard.
+typedef struct {
+    size_t chunkIndex;
+    size_t begin;           // First hit in the shard
+    size_t count;
+} ScanShardRun;
+
+// Results collected by one scan worker without locking. Shards are merged
+// into the shared ScanResults in chunk order once all workers are done.
+typedef struct {
+    std::vector<uint32_t> offsets;  // Hit offsets from their chunk's address
+    std::vector<BYTE> values;       // Hit values, valueSize bytes each
+    std::vector<BYTE> originalValues;   // Narrowing only: carried originals
+    std::vector<ScanShardRun> runs;
+} ScanShard;
+
+typedef struct {
+    ProcessInfo* process;
+    ScanValue valueToFind;
+    bool useRange;          // Test range instead of valueToFind
+    ScanRange range;
+    ResidencyPolicy residency;
+    ScanShard* shard;
+    Settings* settings;
+    WorkStealingQueue<ScanChunk>* queue;
+    int workerIndex;
+    std::atomic<size_t>* regionChunksLeft;  // Per-region countdown for progress
+} ScanThreadData;
+
+// A run of consecutive results from one result region, narrowed by one
+// worker with a single scatter read.
+typedef struct {
+    size_t region;          // Index into the source results' regions
+    size_t entry;           // First result within the region
+    size_t count;
+    size_t index;           // Position in result order
+} NarrowBatch;
+
+typedef struct {
+    ProcessInfo* process;
+    const ScanResults* results;
+    ScanValue newValue;
+    ScanCompareType compare;
+    bool useRange;
+    ScanRange range;
+    ScanShard* shard;
+    Settings* settings;
+    WorkStealingQueue<NarrowBatch>* queue;
+    int workerIndex;
+    bool reuseUnwritten;    // Keep stored values of results on unwritten pages
+    const std::vector<MemoryRegion>* regions;
+    std::atomic<size_t>* writtenHits;
+} NarrowThreadData;
+
+// Workers for the unknown initial value scan: capture fills the snapshot,
+// compare fills shard with hits against it.
+typedef struct {
+    ProcessInfo* process;
+    MemorySnapshot* snapshot;
+    ScanShard* shard;
+    Settings* settings;
+    WorkStealingQueue<ScanChunk>* queue;
+    int workerIndex;
+    std::atomic<size_t>* regionChunksLeft;
+    ScanCompareType compare;
+    ScanValue value;
+    bool useRange;
+    ScanRange range;
+    bool reuseUnwritten;    // Take unwritten pages from the snapshot instead of reading them
+    const std::vector<MemoryRegion>* regions;
+    std::atomic<size_t>* writtenPages;
+    std::atomic<size_t>* checkedPages;
+} SnapshotThreadData;
+
+const SIZE_T SCAN_CHUNK_SIZE = 1024 * 1024;
+const SIZE_T MIN_SCAN_CHUNK_SIZE = 64 * 1024;
+const size_t NARROW_BATCH_ENTRIES = 8192;
+const SIZE_T NARROW_MERGE_GAP = 256;    // Hits closer than this share one read
+
+extern ScanResults g_scanResults;
+extern MemorySnapshot g_memorySnapshot;
+extern ValueType currentValueType;
+extern std::mutex scanResultsMutex;
+
+extern std::atomic<bool> g_cancelScan;
+extern std::atomic<bool> g_scanInProgress;
+extern std::atomic<bool> g_resultsUpdated;
+extern std::atomic<size_t> g_regionsScanned;
+extern std::atomic<size_t> g_matchesFound;
+extern std::atomic<size_t> g_bytesScanned;
+extern std::atomic<size_t> g_regionsSkipped;
+extern std::atomic<size_t> g_bytesSkipped;     // Left unread by the residency policy or reused as unwritten
+extern std::atomic<size_t> g_totalMemoryToScan;
+extern size_t g_totalRegionsToScan;
+extern double g_scanProgress;
+
+void validateScanResults();
+
+int GetScanThreadCount(const Settings* settings);
+SIZE_T GetScanChunkSize(const Settings* settings);
+SIZE_T GetScanStride(const Settings* settings, ValueType type);
+
+// skipZeroRegions and skipSwappedPages for a scan over regions. Zero pages
+// are read after all when searchingForZero, since they would match.
+ResidencyPolicy GetResidencyPolicy(const Settings* settings, const std::vector<MemoryRegion>* regions,
+                                   bool searchingForZero);
+
+// Splits [base, base + size) into chunks of at most chunkSize bytes and
+// returns how many were added.
+size_t AddRegionChunks(uintptr_t base, SIZE_T size, size_t regionIndex, SIZE_T chunkSize,
+                       std::vector<ScanChunk>& chunks);
+
+// Runs func once per entry of threadData, each on a scan thread placed as
+// PlanScanThreads lays them out, and returns when all of them are done. The
+// caller only waits, so its own affinity and priority stay as they were.
+template<typename T>
+void RunScanWorkers(unsigned (__stdcall *func)(void*), std::vector<T>& threadData, const Settings* settings) {
+    std::vector<ScanThreadPlacement> placements = PlanScanThreads(settings, threadData.size());
+    std::unique_ptr<ScanThread[]> workers(new ScanThread[threadData.size()]);
+    for (size_t i = 0; i < threadData.size(); i++) {
+        workers[i].start(func, &threadData[i], placements[i], settings);
+    }
+    for (size_t i = 0; i < threadData.size(); i++) {
+        workers[i].join();
+    }
+}
+
+int GetValueTypeSize(ValueType type);
+ScanValue MakeScanValue(int64_t value);
+double GetScanEpsilon(const Settings* settings);
+
+// Parses text as a value of type: integers in decimal or 0x hex, taking
+// either the signed or the unsigned range of the type's width; floats and
+// doubles as decimals; auto as an int that may carry a fraction. With end
+// the first unparsed character is returned there, otherwise the whole text
+// must be the value.
+bool parseScanValue(const char* text, ValueType type, ScanValue* value, const char** end = nullptr);
+
+// Writes value as the type's in-memory bytes and returns their count
+// (auto writes an int).
+size_t EncodeScanValue(const ScanValue& value, ValueType type, BYTE* out);
+
+// Formats the value at p; missing bytes past available read as zero.
+void FormatScanValue(const BYTE* p, size_t available, ValueType type, char* text, size_t size);
+
+// high is the upper bound of BETWEEN compares and unused otherwise.
+bool CompareScanValue(const BYTE* current, const BYTE* previous, ValueType type, ScanCompareType compare,
+                      const ScanValue& value, double epsilon, const ScanValue& high = ScanValue());
+const char* GetScanCompareName(ScanCompareType compare);
+
+// Compares that need no previous value (exact, greater/less-than, between).
+bool IsValueCompare(ScanCompareType compare);
+
+// The inclusive range the range kernels test for compare: between,
+// greater/less-than, and exact float/double matches when fuzzy scanning
+// is on (within fuzzyThreshold of the value, relative, and never tighter
+// than floatEpsilon). Returns false for compares tested another way.
+bool GetScanRange(const Settings* settings, ValueType type, ScanCompareType compare, const ScanValue& value,
+                  const ScanValue& high, ScanRange* range);
+bool IsLikelyValidDataRegion(const MemoryRegion& region, bool isSearchingForZero);
+bool IsWritableProtection(DWORD protect);
+// These check every region under [address, address + size), not just the first.
+bool IsReadableMemory(MemorySource* source, uintptr_t address, SIZE_T size);
+bool SafeReadMemory(MemorySource* source, uintptr_t address, LPVOID buffer, SIZE_T size, SIZE_T* bytesRead);
+bool isValidMemoryRegion(MemorySource* source, uintptr_t address, SIZE_T size);
+
+// high is the upper bound of BETWEEN compares and unused otherwise.
+void scanMemory(ProcessInfo* process, const ScanValue& valueToFind, ScanCompareType compare = SCAN_COMPARE_EXACT,
+                const ScanValue& high = ScanValue());
+void narrowResults(ProcessInfo* process, ScanResults* results, const ScanValue& newValue,
+                   ScanCompareType compare = SCAN_COMPARE_EXACT, const ScanValue& high = ScanValue());
+
+// Unknown initial value: snapshot every writable region, then let the next
+// scan compare against the snapshot. nextScan narrows g_scanResults, or
+// builds them from the snapshot when one is pending.
+void scanUnknownInitialValue(ProcessInfo* process);
+void nextScan(ProcessInfo* process, ScanCompareType compare, const ScanValue& value,
+              const ScanValue& high = ScanValue());
+void updateMemoryValue(ProcessInfo* process, uintptr_t address, const ScanValue& newValue);
+
+bool MergeScanShards(std::vector<ScanShard>& shards, const std::vector<ScanChunk>& chunks, SIZE_T stride,
+                     ScanResults* results);
+unsigned __stdcall scanMemoryThreadFunc(void* arg);
+unsigned __stdcall narrowResultsThreadFunc(void* arg);
+unsigned __stdcall snapshotCaptureThreadFunc(void* arg);
+unsigned __stdcall snapshotCompareThreadFunc(void* arg);
+
+// Status reporting hooks implemented by the front-end (GUI status bar or
+// CLI stderr).
+void ShowStatusMessage(const char* message);
+void ShowFormattedStatusMessage(const char* format, ...);
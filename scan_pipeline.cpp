@@ -0,0 +1,182 @@
+#include "scan_pipeline.h"
+#include "logging.h"
+
+#include <string.h>
+#include <algorithm>
+
+static bool SkipPage(BYTE flags, const ResidencyPolicy& residency, bool privateRegion) {
+    if (flags & PAGE_SHARED_ZERO) {
+        return residency.skipZeroPages;
+    }
+    if (flags & PAGE_RESIDENT) {
+        return false;
+    }
+    if (flags & PAGE_SWAPPED) {
+        return residency.skipSwappedPages;
+    }
+    return residency.skipZeroPages && privateRegion;
+}
+
+static bool PageReadsAsZero(BYTE flags, bool privateRegion) {
+    return (flags & PAGE_SHARED_ZERO) || (!(flags & (PAGE_RESIDENT | PAGE_SWAPPED)) && privateRegion);
+}
+
+// Reads [begin, end) of the chunk's span and records it as a run. Returns
+// false when the run holds no hit starts (it lies in the overlap tail).
+static bool ReadChunkRun(MemorySource* memory, SIZE_T begin, SIZE_T end, SIZE_T overlap, ChunkRead* read) {
+    if (begin >= read->chunk.size) {
+        return false;
+    }
+    BYTE* buffer = read->buffer.data();
+    SIZE_T bytesRead = 0;
+    memory->read(read->chunk.address + begin, buffer + begin, end - begin, &bytesRead);
+
+    ChunkRun run = { begin, std::min(end, read->chunk.size), begin + bytesRead };
+    if (bytesRead < end - begin) {
+        memset(buffer + run.valid, 0, std::min((SIZE_T)(overlap + 1), read->buffer.size() - run.valid));
+    }
+    read->runs.push_back(run);
+    read->bytesScanned += std::min(run.valid, run.end) - run.begin;
+    return true;
+}
+
+void ReadScanChunk(MemorySource* memory, const ScanChunk& chunk, SIZE_T overlap, const ResidencyPolicy& residency,
+                   ChunkRead* read) {
+    const SIZE_T span = chunk.size + std::min(overlap, (SIZE_T)(chunk.regionEnd - chunk.address - chunk.size));
+    read->chunk = chunk;
+    read->runs.clear();
+    read->bytesScanned = 0;
+    read->bytesSkipped = 0;
+
+    // The query covers the overlap tail too, so reading it never pages in
+    // a skipped page of the next chunk.
+    const size_t pageCount = (span + RESIDENCY_PAGE_SIZE - 1) / RESIDENCY_PAGE_SIZE;
+    bool paged = (residency.skipZeroPages || residency.skipSwappedPages) && chunk.address % RESIDENCY_PAGE_SIZE == 0;
+    if (paged) {
+        read->pageFlags.resize(pageCount);
+        paged = memory->queryResidency(chunk.address, pageCount, read->pageFlags.data());
+    }
+    if (!paged) {
+        ReadChunkRun(memory, 0, span, overlap, read);
+        return;
+    }
+
+    const BYTE* flags = read->pageFlags.data();
+    const bool privateRegion = residency.regions && chunk.regionIndex < residency.regions->size() &&
+                               (*residency.regions)[chunk.regionIndex].type == MEM_PRIVATE;
+    size_t page = 0;
+    while (page < pageCount) {
+        SIZE_T pageStart = page * RESIDENCY_PAGE_SIZE;
+        if (SkipPage(flags[page], residency, privateRegion)) {
+            if (pageStart < chunk.size) {
+                read->bytesSkipped += std::min(pageStart + RESIDENCY_PAGE_SIZE, chunk.size) - pageStart;
+            }
+            page++;
+            continue;
+        }
+
+        size_t last = page;
+        while (last < pageCount && !SkipPage(flags[last], residency, privateRegion)) {
+            last++;
+        }
+        SIZE_T end = std::min(last * RESIDENCY_PAGE_SIZE, span);
+        if (ReadChunkRun(memory, pageStart, end, overlap, read) && last < pageCount &&
+            read->runs.back().valid == end && PageReadsAsZero(flags[last], privateRegion)) {
+            // Values running into an unread zero page still see its zeros.
+            SIZE_T zeroEnd = std::min(end + overlap, span);
+            memset(read->buffer.data() + end, 0, zeroEnd - end);
+            read->runs.back().valid = zeroEnd;
+        }
+        page = last;
+    }
+}
+
+size_t GetScanPipelineDepth(const Settings* settings) {
+    // One buffer cannot be filled and compared at once, and on a single
+    // core the reader would only take turns with the compare.
+    if (!settings || settings->scanPipelineDepth < 2 || std::thread::hardware_concurrency() < 2) {
+        return 0;
+    }
+    return (size_t)settings->scanPipelineDepth;
+}
+
+ChunkReadRing::ChunkReadRing(MemorySource* memory, WorkStealingQueue<ScanChunk>* queue, int workerIndex,
+                             size_t depth, SIZE_T chunkSize, SIZE_T overlap, const ResidencyPolicy& residency,
+                             const Settings* settings, const std::atomic<bool>* cancel)
+    : memory(memory), queue(queue), workerIndex(workerIndex), overlap(overlap), residency(residency), cancel(cancel),
+      slots(depth < 1 ? 1 : depth), head(0), filled(0), done(false), stopping(false) {
+    for (size_t i = 0; i < slots.size(); i++) {
+        slots[i].buffer.allocate(chunkSize + overlap, settings);
+    }
+    reader.start(readerEntry, this, GetReaderPlacement(GetScanThreadPlacement()), settings);
+}
+
+ChunkReadRing::~ChunkReadRing() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    slotFreed.notify_all();
+    reader.join();
+}
+
+unsigned __stdcall ChunkReadRing::readerEntry(void* self) {
+    static_cast<ChunkReadRing*>(self)->readerLoop();
+    return 0;
+}
+
+void ChunkReadRing::readerLoop() {
+    size_t tail = 0;
+    try {
+        ScanChunk chunk;
+        while (!*cancel && queue->next(workerIndex, &chunk)) {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                slotFreed.wait(guard, [this] { return stopping || filled < slots.size(); });
+                if (stopping) {
+                    break;
+                }
+            }
+
+            // The slot at tail is not visible to the compare stage until
+            // filled is bumped, so it is read without the lock.
+            ReadScanChunk(memory, chunk, overlap, residency, &slots[tail]);
+            tail = (tail + 1) % slots.size();
+
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                filled++;
+            }
+            slotFilled.notify_one();
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Scan reader %d error: %s", workerIndex, e.what());
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        done = true;
+    }
+    slotFilled.notify_one();
+}
+
+ChunkRead* ChunkReadRing::acquire() {
+    std::unique_lock<std::mutex> guard(lock);
+    slotFilled.wait(guard, [this] { return done || filled > 0; });
+    if (filled == 0 || *cancel) {
+        return nullptr;
+    }
+    return &slots[head];
+}
+
+void ChunkReadRing::release(ChunkRead* read) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (filled == 0 || read != &slots[head]) {
+            return;
+        }
+        head = (head + 1) % slots.size();
+        filled--;
+    }
+    slotFreed.notify_one();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "platform.h"
+#include <stdint.h>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+#include "memory_source.h"
+#include "work_queue.h"
+#include "scan_engine.h"
+#include "scan_buffer_pool.h"
+
+// A stretch of a chunk that was read. Hits may start in [begin, end);
+// bytes up to valid hold data, which runs past end by up to the overlap.
+typedef struct {
+    SIZE_T begin;
+    SIZE_T end;
+    SIZE_T valid;
+} ChunkRun;
+
+// One chunk as read by ReadScanChunk: a single run, or one per stretch of
+// pages the residency policy kept.
+struct ChunkRead {
+    ScanChunk chunk;
+    ScanBuffer buffer;          // chunkSize + overlap bytes
+    std::vector<ChunkRun> runs;
+    SIZE_T bytesScanned;        // Owned bytes read
+    SIZE_T bytesSkipped;        // Owned bytes left unread
+    std::vector<BYTE> pageFlags;
+};
+
+// Read-ahead ring for one scan worker. A reader thread takes the worker's
+// chunks from the queue (stealing like the worker would) and fills up to
+// depth buffers ahead, while the worker compares the oldest filled one, so
+// the copy out of the target and the compare kernels run at the same time.
+// Reads come back in the order they were made, each read exactly as an
+// inline ReadScanChunk would.
+class ChunkReadRing {
+private:
+    MemorySource* memory;
+    WorkStealingQueue<ScanChunk>* queue;
+    int workerIndex;
+    SIZE_T overlap;
+    ResidencyPolicy residency;
+    const std::atomic<bool>* cancel;
+
+    std::vector<ChunkRead> slots;
+    size_t head;            // Oldest filled slot
+    size_t filled;          // Filled slots, including one being compared
+    bool done;              // Reader has no more chunks
+    bool stopping;          // Owner is going away
+    std::mutex lock;
+    std::condition_variable slotFilled;
+    std::condition_variable slotFreed;
+    ScanThread reader;      // On the worker's sibling hyperthread when pinned
+
+    static unsigned __stdcall readerEntry(void* self);
+    void readerLoop();
+
+public:
+    ChunkReadRing(MemorySource* memory, WorkStealingQueue<ScanChunk>* queue, int workerIndex, size_t depth,
+                  SIZE_T chunkSize, SIZE_T overlap, const ResidencyPolicy& residency, const Settings* settings,
+                  const std::atomic<bool>* cancel);
+    ~ChunkReadRing();
+
+    // Blocks for the next filled read; nullptr once the queue is drained
+    // or the scan is cancelled. The read stays valid until release.
+    ChunkRead* acquire();
+    void release(ChunkRead* read);
+};
+
+// Reads chunk plus up to overlap bytes past it (clamped to the region) into
+// read->buffer, which must hold chunk.size + overlap bytes. Pages the
+// residency policy skips are left unread and split the chunk into runs;
+// a run ending at a skipped zero page gets zeros for its overlap, one
+// ending at a swapped page gets no overlap. Short reads are zero-padded
+// for overlap + 1 bytes so values cut off by them never carry stale bytes.
+void ReadScanChunk(MemorySource* memory, const ScanChunk& chunk, SIZE_T overlap, const ResidencyPolicy& residency,
+                   ChunkRead* read);
+
+// Buffers in each scan worker's read-ahead ring (scanPipelineDepth);
+// 0 when the worker should read inline, including on single-core machines.
+size_t GetScanPipelineDepth(const Settings* settings);
@@ -0,0 +1,325 @@
+#include "platform.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include "scan_results.h"
+#include "scan_engine.h"
+#include "logging.h"
+
+static bool allocateResultBlock(ScanResults* results) {
+    ResultBlock block;
+    block.values = (BYTE*)malloc(RESULT_BLOCK_ENTRIES * results->valueSize);
+    block.originalValues = (BYTE*)malloc(RESULT_BLOCK_ENTRIES * results->valueSize);
+    if (!block.values || !block.originalValues) {
+        free(block.values);
+        free(block.originalValues);
+        LOG_ERROR("Failed to allocate result block %zu", results->blocks.size());
+        return false;
+    }
+    results->blocks.push_back(block);
+    return true;
+}
+
+static void freeResultBlock(ResultBlock* block) {
+    free(block->values);
+    free(block->originalValues);
+}
+
+static void freeResultRegion(ResultRegion* region) {
+    free(region->offsets);
+    free(region->bitmap);
+    free(region->rank);
+}
+
+static size_t bitmapWords(const ResultRegion& region) {
+    return (region.slots + 63) / 64;
+}
+
+static size_t rankEntries(const ResultRegion& region) {
+    return (region.slots + RESULT_RANK_SLOTS - 1) / RESULT_RANK_SLOTS;
+}
+
+// A bitmap costs one bit per slot plus a 32-bit rank entry per
+// RESULT_RANK_SLOTS slots; an offset list costs 32 bits per result.
+static bool useBitmapEncoding(size_t slots, size_t count) {
+    uint64_t bitmapBits = (uint64_t)slots + (uint64_t)(slots / RESULT_RANK_SLOTS + 1) * 32;
+    return bitmapBits < (uint64_t)count * 32;
+}
+
+// Slot of the k'th set bit: binary search the rank directory, then count
+// through at most one superblock of words.
+static size_t selectBitmapSlot(const ResultRegion& region, size_t k) {
+    const size_t wordsPerRank = RESULT_RANK_SLOTS / 64;
+    size_t ranks = rankEntries(region);
+    size_t superblock = (size_t)(std::upper_bound(region.rank, region.rank + ranks, (uint32_t)k) - region.rank) - 1;
+    size_t remaining = k - region.rank[superblock];
+    size_t word = superblock * wordsPerRank;
+    for (;;) {
+        size_t bits = (size_t)__builtin_popcountll(region.bitmap[word]);
+        if (remaining < bits) {
+            break;
+        }
+        remaining -= bits;
+        word++;
+    }
+
+    uint64_t bits = region.bitmap[word];
+    while (remaining-- > 0) {
+        bits &= bits - 1;
+    }
+    return word * 64 + __builtin_ctzll(bits);
+}
+
+void initScanResults(ScanResults* results, ValueType type) {
+    results->valueType = type;
+    results->valueSize = GetValueTypeSize(type);
+    results->count = 0;
+    results->regions.clear();
+    results->blocks.clear();
+}
+
+void freeScanResults(ScanResults* results) {
+    for (size_t i = 0; i < results->regions.size(); i++) {
+        freeResultRegion(&results->regions[i]);
+    }
+    for (size_t i = 0; i < results->blocks.size(); i++) {
+        freeResultBlock(&results->blocks[i]);
+    }
+    std::vector<ResultBlock>().swap(results->blocks);
+    std::vector<ResultRegion>().swap(results->regions);
+    results->count = 0;
+}
+
+void optimizeScanResults(ScanResults* results) {
+    std::lock_guard<std::mutex> lock(scanResultsMutex);
+
+    // Release whole blocks past the last result.
+    size_t neededBlocks = (results->count + RESULT_BLOCK_ENTRIES - 1) >> RESULT_BLOCK_SHIFT;
+    if (results->blocks.size() > neededBlocks) {
+        for (size_t i = neededBlocks; i < results->blocks.size(); i++) {
+            freeResultBlock(&results->blocks[i]);
+        }
+        LOG_DEBUG("Optimized results: released %zu blocks", results->blocks.size() - neededBlocks);
+        results->blocks.resize(neededBlocks);
+    }
+    if (results->regions.capacity() > results->regions.size() * 2) {
+        std::vector<ResultRegion>(results->regions).swap(results->regions);
+    }
+}
+
+size_t getScanResultsMemoryUsage(const ScanResults* results) {
+    size_t bytes = results->blocks.size() * RESULT_BLOCK_ENTRIES * 2 * results->valueSize +
+                   results->regions.capacity() * sizeof(ResultRegion);
+    for (size_t i = 0; i < results->regions.size(); i++) {
+        const ResultRegion& region = results->regions[i];
+        if (region.encoding == RESULT_REGION_BITMAP) {
+            bytes += bitmapWords(region) * sizeof(uint64_t) + rankEntries(region) * sizeof(uint32_t);
+        } else {
+            bytes += region.count * sizeof(uint32_t);
+        }
+    }
+    return bytes;
+}
+
+bool addScanResultRegion(ScanResults* results, uintptr_t base, SIZE_T span, SIZE_T stride, size_t count) {
+    ResultRegion region;
+    memset(&region, 0, sizeof(region));
+    region.base = base;
+    region.firstEntry = results->count;
+    region.count = count;
+    region.stride = (uint32_t)(stride ? stride : 1);
+    region.slots = (span + region.stride - 1) / region.stride;
+
+    if (count > 0 && useBitmapEncoding(region.slots, count)) {
+        region.encoding = RESULT_REGION_BITMAP;
+        region.bitmap = (uint64_t*)calloc(bitmapWords(region), sizeof(uint64_t));
+        region.rank = (uint32_t*)malloc(rankEntries(region) * sizeof(uint32_t));
+        if (!region.bitmap || !region.rank) {
+            freeResultRegion(&region);
+            LOG_ERROR("Failed to allocate result bitmap for %zu slots", region.slots);
+            return false;
+        }
+    } else {
+        region.encoding = RESULT_REGION_OFFSETS;
+        if (count > 0) {
+            region.offsets = (uint32_t*)malloc(count * sizeof(uint32_t));
+            if (!region.offsets) {
+                LOG_ERROR("Failed to allocate %zu result offsets", count);
+                return false;
+            }
+        }
+    }
+
+    while (results->blocks.size() * RESULT_BLOCK_ENTRIES < results->count + count) {
+        if (!allocateResultBlock(results)) {
+            freeResultRegion(&region);
+            return false;
+        }
+    }
+
+    results->regions.push_back(region);
+    results->count += count;
+    return true;
+}
+
+void storeScanResults(ScanResults* results, size_t region, size_t entry, const uint32_t* offsets,
+                      uint32_t offsetBias, const BYTE* values, const BYTE* originalValues, size_t count) {
+    ResultRegion& target = results->regions[region];
+    if (target.encoding == RESULT_REGION_BITMAP) {
+        for (size_t i = 0; i < count; i++) {
+            size_t slot = (offsets[i] + offsetBias) / target.stride;
+            target.bitmap[slot >> 6] |= 1ULL << (slot & 63);
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            target.offsets[entry + i] = offsets[i] + offsetBias;
+        }
+    }
+
+    const size_t valueSize = results->valueSize;
+    if (!originalValues) {
+        originalValues = values;
+    }
+    size_t index = target.firstEntry + entry;
+    while (count > 0) {
+        ResultBlock& block = results->blocks[index >> RESULT_BLOCK_SHIFT];
+        size_t slot = index & (RESULT_BLOCK_ENTRIES - 1);
+        size_t n = std::min(count, RESULT_BLOCK_ENTRIES - slot);
+
+        memcpy(&block.values[slot * valueSize], values, n * valueSize);
+        memcpy(&block.originalValues[slot * valueSize], originalValues, n * valueSize);
+
+        index += n;
+        values += n * valueSize;
+        originalValues += n * valueSize;
+        count -= n;
+    }
+}
+
+void closeScanResultRegion(ScanResults* results, size_t region) {
+    ResultRegion& target = results->regions[region];
+    if (target.encoding != RESULT_REGION_BITMAP) {
+        return;
+    }
+
+    const size_t wordsPerRank = RESULT_RANK_SLOTS / 64;
+    size_t words = bitmapWords(target);
+    uint32_t running = 0;
+    for (size_t r = 0; r < rankEntries(target); r++) {
+        target.rank[r] = running;
+        size_t end = std::min(words, (r + 1) * wordsPerRank);
+        for (size_t w = r * wordsPerRank; w < end; w++) {
+            running += (uint32_t)__builtin_popcountll(target.bitmap[w]);
+        }
+    }
+}
+
+size_t getScanResultOffsets(const ScanResults* results, size_t region, size_t entry,
+                            uint32_t* offsets, size_t maxCount) {
+    const ResultRegion& source = results->regions[region];
+    if (entry >= source.count) {
+        return 0;
+    }
+    size_t count = std::min(maxCount, source.count - entry);
+
+    if (source.encoding != RESULT_REGION_BITMAP) {
+        memcpy(offsets, &source.offsets[entry], count * sizeof(uint32_t));
+        return count;
+    }
+
+    size_t slot = selectBitmapSlot(source, entry);
+    size_t word = slot >> 6;
+    uint64_t bits = source.bitmap[word] & (~0ULL << (slot & 63));
+    for (size_t i = 0; i < count; i++) {
+        while (bits == 0) {
+            bits = source.bitmap[++word];
+        }
+        offsets[i] = (uint32_t)((word * 64 + __builtin_ctzll(bits)) * source.stride);
+        bits &= bits - 1;
+    }
+    return count;
+}
+
+size_t findScanResultRegion(const ScanResults* results, size_t index) {
+    std::vector<ResultRegion>::const_iterator it = std::upper_bound(
+        results->regions.begin(), results->regions.end(), index,
+        [](size_t value, const ResultRegion& region) { return value < region.firstEntry; });
+    return (size_t)(it - results->regions.begin()) - 1;
+}
+
+uintptr_t getScanResultAddress(const ScanResults* results, size_t index) {
+    const ResultRegion& region = results->regions[findScanResultRegion(results, index)];
+    size_t entry = index - region.firstEntry;
+    if (region.encoding == RESULT_REGION_BITMAP) {
+        return region.base + selectBitmapSlot(region, entry) * region.stride;
+    }
+    return region.base + region.offsets[entry];
+}
+
+const BYTE* getScanResultValue(const ScanResults* results, size_t index) {
+    return &results->blocks[index >> RESULT_BLOCK_SHIFT].values[(index & (RESULT_BLOCK_ENTRIES - 1)) * results->valueSize];
+}
+
+const BYTE* getScanResultOriginal(const ScanResults* results, size_t index) {
+    return &results->blocks[index >> RESULT_BLOCK_SHIFT].originalValues[(index & (RESULT_BLOCK_ENTRIES - 1)) * results->valueSize];
+}
+
+int getScanResultValueInt(const ScanResults* results, size_t index) {
+    return DecodeScanValue(getScanResultValue(results, index), results->valueSize, results->valueType);
+}
+
+int getScanResultOriginalInt(const ScanResults* results, size_t index) {
+    return DecodeScanValue(getScanResultOriginal(results, index), results->valueSize, results->valueType);
+}
+
+void setScanResultValue(ScanResults* results, size_t index, const void* value) {
+    memcpy(&results->blocks[index >> RESULT_BLOCK_SHIFT].values[(index & (RESULT_BLOCK_ENTRIES - 1)) * results->valueSize],
+           value, results->valueSize);
+}
+
+// Casting a NaN, infinite or out-of-range floating point value to int is
+// undefined, and memory can hold any bit pattern.
+static int ClampToInt(double value) {
+    if (!std::isfinite(value))
+        return 0;
+    if (value <= (double)INT_MIN)
+        return INT_MIN;
+    if (value >= (double)INT_MAX)
+        return INT_MAX;
+    return (int)value;
+}
+
+int DecodeScanValue(const BYTE* p, size_t available, ValueType type) {
+    switch (type) {
+        case VALUE_TYPE_FLOAT: {
+            float value;
+            memcpy(&value, p, sizeof(value));
+            return ClampToInt(value);
+        }
+        case VALUE_TYPE_DOUBLE: {
+            double value;
+            memcpy(&value, p, sizeof(value));
+            return ClampToInt(value);
+        }
+        case VALUE_TYPE_SHORT: {
+            short value;
+            memcpy(&value, p, sizeof(value));
+            return value;
+        }
+        case VALUE_TYPE_UINT16: {
+            uint16_t value;
+            memcpy(&value, p, sizeof(value));
+            return value;
+        }
+        case VALUE_TYPE_BYTE:
+            return p[0];
+        default: {
+            int value = 0;
+            memcpy(&value, p, std::min(sizeof(value), available));
+            return value;
+        }
+    }
+}
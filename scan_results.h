@@ -0,0 +1,84 @@
+#pragma once
+
+#include "platform.h"
+#include <stdint.h>
+#include <vector>
+
+#include "advanced_scanning.h"
+
+// Scan result store. Results are grouped into ResultRegions, each owning a
+// contiguous range of result indices. A region records its hits either as
+// a list of 32-bit offsets from its base or, when hits are dense, as one
+// bit per stride-sized slot with a rank directory for index lookups. The
+// current/original values live in fixed blocks of RESULT_BLOCK_ENTRIES
+// results at the scanned type's size and are never reallocated or moved.
+
+const size_t RESULT_BLOCK_SHIFT = 16;
+const size_t RESULT_BLOCK_ENTRIES = (size_t)1 << RESULT_BLOCK_SHIFT;
+const uint64_t RESULT_MAX_REGION_SPAN = 0xFFFFFFFFULL;
+const size_t RESULT_RANK_SLOTS = 512;   // Bitmap slots per rank entry
+
+typedef enum {
+    RESULT_REGION_OFFSETS,
+    RESULT_REGION_BITMAP
+} ResultRegionEncoding;
+
+typedef struct {
+    uintptr_t base;         // Address that offsets are relative to
+    size_t firstEntry;      // Index of the region's first result
+    size_t count;           // Number of results in the region
+    ResultRegionEncoding encoding;
+    uint32_t stride;        // Bytes per bitmap slot
+    size_t slots;           // Bitmap length in slots
+    uint32_t* offsets;      // Offset of each result (RESULT_REGION_OFFSETS)
+    uint64_t* bitmap;       // One bit per slot (RESULT_REGION_BITMAP)
+    uint32_t* rank;         // Set bits before each RESULT_RANK_SLOTS slots
+} ResultRegion;
+
+typedef struct {
+    BYTE* values;           // Last seen values, valueSize bytes each
+    BYTE* originalValues;   // First scan values, valueSize bytes each
+} ResultBlock;
+
+typedef struct {
+    ValueType valueType;
+    size_t valueSize;
+    size_t count;
+    std::vector<ResultRegion> regions;
+    std::vector<ResultBlock> blocks;
+} ScanResults;
+
+void initScanResults(ScanResults* results, ValueType type);
+void freeScanResults(ScanResults* results);
+void optimizeScanResults(ScanResults* results);
+size_t getScanResultsMemoryUsage(const ScanResults* results);
+
+// Filling. Regions are added in ascending address order with their final
+// result count, which picks the cheaper encoding for that density. Hits in
+// [base, base + span) at multiples of stride are then stored in ascending
+// order (offsetBias is added to each offset; originalValues may be nullptr
+// to use values), and closeScanResultRegion finishes the region.
+bool addScanResultRegion(ScanResults* results, uintptr_t base, SIZE_T span, SIZE_T stride, size_t count);
+void storeScanResults(ScanResults* results, size_t region, size_t entry, const uint32_t* offsets,
+                      uint32_t offsetBias, const BYTE* values, const BYTE* originalValues, size_t count);
+void closeScanResultRegion(ScanResults* results, size_t region);
+
+// Decodes up to maxCount offsets of a region's results, starting with its
+// entry'th result, regardless of encoding. Returns the number written.
+size_t getScanResultOffsets(const ScanResults* results, size_t region, size_t entry,
+                            uint32_t* offsets, size_t maxCount);
+
+// Lookups by result index.
+size_t findScanResultRegion(const ScanResults* results, size_t index);
+uintptr_t getScanResultAddress(const ScanResults* results, size_t index);
+const BYTE* getScanResultValue(const ScanResults* results, size_t index);
+const BYTE* getScanResultOriginal(const ScanResults* results, size_t index);
+int getScanResultValueInt(const ScanResults* results, size_t index);
+int getScanResultOriginalInt(const ScanResults* results, size_t index);
+void setScanResultValue(ScanResults* results, size_t index, const void* value);
+
+// Interprets valueSize bytes as the scanned type and returns it as an int
+// (floating point values are truncated and clamped to the int range, NaN and
+// infinities decode as 0; 64-bit integers keep their low half).
+// FormatScanValue shows the full value.
+int DecodeScanValue(const BYTE* p, size_t available, ValueType type);
@@ -0,0 +1,391 @@
+#include "scan_threads.h"
+#include "logging.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <sched.h>
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+typedef struct {
+    std::vector<int> cpus;      // Logical CPUs of one physical core, ascending
+    int node;
+} CpuCore;
+
+typedef struct {
+    std::vector<CpuCore> cores;             // Taking each node's cores in turn
+    std::vector<std::vector<int> > nodeCpus; // Allowed CPUs by node number
+    int nodeCount;                          // Nodes with allowed CPUs
+} CpuTopology;
+
+thread_local ScanThreadPlacement t_placement = { -1, -1, -1 };
+
+// Orders cores so that consecutive workers land on different nodes.
+void InterleaveNodes(std::vector<CpuCore>& cores, CpuTopology* topology) {
+    std::map<int, std::vector<CpuCore> > byNode;
+    for (size_t i = 0; i < cores.size(); i++) {
+        byNode[cores[i].node].push_back(cores[i]);
+    }
+    topology->nodeCount = (int)byNode.size();
+    for (size_t round = 0; topology->cores.size() < cores.size(); round++) {
+        for (std::map<int, std::vector<CpuCore> >::iterator it = byNode.begin(); it != byNode.end(); ++it) {
+            if (round < it->second.size()) {
+                topology->cores.push_back(it->second[round]);
+            }
+        }
+    }
+}
+
+void AddNodeCpu(CpuTopology* topology, int node, int cpu) {
+    if (node >= (int)topology->nodeCpus.size()) {
+        topology->nodeCpus.resize(node + 1);
+    }
+    topology->nodeCpus[node].push_back(cpu);
+}
+
+#ifdef _WIN32
+
+// Covers the processor group the process runs in, up to 64 CPUs.
+CpuTopology DetectTopology() {
+    CpuTopology topology;
+    topology.nodeCount = 0;
+
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    DWORD length = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) ||
+        (GetLogicalProcessorInformation(nullptr, &length) == FALSE && GetLastError() != ERROR_INSUFFICIENT_BUFFER)) {
+        return topology;
+    }
+    std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+    if (info.empty() || !GetLogicalProcessorInformation(info.data(), &length)) {
+        return topology;
+    }
+
+    std::vector<std::pair<int, ULONG_PTR> > nodes;
+    for (size_t i = 0; i < info.size(); i++) {
+        if (info[i].Relationship == RelationNumaNode) {
+            nodes.push_back(std::make_pair((int)info[i].NumaNode.NodeNumber, info[i].ProcessorMask & processMask));
+        }
+    }
+
+    std::vector<CpuCore> cores;
+    for (size_t i = 0; i < info.size(); i++) {
+        if (info[i].Relationship != RelationProcessorCore) {
+            continue;
+        }
+        CpuCore core;
+        core.node = 0;
+        ULONG_PTR mask = info[i].ProcessorMask & processMask;
+        for (int cpu = 0; cpu < (int)(sizeof(ULONG_PTR) * 8); cpu++) {
+            if (mask & ((ULONG_PTR)1 << cpu)) {
+                core.cpus.push_back(cpu);
+            }
+        }
+        if (core.cpus.empty()) {
+            continue;
+        }
+        for (size_t n = 0; n < nodes.size(); n++) {
+            if (nodes[n].second & ((ULONG_PTR)1 << core.cpus[0])) {
+                core.node = nodes[n].first;
+            }
+        }
+        for (size_t c = 0; c < core.cpus.size(); c++) {
+            AddNodeCpu(&topology, core.node, core.cpus[c]);
+        }
+        cores.push_back(core);
+    }
+    InterleaveNodes(cores, &topology);
+    return topology;
+}
+
+void ApplyPlacement(const ScanThreadPlacement& placement, const CpuTopology& topology) {
+    DWORD_PTR mask = 0;
+    if (placement.cpu >= 0) {
+        mask = (DWORD_PTR)1 << placement.cpu;
+    } else if (placement.node >= 0 && placement.node < (int)topology.nodeCpus.size()) {
+        const std::vector<int>& cpus = topology.nodeCpus[placement.node];
+        for (size_t i = 0; i < cpus.size(); i++) {
+            mask |= (DWORD_PTR)1 << cpus[i];
+        }
+    }
+    if (mask != 0 && !SetThreadAffinityMask(GetCurrentThread(), mask)) {
+        LOG_DEBUG("Cannot pin scan thread to CPU %d (error %lu)", placement.cpu, GetLastError());
+    }
+}
+
+void ApplyPriority(int level) {
+    static const int priorities[] = {
+        THREAD_PRIORITY_LOWEST, THREAD_PRIORITY_BELOW_NORMAL, THREAD_PRIORITY_NORMAL,
+        THREAD_PRIORITY_ABOVE_NORMAL, THREAD_PRIORITY_HIGHEST
+    };
+    if (level != 3 && !SetThreadPriority(GetCurrentThread(), priorities[std::max(1, std::min(level, 5)) - 1])) {
+        LOG_DEBUG("Cannot set scan thread priority (error %lu)", GetLastError());
+    }
+}
+
+#else
+
+bool ReadSysInt(const char* path, int* value) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    bool read = fscanf(file, "%d", value) == 1;
+    fclose(file);
+    return read;
+}
+
+// Parses a sysfs CPU list such as "0-3,8-11".
+void ReadCpuList(const char* path, std::vector<int>& cpus) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return;
+    }
+    int first = 0;
+    while (fscanf(file, "%d", &first) == 1) {
+        int last = first;
+        int next = fgetc(file);
+        if (next == '-') {
+            if (fscanf(file, "%d", &last) != 1) {
+                break;
+            }
+            next = fgetc(file);
+        }
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+        if (next != ',') {
+            break;
+        }
+    }
+    fclose(file);
+}
+
+CpuTopology DetectTopology() {
+    CpuTopology topology;
+    topology.nodeCount = 0;
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return topology;
+    }
+
+    std::vector<int> nodeOf(CPU_SETSIZE, 0);
+    DIR* nodes = opendir("/sys/devices/system/node");
+    if (nodes) {
+        struct dirent* entry;
+        while ((entry = readdir(nodes)) != nullptr) {
+            int node = 0;
+            if (sscanf(entry->d_name, "node%d", &node) != 1) {
+                continue;
+            }
+            char path[PATH_MAX];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/%s/cpulist", entry->d_name);
+            std::vector<int> cpus;
+            ReadCpuList(path, cpus);
+            for (size_t i = 0; i < cpus.size(); i++) {
+                if (cpus[i] >= 0 && cpus[i] < CPU_SETSIZE) {
+                    nodeOf[cpus[i]] = node;
+                }
+            }
+        }
+        closedir(nodes);
+    }
+
+    // core_id is only unique within a package.
+    std::map<std::pair<int, int>, size_t> coreIndex;
+    std::vector<CpuCore> cores;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        char path[PATH_MAX];
+        int package = 0;
+        int coreId = cpu;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        ReadSysInt(path, &package);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        ReadSysInt(path, &coreId);
+
+        std::pair<int, int> key(package, coreId);
+        std::map<std::pair<int, int>, size_t>::iterator it = coreIndex.find(key);
+        if (it == coreIndex.end()) {
+            CpuCore core;
+            core.node = nodeOf[cpu];
+            it = coreIndex.insert(std::make_pair(key, cores.size())).first;
+            cores.push_back(core);
+        }
+        cores[it->second].cpus.push_back(cpu);
+        AddNodeCpu(&topology, nodeOf[cpu], cpu);
+    }
+    InterleaveNodes(cores, &topology);
+    return topology;
+}
+
+void ApplyPlacement(const ScanThreadPlacement& placement, const CpuTopology& topology) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (placement.cpu >= 0) {
+        CPU_SET(placement.cpu, &set);
+    } else if (placement.node >= 0 && placement.node < (int)topology.nodeCpus.size()) {
+        const std::vector<int>& cpus = topology.nodeCpus[placement.node];
+        for (size_t i = 0; i < cpus.size(); i++) {
+            CPU_SET(cpus[i], &set);
+        }
+    }
+    if (CPU_COUNT(&set) > 0) {
+        int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (error != 0) {
+            LOG_DEBUG("Cannot pin scan thread to CPU %d (errno %d)", placement.cpu, error);
+        }
+    }
+}
+
+// Levels map to nice offsets from the creating thread. Raising priority
+// needs CAP_SYS_NICE; without it the threads stay at normal priority.
+void ApplyPriority(int level) {
+    static const int niceOffsets[] = { 10, 5, 0, -5, -10 };
+    int offset = niceOffsets[std::max(1, std::min(level, 5)) - 1];
+    if (offset == 0) {
+        return;
+    }
+    id_t tid = (id_t)syscall(SYS_gettid);
+    errno = 0;
+    int nice = getpriority(PRIO_PROCESS, tid);
+    if (errno == 0 && setpriority(PRIO_PROCESS, tid, nice + offset) != 0) {
+        LOG_DEBUG("Cannot change scan thread priority (errno %d)", errno);
+    }
+}
+
+#endif
+
+const CpuTopology& GetTopology() {
+    static const CpuTopology topology = DetectTopology();
+    return topology;
+}
+
+}
+
+std::vector<ScanThreadPlacement> PlanScanThreads(const Settings* settings, size_t count) {
+    ScanThreadPlacement unplaced = { -1, -1, -1 };
+    std::vector<ScanThreadPlacement> placements(count, unplaced);
+    const CpuTopology& topology = GetTopology();
+    if (!settings || !settings->pinThreadsToCores || topology.cores.empty()) {
+        return placements;
+    }
+
+    // Every core's first CPU, then the second ones, and so on.
+    std::vector<ScanThreadPlacement> slots;
+    for (size_t thread = 0;; thread++) {
+        bool added = false;
+        for (size_t c = 0; c < topology.cores.size(); c++) {
+            const CpuCore& core = topology.cores[c];
+            if (thread < core.cpus.size()) {
+                ScanThreadPlacement slot = { core.cpus[thread], -1, core.node };
+                slots.push_back(slot);
+                added = true;
+            }
+        }
+        if (!added) {
+            break;
+        }
+    }
+
+    const size_t coreCount = topology.cores.size();
+    for (size_t i = 0; i < count; i++) {
+        placements[i] = slots[i % slots.size()];
+        if (count <= coreCount && topology.cores[i].cpus.size() > 1) {
+            placements[i].siblingCpu = topology.cores[i].cpus[1];
+        }
+    }
+    return placements;
+}
+
+ScanThreadPlacement GetReaderPlacement(const ScanThreadPlacement& worker) {
+    ScanThreadPlacement reader = { worker.siblingCpu, -1, worker.node };
+    return reader;
+}
+
+ScanThreadPlacement GetScanThreadPlacement() {
+    return t_placement;
+}
+
+int GetNumaNodeCount() {
+    return std::max(1, GetTopology().nodeCount);
+}
+
+void ScanThread::start(unsigned (__stdcall *func)(void*), void* arg, const ScanThreadPlacement& placement,
+                       const Settings* settings) {
+    join();
+    this->func = func;
+    this->arg = arg;
+    this->placement = placement;
+    this->settings = settings;
+    size_t stackSize = settings ? settings->threadStackSize : 0;
+
+#ifdef _WIN32
+    handle = (HANDLE)_beginthreadex(nullptr, (unsigned)stackSize, entry, this, 0, nullptr);
+    if (!handle) {
+        throw std::runtime_error("Failed to start scan thread");
+    }
+#else
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (stackSize > 0) {
+        pthread_attr_setstacksize(&attr, std::max(stackSize, (size_t)PTHREAD_STACK_MIN));
+    }
+    int error = pthread_create(&handle, &attr, entry, this);
+    pthread_attr_destroy(&attr);
+    if (error != 0) {
+        throw std::runtime_error("Failed to start scan thread");
+    }
+#endif
+    started = true;
+}
+
+void ScanThread::join() {
+    if (!started) {
+        return;
+    }
+#ifdef _WIN32
+    WaitForSingleObject(handle, INFINITE);
+    CloseHandle(handle);
+#else
+    pthread_join(handle, nullptr);
+#endif
+    started = false;
+}
+
+void ScanThread::run() {
+    ApplyPlacement(placement, GetTopology());
+    if (settings) {
+        ApplyPriority(settings->threadPriorityLevel);
+    }
+    t_placement = placement;
+    func(arg);
+}
+
+#ifdef _WIN32
+unsigned __stdcall ScanThread::entry(void* self) {
+    static_cast<ScanThread*>(self)->run();
+    return 0;
+}
+#else
+void* ScanThread::entry(void* self) {
+    static_cast<ScanThread*>(self)->run();
+    return nullptr;
+}
+#endif
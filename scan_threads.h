@@ -0,0 +1,71 @@
+#pragma once
+
+#include "platform.h"
+#include <stddef.h>
+#include <vector>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "settings.h"
+
+// Thread placement for scan workers. With pinThreadsToCores each worker is
+// pinned to a physical core of its own, taking the nodes' cores in turn so
+// every socket's memory controller is used, and the worker's read-ahead
+// reader runs on that core's sibling hyperthread, where the chunks it
+// fills land in the caches the compare reads them from. Workers beyond
+// the core count take the siblings, and readers then float over their
+// worker's node. Scan buffers a placed thread maps come from its node.
+// Every scan thread runs at threadPriorityLevel with a threadStackSize
+// stack.
+
+typedef struct {
+    int cpu;                // Logical CPU, -1 when not pinned to one
+    int siblingCpu;         // The core's free hyperthread for the reader, -1 if none
+    int node;               // NUMA node, -1 when unknown; with cpu -1 the thread floats over it
+} ScanThreadPlacement;
+
+// One placement per worker, worker 0 first. Every entry is unplaced when
+// pinThreadsToCores is off or the topology cannot be read.
+std::vector<ScanThreadPlacement> PlanScanThreads(const Settings* settings, size_t count);
+
+// Where the reader of a worker placed at worker goes.
+ScanThreadPlacement GetReaderPlacement(const ScanThreadPlacement& worker);
+
+// Placement of the calling scan thread, unplaced for other threads.
+ScanThreadPlacement GetScanThreadPlacement();
+
+// NUMA nodes holding CPUs this process may run on; 1 without NUMA.
+int GetNumaNodeCount();
+
+// A native thread running func(arg) at placement, with the priority and
+// stack size from settings.
+class ScanThread {
+private:
+    unsigned (__stdcall *func)(void*);
+    void* arg;
+    ScanThreadPlacement placement;
+    const Settings* settings;
+    bool started;
+#ifdef _WIN32
+    HANDLE handle;
+    static unsigned __stdcall entry(void* self);
+#else
+    pthread_t handle;
+    static void* entry(void* self);
+#endif
+    void run();
+
+    ScanThread(const ScanThread&);
+    ScanThread& operator=(const ScanThread&);
+
+public:
+    ScanThread() : func(nullptr), arg(nullptr), settings(nullptr), started(false) {}
+    ~ScanThread() { join(); }
+
+    // Throws std::runtime_error when no thread can be created.
+    void start(unsigned (__stdcall *func)(void*), void* arg, const ScanThreadPlacement& placement,
+               const Settings* settings);
+    void join();
+};
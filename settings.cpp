@@ -1,8 +1,10 @@
 #include "settings.h"
 #include "logging.h"
-#include <windows.h>
+#include "platform.h"
+#ifdef _WIN32
 #include <shlwapi.h>
 #include <shlobj.h>
+#endif
 #include <string.h>
 #include "include/imgui.h"
 #include <algorithm>
@@ -13,7 +15,7 @@ Settings g_settings;
 void initSettings(Settings* settings) {
     if (!settings) return;
     
-    ZeroMemory(settings, sizeof(Settings));
+    *settings = Settings();
     
 	// General settings
     settings->threadCount = 4; // Default to 4 threads
@@ -29,9 +31,11 @@ void initSettings(Settings* settings) {
     // Security settings
     settings->useBytePatternScanning = false; // Disable pattern scanning
     settings->useFuzzyScanning = false; // Disable fuzzy scanning
+    settings->fuzzyThreshold = 0.01f; // Fuzzy float matches within 1% of the value
     settings->scanUnalignedAddresses = false; // Disable unaligned scanning
     settings->detectPointerChains = false; // Disable pointer chain detection
     settings->maxPointerDepth = 3; // Maximum 3 levels deep
+    settings->enableMultiScan = false; // Single value scans
     // Memory protection settings
     settings->overwriteMemoryProtection = false;	
     settings->backupMemoryBeforeWrite = true; // Backup memory before writing
@@ -47,6 +51,20 @@ void initSettings(Settings* settings) {
     settings->useVectorizedOperations = true;  // Enable SIMD operations
     settings->scanAlignment = 16; // 16-byte alignment
     settings->scanChunkMultiplier = 2; // Double the default chunk size
+    settings->scanChunkSize = 1024 * 1024; // 1MB work unit per scan thread
+    settings->verifyScanHits = false; // Trust the bulk read buffer
+    settings->snapshotMemoryMB = 512; // Spill unknown value snapshots past 512MB
+    settings->maxPointerOffset = 4096; // Follow pointers up to 4KB before the target
+    settings->regionMapRefreshInterval = 2000; // Re-walk the cached region map every 2 seconds
+    settings->floatEpsilon = 0.0001; // Float and double scans tolerate rounding below 1e-4
+    settings->scanPipelineDepth = 2; // Read the next chunk while comparing the current one
+    settings->skipZeroRegions = true; // Untouched and zero pages are never read
+#ifdef _WIN32
+    settings->skipSwappedPages = false; // Outside the working set also covers standby and untouched pages
+#else
+    settings->skipSwappedPages = true; // Don't page the target's swapped memory back in
+#endif
+    settings->incrementalNextScan = false; // Leave the target's soft-dirty bits alone unless asked
     settings->adaptiveThreading = true; // Enable adaptive threading
 	settings->cacheOptimization = true; // Enable cache optimization
 	settings->searchTimeoutMs = 5000;  // 5 seconds timeout
@@ -108,13 +126,22 @@ const char* getSettingsFilePath() {
     static char filePath[MAX_PATH] = {0};
     
     if (filePath[0] == '\0') {
-        char exePath[MAX_PATH];
+        char exePath[MAX_PATH] = {0};
+#ifdef _WIN32
         if (GetModuleFileNameA(NULL, exePath, MAX_PATH) == 0) {
             LOG_ERROR("Failed to get executable path");
             return "CEngine.settings";
         }
 
         char* lastSlash = strrchr(exePath, '\\');
+#else
+        if (readlink("/proc/self/exe", exePath, MAX_PATH - 1) <= 0) {
+            LOG_ERROR("Failed to get executable path");
+            return "CEngine.settings";
+        }
+
+        char* lastSlash = strrchr(exePath, '/');
+#endif
         if (lastSlash) {
             *(lastSlash + 1) = '\0';
             strcpy_s(filePath, sizeof(filePath), exePath);
@@ -200,14 +227,17 @@ void validateSettings(Settings* settings) {
     settings->maxThreadCount = std::max(settings->minThreadCount, 
                                       std::min(settings->maxThreadCount, 
                                       (int)std::thread::hardware_concurrency()));
+    settings->threadPriorityLevel = std::max(1, std::min(settings->threadPriorityLevel, 5));
+    settings->threadStackSize = std::max(size_t(64) * 1024, std::min(settings->threadStackSize, size_t(64) * 1024 * 1024));
     
     // Buffer settings validation
-    settings->minBufferSize = std::max(1ULL, std::min(settings->minBufferSize, 1024ULL));
+    settings->minBufferSize = std::max(size_t(1), std::min(settings->minBufferSize, size_t(1024)));
     settings->maxBufferSize = std::max(settings->minBufferSize, 
-                                     std::min(settings->maxBufferSize, 4096ULL));
+                                     std::min(settings->maxBufferSize, size_t(4096)));
     
     settings->bufferAlignment = std::max(4096, 
                                        std::min(settings->bufferAlignment, 65536));
+    settings->bufferPoolSize = std::max(size_t(16), std::min(settings->bufferPoolSize, size_t(16384)));
     
     // Performance settings validation - Fix type mismatch
     settings->scanChunkSize = std::max(size_t(4096), 
@@ -215,6 +245,19 @@ void validateSettings(Settings* settings) {
                                      size_t(16) * 1024 * 1024));
     
     settings->scanBatchSize = std::max(100, std::min(settings->scanBatchSize, 10000));
+    settings->snapshotMemoryMB = std::max(size_t(64), std::min(settings->snapshotMemoryMB, size_t(65536)));
+    settings->maxPointerDepth = std::max(1, std::min(settings->maxPointerDepth, 10));
+    settings->maxPointerOffset = std::max(8, std::min(settings->maxPointerOffset, 1024 * 1024));
+    settings->regionMapRefreshInterval = std::max(0, std::min(settings->regionMapRefreshInterval, 60000));
+    if (!(settings->floatEpsilon >= 1e-9)) {
+        settings->floatEpsilon = 1e-9;
+    }
+    settings->floatEpsilon = std::min(settings->floatEpsilon, 1.0);
+    if (!(settings->fuzzyThreshold >= 0.0f)) {
+        settings->fuzzyThreshold = 0.0f;
+    }
+    settings->fuzzyThreshold = std::min(settings->fuzzyThreshold, 1.0f);
+    settings->scanPipelineDepth = std::max(0, std::min(settings->scanPipelineDepth, 16));
     
     LOG_DEBUG("Settings validated and adjusted if necessary");
 }
@@ -130,6 +130,30 @@ typedef struct {
     bool optimizeForSpeed;          // Optimize for speed vs memory usage
     int scanBatchSize;             // Number of addresses to process in batch
     bool useIntelIPP;              // Use Intel IPP library if available
+
+    // Scan Verification Settings
+    bool verifyScanHits;            // Re-read pages holding hits and drop values that changed
+
+    // Snapshot Settings
+    size_t snapshotMemoryMB;        // Compressed snapshot kept in RAM before spilling to disk
+
+    // Pointer Scan Settings
+    int maxPointerOffset;           // Largest offset followed back from a pointer, in bytes
+
+    // Region Map Settings
+    int regionMapRefreshInterval;   // Re-walk cached regions after this many ms, 0 = only when a scan starts
+
+    // Value Type Settings
+    double floatEpsilon;            // Float and double values within this of the target match
+
+    // Scan Pipeline Settings
+    int scanPipelineDepth;          // Chunk buffers each scan worker reads ahead into, below 2 = read inline
+
+    // Page Residency Settings
+    bool skipSwappedPages;          // Leave pages paged out of the target unread instead of paging them in
+
+    // Incremental Scan Settings
+    bool incrementalNextScan;       // Next scans reuse values on pages the target has not written since
     
 } Settings;
 
@@ -2,6 +2,8 @@
 #include "include/imgui.h"
 #include "logging.h"
 #include "settings.h"
+#include "scan_buffer_pool.h"
+#include <algorithm>
 
 extern void ShowStatusMessage(const char* message);
 extern bool g_firstRun;
@@ -52,6 +54,29 @@ bool ShowSettingsDialog(bool* p_open, Settings* settings) {
                 settingsChanged = true;
             }
             ImGui::SameLine(); ImGui::HelpMarker("Number of threads to use for scanning");
+
+            bool pinThreadsToCores = settings->pinThreadsToCores;
+            if (ImGui::Checkbox("Pin Threads To Cores##perf", &pinThreadsToCores)) {
+                settings->pinThreadsToCores = pinThreadsToCores;
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Give each scan thread a physical core of its own, spread over\n"
+                                                 "the NUMA nodes, with its reader on the core's hyperthread");
+
+            int threadPriorityLevel = settings->threadPriorityLevel;
+            if (ImGui::SliderInt("Thread Priority##perf", &threadPriorityLevel, 1, 5)) {
+                settings->threadPriorityLevel = threadPriorityLevel;
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("OS priority of scan threads: 1 lowest, 3 normal, 5 highest\n"
+                                                 "Raising it on Linux needs CAP_SYS_NICE");
+
+            int threadStackKB = (int)(settings->threadStackSize / 1024);
+            if (ImGui::SliderInt("Thread Stack Size (KB)##perf", &threadStackKB, 64, 65536)) {
+                settings->threadStackSize = (size_t)threadStackKB * 1024;
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Stack reserved for each scan thread");
             
             int bufferSizeMB = settings->scanBufferMB;
             if (ImGui::SliderInt("Scan Buffer Size (MB)##perf", &bufferSizeMB, 1, 1024)) {
@@ -60,6 +85,50 @@ bool ShowSettingsDialog(bool* p_open, Settings* settings) {
             }
             ImGui::SameLine(); ImGui::HelpMarker("Size of the buffer used for scanning memory in megabytes\n"
                                                  "Larger buffers can scan more memory but may be slower");
+
+            // Buffers already in the pool were mapped under the old
+            // settings, so they are dropped when these change.
+            bool useBufferPooling = settings->useBufferPooling;
+            if (ImGui::Checkbox("Buffer Pooling##perf", &useBufferPooling)) {
+                settings->useBufferPooling = useBufferPooling;
+                TrimScanBufferPool();
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Keep scan buffers between scans instead of mapping fresh\n"
+                                                 "memory for every scan thread each time");
+
+            int bufferPoolSize = (int)settings->bufferPoolSize;
+            if (ImGui::SliderInt("Buffer Pool Size (MB)##perf", &bufferPoolSize, 16, 16384)) {
+                settings->bufferPoolSize = (size_t)bufferPoolSize;
+                TrimScanBufferPool();
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Idle scan buffers kept for the next scan");
+
+            static const int alignments[] = { 4096, 8192, 16384, 32768, 65536 };
+            static const char* alignmentNames[] = { "4 KB", "8 KB", "16 KB", "32 KB", "64 KB" };
+            int alignmentIndex = 0;
+            for (int i = 0; i < IM_ARRAYSIZE(alignments); i++) {
+                if (settings->bufferAlignment == alignments[i]) {
+                    alignmentIndex = i;
+                }
+            }
+            if (ImGui::Combo("Buffer Alignment##perf", &alignmentIndex, alignmentNames, IM_ARRAYSIZE(alignmentNames))) {
+                settings->bufferAlignment = alignments[alignmentIndex];
+                TrimScanBufferPool();
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Address alignment of scan buffers");
+
+            bool useLargePages = settings->useLargePages;
+            if (ImGui::Checkbox("Use Large Pages##perf", &useLargePages)) {
+                settings->useLargePages = useLargePages;
+                TrimScanBufferPool();
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Back scan buffers with 2 MB pages to cut TLB misses.\n"
+                                                 "Needs the Lock pages in memory right on Windows and\n"
+                                                 "falls back to regular pages without it");
             
             bool cacheOptimize = settings->cacheOptimization;
             if (ImGui::Checkbox("Cache Optimization##perf", &cacheOptimize)) {
@@ -93,6 +162,22 @@ bool ShowSettingsDialog(bool* p_open, Settings* settings) {
             }
             ImGui::SameLine(); ImGui::HelpMarker("Use SIMD/vectorized operations when available");
             
+            bool verifyScanHits = settings->verifyScanHits;
+            if (ImGui::Checkbox("Verify Scan Hits", &verifyScanHits)) {
+                settings->verifyScanHits = verifyScanHits;
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Re-read the pages holding scan hits and drop values that changed\n"
+                                                 "during the scan (one read per page, not per hit)");
+            
+            int snapshotMemoryMB = (int)settings->snapshotMemoryMB;
+            if (ImGui::SliderInt("Snapshot Memory (MB)", &snapshotMemoryMB, 64, 8192)) {
+                settings->snapshotMemoryMB = (size_t)snapshotMemoryMB;
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Compressed unknown initial value snapshot kept in RAM;\n"
+                                                 "anything beyond this spills to a temporary file");
+            
             int scanBatchSize = settings->scanBatchSize;
             if (ImGui::SliderInt("Result Batch Size", &scanBatchSize, 100, 10000)) {
                 settings->scanBatchSize = scanBatchSize;
@@ -106,6 +191,58 @@ bool ShowSettingsDialog(bool* p_open, Settings* settings) {
                 settingsChanged = true;
             }
             ImGui::SameLine(); ImGui::HelpMarker("Enable memory prefetching for better performance");
+
+            int regionRefresh = settings->regionMapRefreshInterval;
+            if (ImGui::SliderInt("Region Map Refresh (ms)", &regionRefresh, 0, 10000)) {
+                settings->regionMapRefreshInterval = regionRefresh;
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("How old the cached memory region list may get before it is\n"
+                                                 "walked again. 0 walks it only when a scan starts");
+
+            double floatEpsilon = settings->floatEpsilon;
+            if (ImGui::InputDouble("Float Epsilon", &floatEpsilon, 0.0, 0.0, "%g")) {
+                settings->floatEpsilon = std::max(1e-9, std::min(floatEpsilon, 1.0));
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Float and double values closer than this to the searched\n"
+                                                 "value count as equal");
+
+            bool skipZeroRegions = settings->skipZeroRegions;
+            if (ImGui::Checkbox("Skip Zero Pages", &skipZeroRegions)) {
+                settings->skipZeroRegions = skipZeroRegions;
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Leave never touched and shared zero pages unread, judged from\n"
+                                                 "the target's page tables. Still read when the value is 0");
+
+            bool skipSwappedPages = settings->skipSwappedPages;
+            if (ImGui::Checkbox("Skip Swapped Out Pages", &skipSwappedPages)) {
+                settings->skipSwappedPages = skipSwappedPages;
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Leave pages the target has paged out unread instead of\n"
+                                                 "making it page them back in. Values on them are missed.\n"
+                                                 "Windows only sees the working set, so this also skips\n"
+                                                 "trimmed pages still in RAM and untouched zero pages of\n"
+                                                 "background targets; it is off there by default");
+
+            bool incrementalNextScan = settings->incrementalNextScan;
+            if (ImGui::Checkbox("Incremental Next Scan", &incrementalNextScan)) {
+                settings->incrementalNextScan = incrementalNextScan;
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Track which pages the target writes and let next scans re-read\n"
+                                                 "only those (Linux soft-dirty bits). Resets the target's\n"
+                                                 "soft-dirty record, which costs it one fault per written page");
+
+            int scanPipelineDepth = settings->scanPipelineDepth;
+            if (ImGui::SliderInt("Scan Pipeline Depth", &scanPipelineDepth, 0, 16)) {
+                settings->scanPipelineDepth = scanPipelineDepth;
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Chunk buffers each scan thread keeps; a reader thread fills\n"
+                                                 "them ahead while the thread compares. Below 2 reads inline");
             ImGui::Separator();
 
             ImGui::Text("Advanced Scanning Options");
@@ -116,21 +253,33 @@ bool ShowSettingsDialog(bool* p_open, Settings* settings) {
                 settings->useBytePatternScanning = usePattern;
                 settingsChanged = true;
             }
-            ImGui::SameLine(); ImGui::HelpMarker("Enable pattern-based memory scanning");
+            ImGui::SameLine(); ImGui::HelpMarker("Enable array-of-bytes signature scanning of module code,\n"
+                                                 "e.g. 48 8B 05 ?? ?? ?? ?? (?? = any byte, 4? = any low nibble)");
+            
+            bool multiScan = settings->enableMultiScan;
+            if (ImGui::Checkbox("Multi-Value Scanning", &multiScan)) {
+                settings->enableMultiScan = multiScan;
+                settingsChanged = true;
+            }
+            ImGui::SameLine(); ImGui::HelpMarker("Search several values (e.g. health, max health, ammo)\n"
+                                                 "in one pass over memory, or structs holding several\n"
+                                                 "values at fixed offsets from each other");
             
             bool useFuzzy = settings->useFuzzyScanning;
             if (ImGui::Checkbox("Fuzzy Value Matching", &useFuzzy)) {
                 settings->useFuzzyScanning = useFuzzy;
                 settingsChanged = true;
             }
-            ImGui::SameLine(); ImGui::HelpMarker("Allow for approximate value matching with tolerance");
+            ImGui::SameLine(); ImGui::HelpMarker("Exact float and double scans also match values within\n"
+                                                 "the fuzzy threshold of the searched value");
             
             if (settings->useFuzzyScanning) {
                 float threshold = settings->fuzzyThreshold;
-                if (ImGui::SliderFloat("Fuzzy Threshold", &threshold, 0.0f, 1.0f, "%.2f")) {
+                if (ImGui::SliderFloat("Fuzzy Threshold", &threshold, 0.0f, 1.0f, "%.3f")) {
                     settings->fuzzyThreshold = threshold;
                     settingsChanged = true;
                 }
+                ImGui::SameLine(); ImGui::HelpMarker("Relative tolerance: 0.010 accepts values within 1%");
             }
             
             bool detectPointers = settings->detectPointerChains;
@@ -138,7 +287,8 @@ bool ShowSettingsDialog(bool* p_open, Settings* settings) {
                 settings->detectPointerChains = detectPointers;
                 settingsChanged = true;
             }
-            ImGui::SameLine(); ImGui::HelpMarker("Attempt to detect pointer chains automatically");
+            ImGui::SameLine(); ImGui::HelpMarker("Enable the pointer scanner: find static pointer paths\n"
+                                                 "leading to the address in Memory Modification");
             
             if (settings->detectPointerChains) {
                 int depth = settings->maxPointerDepth;
@@ -146,6 +296,13 @@ bool ShowSettingsDialog(bool* p_open, Settings* settings) {
                     settings->maxPointerDepth = depth;
                     settingsChanged = true;
                 }
+                
+                int maxOffset = settings->maxPointerOffset;
+                if (ImGui::SliderInt("Max Pointer Offset", &maxOffset, 8, 65536)) {
+                    settings->maxPointerOffset = maxOffset;
+                    settingsChanged = true;
+                }
+                ImGui::SameLine(); ImGui::HelpMarker("Largest offset from a pointer to the field it leads to");
             }
             
             bool useOptimizedSearch = settings->useOptimizedSearch;
@@ -0,0 +1,281 @@
+#include "platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "snapshot.h"
+#include "logging.h"
+
+static int seekSpillFile(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64)offset, SEEK_SET);
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+}
+
+// PackBits: a control byte c < 128 is followed by c + 1 literal bytes,
+// c >= 128 by one byte repeated c - 125 times (3..130). Returns the
+// encoded size, or capacity + 1 once the output would not fit.
+static size_t packBitsEncode(const BYTE* src, size_t size, BYTE* dst, size_t capacity) {
+    size_t in = 0;
+    size_t out = 0;
+    while (in < size) {
+        size_t run = 1;
+        while (in + run < size && run < 130 && src[in + run] == src[in]) {
+            run++;
+        }
+        if (run >= 3) {
+            if (out + 2 > capacity) return capacity + 1;
+            dst[out++] = (BYTE)(run + 125);
+            dst[out++] = src[in];
+            in += run;
+            continue;
+        }
+
+        size_t start = in;
+        size_t length = 0;
+        while (in < size && length < 128) {
+            if (in + 2 < size && src[in] == src[in + 1] && src[in] == src[in + 2]) {
+                break;
+            }
+            in++;
+            length++;
+        }
+        if (out + 1 + length > capacity) return capacity + 1;
+        dst[out++] = (BYTE)(length - 1);
+        memcpy(&dst[out], &src[start], length);
+        out += length;
+    }
+    return out;
+}
+
+static bool packBitsDecode(const BYTE* src, size_t size, BYTE* dst, size_t dstSize) {
+    size_t in = 0;
+    size_t out = 0;
+    while (in < size) {
+        BYTE control = src[in++];
+        if (control < 128) {
+            size_t length = (size_t)control + 1;
+            if (in + length > size || out + length > dstSize) return false;
+            memcpy(&dst[out], &src[in], length);
+            in += length;
+            out += length;
+        } else {
+            size_t length = (size_t)control - 125;
+            if (in >= size || out + length > dstSize) return false;
+            memset(&dst[out], src[in++], length);
+            out += length;
+        }
+    }
+    return out == dstSize;
+}
+
+void initMemorySnapshot(MemorySnapshot* snapshot, size_t memoryLimit) {
+    snapshot->regions.clear();
+    snapshot->pages.clear();
+    snapshot->segments.clear();
+    snapshot->segmentUsed = SNAPSHOT_SEGMENT_SIZE;
+    snapshot->memoryLimit = memoryLimit;
+    snapshot->memoryBytes = 0;
+    snapshot->capturedBytes = 0;
+    snapshot->spillFile = nullptr;
+    snapshot->spillBytes = 0;
+}
+
+void freeMemorySnapshot(MemorySnapshot* snapshot) {
+    for (size_t i = 0; i < snapshot->segments.size(); i++) {
+        free(snapshot->segments[i]);
+    }
+    if (snapshot->spillFile) {
+        fclose(snapshot->spillFile);
+    }
+    std::vector<SnapshotRegion>().swap(snapshot->regions);
+    std::vector<SnapshotPage>().swap(snapshot->pages);
+    std::vector<BYTE*>().swap(snapshot->segments);
+    initMemorySnapshot(snapshot, snapshot->memoryLimit);
+}
+
+bool hasMemorySnapshot(const MemorySnapshot* snapshot) {
+    return !snapshot->regions.empty();
+}
+
+size_t addSnapshotRegion(MemorySnapshot* snapshot, uintptr_t base, SIZE_T size) {
+    SnapshotRegion region;
+    region.base = base;
+    region.size = size;
+    region.firstPage = snapshot->pages.size();
+    snapshot->regions.push_back(region);
+
+    SnapshotPage missing;
+    memset(&missing, 0, sizeof(missing));
+    missing.encoding = SNAPSHOT_PAGE_MISSING;
+    snapshot->pages.resize(snapshot->pages.size() + (size + SNAPSHOT_PAGE_SIZE - 1) / SNAPSHOT_PAGE_SIZE, missing);
+    return snapshot->regions.size() - 1;
+}
+
+bool storeSnapshotPages(MemorySnapshot* snapshot, size_t firstPage, const BYTE* data, size_t pageCount,
+                        std::vector<BYTE>& scratch) {
+    // Encode every page back to back into scratch outside the lock.
+    if (scratch.size() < pageCount * SNAPSHOT_PAGE_SIZE) {
+        scratch.resize(pageCount * SNAPSHOT_PAGE_SIZE);
+    }
+    std::vector<SnapshotPage> encoded(pageCount);
+    size_t total = 0;
+    for (size_t i = 0; i < pageCount; i++) {
+        const BYTE* page = &data[i * SNAPSHOT_PAGE_SIZE];
+        SnapshotPage& entry = encoded[i];
+        memset(&entry, 0, sizeof(entry));
+
+        if (memcmp(page, page + 1, SNAPSHOT_PAGE_SIZE - 1) == 0) {
+            entry.encoding = SNAPSHOT_PAGE_FILL;
+            entry.fill = page[0];
+            continue;
+        }
+
+        size_t size = packBitsEncode(page, SNAPSHOT_PAGE_SIZE, &scratch[total], SNAPSHOT_PAGE_SIZE - 1);
+        if (size < SNAPSHOT_PAGE_SIZE) {
+            entry.encoding = SNAPSHOT_PAGE_RLE;
+        } else {
+            entry.encoding = SNAPSHOT_PAGE_RAW;
+            size = SNAPSHOT_PAGE_SIZE;
+            memcpy(&scratch[total], page, size);
+        }
+        entry.offset = total;
+        entry.size = (uint16_t)size;
+        total += size;
+    }
+
+    std::lock_guard<std::mutex> lock(snapshot->lock);
+    bool spill = snapshot->memoryBytes + total > snapshot->memoryLimit;
+    if (spill && !snapshot->spillFile) {
+        snapshot->spillFile = tmpfile();
+        if (snapshot->spillFile) {
+            LOG_INFO("Snapshot passed %zu MB in memory, spilling to disk", snapshot->memoryLimit / (1024 * 1024));
+        } else {
+            LOG_WARNING("Failed to create snapshot spill file, keeping snapshot in memory");
+            snapshot->memoryLimit = (size_t)-1;
+            spill = false;
+        }
+    }
+
+    if (spill && total > 0) {
+        if (seekSpillFile(snapshot->spillFile, snapshot->spillBytes) != 0 ||
+            fwrite(scratch.data(), 1, total, snapshot->spillFile) != total) {
+            LOG_ERROR("Failed to write %zu bytes to snapshot spill file", total);
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < pageCount; i++) {
+        SnapshotPage& entry = encoded[i];
+        if (entry.encoding == SNAPSHOT_PAGE_RLE || entry.encoding == SNAPSHOT_PAGE_RAW) {
+            if (spill) {
+                entry.offset += snapshot->spillBytes;
+                entry.spilled = true;
+            } else {
+                if (snapshot->segments.empty() || snapshot->segmentUsed + entry.size > SNAPSHOT_SEGMENT_SIZE) {
+                    BYTE* segment = (BYTE*)malloc(SNAPSHOT_SEGMENT_SIZE);
+                    if (!segment) {
+                        LOG_ERROR("Failed to allocate snapshot segment");
+                        return false;
+                    }
+                    snapshot->segments.push_back(segment);
+                    snapshot->segmentUsed = 0;
+                }
+                BYTE* segment = snapshot->segments.back();
+                memcpy(&segment[snapshot->segmentUsed], &scratch[entry.offset], entry.size);
+                entry.offset = (uint64_t)(snapshot->segments.size() - 1) * SNAPSHOT_SEGMENT_SIZE + snapshot->segmentUsed;
+                snapshot->segmentUsed += entry.size;
+                snapshot->memoryBytes += entry.size;
+            }
+        }
+        snapshot->pages[firstPage + i] = entry;
+    }
+    if (spill) {
+        snapshot->spillBytes += total;
+    }
+    snapshot->capturedBytes += pageCount * SNAPSHOT_PAGE_SIZE;
+    return true;
+}
+
+void loadSnapshotPages(MemorySnapshot* snapshot, size_t firstPage, size_t pageCount, BYTE* out, bool* valid,
+                       std::vector<BYTE>& scratch) {
+    for (size_t i = 0; i < pageCount; ) {
+        const SnapshotPage& page = snapshot->pages[firstPage + i];
+        BYTE* target = &out[i * SNAPSHOT_PAGE_SIZE];
+
+        if (page.encoding == SNAPSHOT_PAGE_MISSING) {
+            valid[i++] = false;
+            continue;
+        }
+        if (page.encoding == SNAPSHOT_PAGE_FILL) {
+            memset(target, page.fill, SNAPSHOT_PAGE_SIZE);
+            valid[i++] = true;
+            continue;
+        }
+
+        if (!page.spilled) {
+            const BYTE* data = &snapshot->segments[page.offset / SNAPSHOT_SEGMENT_SIZE][page.offset % SNAPSHOT_SEGMENT_SIZE];
+            if (page.encoding == SNAPSHOT_PAGE_RAW) {
+                memcpy(target, data, SNAPSHOT_PAGE_SIZE);
+                valid[i] = true;
+            } else {
+                valid[i] = packBitsDecode(data, page.size, target, SNAPSHOT_PAGE_SIZE);
+            }
+            i++;
+            continue;
+        }
+
+        // Pages stored by one call sit back to back in the spill file, so
+        // the whole contiguous stretch comes in with one read.
+        size_t end = i + 1;
+        uint64_t stretchEnd = page.offset + page.size;
+        while (end < pageCount) {
+            const SnapshotPage& next = snapshot->pages[firstPage + end];
+            if (next.encoding == SNAPSHOT_PAGE_FILL || next.encoding == SNAPSHOT_PAGE_MISSING) {
+                end++;
+                continue;
+            }
+            if (!next.spilled || next.offset != stretchEnd) {
+                break;
+            }
+            stretchEnd += next.size;
+            end++;
+        }
+
+        size_t bytes = (size_t)(stretchEnd - page.offset);
+        if (scratch.size() < bytes) {
+            scratch.resize(bytes);
+        }
+        bool readOk;
+        {
+            std::lock_guard<std::mutex> lock(snapshot->lock);
+            readOk = seekSpillFile(snapshot->spillFile, page.offset) == 0 &&
+                     fread(scratch.data(), 1, bytes, snapshot->spillFile) == bytes;
+        }
+        if (!readOk) {
+            LOG_ERROR("Failed to read %zu bytes from snapshot spill file", bytes);
+        }
+
+        for (; i < end; i++) {
+            const SnapshotPage& stretchPage = snapshot->pages[firstPage + i];
+            target = &out[i * SNAPSHOT_PAGE_SIZE];
+            if (stretchPage.encoding == SNAPSHOT_PAGE_MISSING) {
+                valid[i] = false;
+            } else if (stretchPage.encoding == SNAPSHOT_PAGE_FILL) {
+                memset(target, stretchPage.fill, SNAPSHOT_PAGE_SIZE);
+                valid[i] = true;
+            } else if (!readOk) {
+                valid[i] = false;
+            } else {
+                const BYTE* data = &scratch[stretchPage.offset - page.offset];
+                if (stretchPage.encoding == SNAPSHOT_PAGE_RAW) {
+                    memcpy(target, data, SNAPSHOT_PAGE_SIZE);
+                    valid[i] = true;
+                } else {
+                    valid[i] = packBitsDecode(data, stretchPage.size, target, SNAPSHOT_PAGE_SIZE);
+                }
+            }
+        }
+    }
+}
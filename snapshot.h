@@ -0,0 +1,70 @@
+#pragma once
+
+#include "platform.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <mutex>
+
+// Compressed copy of a process's writable memory, taken by the unknown
+// initial value scan and compared against by the next scan. Every page is
+// encoded on its own: a single repeated byte costs no data at all, other
+// pages are run-length encoded (PackBits) or kept raw when that does not
+// help. Encoded pages are held in RAM up to memoryLimit bytes and appended
+// to a temporary spill file after that.
+
+const SIZE_T SNAPSHOT_PAGE_SIZE = 4096;
+const size_t SNAPSHOT_SEGMENT_SIZE = 4 * 1024 * 1024;
+
+typedef enum {
+    SNAPSHOT_PAGE_MISSING,  // Not captured (read failed)
+    SNAPSHOT_PAGE_FILL,     // Every byte equals fill
+    SNAPSHOT_PAGE_RLE,      // PackBits encoded
+    SNAPSHOT_PAGE_RAW       // Stored as is
+} SnapshotPageEncoding;
+
+typedef struct {
+    uint64_t offset;        // Position in the RAM segments or the spill file
+    uint16_t size;          // Encoded bytes
+    uint8_t encoding;       // SnapshotPageEncoding
+    uint8_t fill;           // Byte value of a SNAPSHOT_PAGE_FILL page
+    bool spilled;           // Data lives in the spill file
+} SnapshotPage;
+
+typedef struct {
+    uintptr_t base;
+    SIZE_T size;
+    size_t firstPage;       // Index of the region's first page
+} SnapshotRegion;
+
+typedef struct {
+    std::vector<SnapshotRegion> regions;
+    std::vector<SnapshotPage> pages;
+    std::vector<BYTE*> segments;    // RAM storage, SNAPSHOT_SEGMENT_SIZE each
+    size_t segmentUsed;             // Bytes used in the last segment
+    size_t memoryLimit;             // Encoded bytes kept in RAM before spilling
+    size_t memoryBytes;
+    size_t capturedBytes;           // Raw bytes of every captured page
+    FILE* spillFile;
+    uint64_t spillBytes;
+    std::mutex lock;                // Guards storage and the spill file
+} MemorySnapshot;
+
+void initMemorySnapshot(MemorySnapshot* snapshot, size_t memoryLimit);
+void freeMemorySnapshot(MemorySnapshot* snapshot);
+bool hasMemorySnapshot(const MemorySnapshot* snapshot);
+
+// Adds a page-aligned region and returns its index. Its pages start out
+// SNAPSHOT_PAGE_MISSING until stored.
+size_t addSnapshotRegion(MemorySnapshot* snapshot, uintptr_t base, SIZE_T size);
+
+// Encodes pageCount pages from data and stores them starting at firstPage.
+// scratch is the caller's reusable encode buffer. Safe to call from
+// several threads for disjoint pages.
+bool storeSnapshotPages(MemorySnapshot* snapshot, size_t firstPage, const BYTE* data, size_t pageCount,
+                        std::vector<BYTE>& scratch);
+
+// Decodes pageCount pages starting at firstPage into out. valid[i] is set
+// to whether page i was captured. Safe to call from several threads.
+void loadSnapshotPages(MemorySnapshot* snapshot, size_t firstPage, size_t pageCount, BYTE* out, bool* valid,
+                       std::vector<BYTE>& scratch);
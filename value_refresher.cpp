@@ -0,0 +1,191 @@
+#include "platform.h"
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#include "value_refresher.h"
+#include "logging.h"
+
+void readValuesCoalesced(MemorySource* memory, const std::vector<uintptr_t>& addresses, size_t valueSize,
+                         std::vector<RefreshedValue>& values) {
+    values.resize(addresses.size());
+    if (addresses.empty()) {
+        return;
+    }
+
+    // Group addresses whose values all fit in one REFRESH_READ_SPAN window.
+    std::vector<size_t> groupStart;
+    std::vector<ScatterEntry> entries;
+    for (size_t i = 0; i < addresses.size(); ) {
+        size_t end = i + 1;
+        while (end < addresses.size() && addresses[end] + valueSize - addresses[i] <= REFRESH_READ_SPAN) {
+            end++;
+        }
+        ScatterEntry entry;
+        entry.address = addresses[i];
+        entry.buffer = nullptr;
+        entry.size = addresses[end - 1] + valueSize - addresses[i];
+        entry.bytesRead = 0;
+        entries.push_back(entry);
+        groupStart.push_back(i);
+        i = end;
+    }
+
+    std::vector<BYTE> buffer(entries.size() * REFRESH_READ_SPAN);
+    for (size_t g = 0; g < entries.size(); g++) {
+        entries[g].buffer = &buffer[g * REFRESH_READ_SPAN];
+    }
+    memory->readScatter(entries.data(), entries.size());
+
+    for (size_t g = 0; g < entries.size(); g++) {
+        size_t end = g + 1 < groupStart.size() ? groupStart[g + 1] : addresses.size();
+        const BYTE* data = (const BYTE*)entries[g].buffer;
+        for (size_t i = groupStart[g]; i < end; i++) {
+            RefreshedValue& value = values[i];
+            size_t offset = addresses[i] - entries[g].address;
+            value.address = addresses[i];
+            value.lastChanged = 0;
+            value.bytesRead = entries[g].bytesRead > offset ? std::min(entries[g].bytesRead - offset, valueSize) : 0;
+            memset(value.value, 0, sizeof(value.value));
+            memcpy(value.value, &data[offset], value.bytesRead);
+        }
+    }
+}
+
+// Carries lastChanged over from the previous pass for addresses that were
+// tracked before, stamping now where the value differs.
+static void updateChangeTimes(std::vector<RefreshedValue>& values, const std::vector<RefreshedValue>& previous,
+                              DWORD now) {
+    size_t p = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+        RefreshedValue& value = values[i];
+        value.lastChanged = 0;
+        while (p < previous.size() && previous[p].address < value.address) {
+            p++;
+        }
+        if (p < previous.size() && previous[p].address == value.address) {
+            const RefreshedValue& old = previous[p];
+            bool changed = old.bytesRead != value.bytesRead ||
+                           memcmp(old.value, value.value, sizeof(value.value)) != 0;
+            value.lastChanged = changed ? now : old.lastChanged;
+        }
+    }
+}
+
+static void valueRefresherThreadFunc(ValueRefresher* refresher) {
+    std::vector<uintptr_t> addresses;
+    size_t valueSize = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(refresher->watchLock);
+            if (!refresher->watchedChanged) {
+                int interval = refresher->settings ? refresher->settings->refreshInterval : 1000;
+                refresher->wake.wait_for(lock, std::chrono::milliseconds(std::max(interval, 10)));
+            }
+            if (!refresher->running) {
+                break;
+            }
+            bool forced = refresher->watchedChanged;
+            refresher->watchedChanged = false;
+            if (!forced && refresher->settings && !refresher->settings->autoRefreshResults) {
+                continue;
+            }
+            addresses = refresher->watched;
+            valueSize = refresher->valueSize;
+        }
+
+        // The front buffer is only replaced by this thread, so it can be
+        // read here without swapLock.
+        ValueCache& back = refresher->caches[1 - refresher->front];
+        {
+            std::lock_guard<std::mutex> lock(refresher->readLock);
+            if (refresher->memory) {
+                readValuesCoalesced(refresher->memory, addresses, valueSize, back.values);
+            } else {
+                back.values.clear();
+            }
+        }
+        back.refreshTime = GetTickCount();
+        updateChangeTimes(back.values, refresher->caches[refresher->front].values, back.refreshTime);
+
+        std::lock_guard<std::mutex> lock(refresher->swapLock);
+        refresher->front = 1 - refresher->front;
+    }
+}
+
+void startValueRefresher(ValueRefresher* refresher, const Settings* settings) {
+    refresher->settings = settings;
+    refresher->memory = nullptr;
+    refresher->valueSize = sizeof(int);
+    refresher->watched.clear();
+    refresher->watchedChanged = false;
+    for (int i = 0; i < 2; i++) {
+        refresher->caches[i].values.clear();
+        refresher->caches[i].refreshTime = 0;
+    }
+    refresher->front = 0;
+    refresher->running = true;
+    refresher->thread = std::thread(valueRefresherThreadFunc, refresher);
+    LOG_DEBUG("Value refresher started");
+}
+
+void stopValueRefresher(ValueRefresher* refresher) {
+    {
+        std::lock_guard<std::mutex> lock(refresher->watchLock);
+        if (!refresher->running) {
+            return;
+        }
+        refresher->running = false;
+    }
+    refresher->wake.notify_all();
+    if (refresher->thread.joinable()) {
+        refresher->thread.join();
+    }
+    LOG_DEBUG("Value refresher stopped");
+}
+
+void setValueRefresherSource(ValueRefresher* refresher, MemorySource* memory) {
+    {
+        std::lock_guard<std::mutex> lock(refresher->readLock);
+        refresher->memory = memory;
+    }
+    {
+        std::lock_guard<std::mutex> lock(refresher->watchLock);
+        refresher->watchedChanged = true;
+    }
+    refresher->wake.notify_all();
+}
+
+void watchValues(ValueRefresher* refresher, const std::vector<uintptr_t>& addresses, size_t valueSize) {
+    valueSize = std::min(valueSize, sizeof(RefreshedValue::value));
+    {
+        std::lock_guard<std::mutex> lock(refresher->watchLock);
+        if (refresher->watched == addresses && refresher->valueSize == valueSize) {
+            return;
+        }
+        refresher->watched = addresses;
+        refresher->valueSize = valueSize;
+        refresher->watchedChanged = true;
+    }
+    refresher->wake.notify_all();
+}
+
+const ValueCache* acquireValueCache(ValueRefresher* refresher) {
+    refresher->swapLock.lock();
+    return &refresher->caches[refresher->front];
+}
+
+void releaseValueCache(ValueRefresher* refresher) {
+    refresher->swapLock.unlock();
+}
+
+const RefreshedValue* findRefreshedValue(const ValueCache* cache, uintptr_t address) {
+    std::vector<RefreshedValue>::const_iterator it = std::lower_bound(
+        cache->values.begin(), cache->values.end(), address,
+        [](const RefreshedValue& value, uintptr_t target) { return value.address < target; });
+    if (it == cache->values.end() || it->address != address) {
+        return nullptr;
+    }
+    return &*it;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "platform.h"
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "memory_source.h"
+#include "settings.h"
+
+// Background reader for the live values of tracked result addresses. The UI
+// posts the addresses it shows; a worker thread re-reads them every
+// refreshInterval ms while autoRefreshResults is on, merging addresses that
+// share a page into a single read. Each pass fills the back buffer of a
+// double-buffered value cache and then swaps it to the front, so the UI
+// only ever looks at a finished front buffer and never waits on a read.
+// Live values stay in the cache: neither the worker nor the table writes
+// them to the result store, whose values next scans compare against.
+
+const size_t REFRESH_READ_SPAN = 4096;  // Largest merged read
+
+typedef struct {
+    uintptr_t address;
+    BYTE value[8];
+    size_t bytesRead;       // 0 when the read failed
+    DWORD lastChanged;      // GetTickCount() of the last change, 0 if none seen
+} RefreshedValue;
+
+typedef struct {
+    std::vector<RefreshedValue> values;     // Ascending by address
+    DWORD refreshTime;                      // GetTickCount() of the pass
+} ValueCache;
+
+typedef struct {
+    std::thread thread;
+    bool running;
+    const Settings* settings;
+
+    std::mutex readLock;                    // Guards memory across a read
+    MemorySource* memory;                   // Source to read from, may be nullptr
+
+    std::mutex watchLock;                   // Guards the tracked list and wake
+    std::condition_variable wake;
+    std::vector<uintptr_t> watched;         // Addresses posted by the UI, ascending
+    size_t valueSize;
+    bool watchedChanged;
+
+    std::mutex swapLock;                    // Held by readers of the front buffer
+    ValueCache caches[2];
+    int front;
+} ValueRefresher;
+
+void startValueRefresher(ValueRefresher* refresher, const Settings* settings);
+void stopValueRefresher(ValueRefresher* refresher);
+
+// Swaps the source. Blocks until a read in flight has finished, so the old
+// source can be deleted as soon as this returns.
+void setValueRefresherSource(ValueRefresher* refresher, MemorySource* memory);
+
+// Replaces the tracked addresses (ascending). A changed list is refreshed
+// right away instead of waiting for the next interval.
+void watchValues(ValueRefresher* refresher, const std::vector<uintptr_t>& addresses, size_t valueSize);
+
+// Locks and returns the front buffer; release it with
+// releaseValueCache once the frame is done with it.
+const ValueCache* acquireValueCache(ValueRefresher* refresher);
+void releaseValueCache(ValueRefresher* refresher);
+const RefreshedValue* findRefreshedValue(const ValueCache* cache, uintptr_t address);
+
+// Reads every address (ascending), merging those that fit in one
+// REFRESH_READ_SPAN window into a single scatter entry.
+void readValuesCoalesced(MemorySource* memory, const std::vector<uintptr_t>& addresses, size_t valueSize,
+                         std::vector<RefreshedValue>& values);
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stddef.h>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <vector>
+
+// Per-worker deques with work stealing. Each worker drains its own queue
+// from the front; a worker that runs dry takes the back half of the fullest
+// other queue, so neighbouring items stay together and one large region
+// split into many items still spreads across every worker.
+template<typename T>
+class WorkStealingQueue {
+private:
+    struct WorkerQueue {
+        std::mutex lock;
+        std::deque<T> items;
+    };
+
+    std::vector<WorkerQueue*> queues;
+    std::atomic<size_t> stealCount;
+
+    bool stealInto(int worker) {
+        int victim = -1;
+        size_t victimSize = 0;
+        for (int i = 0; i < (int)queues.size(); i++) {
+            if (i == worker) continue;
+            std::lock_guard<std::mutex> lock(queues[i]->lock);
+            if (queues[i]->items.size() > victimSize) {
+                victimSize = queues[i]->items.size();
+                victim = i;
+            }
+        }
+        if (victim < 0) {
+            return false;
+        }
+
+        std::vector<T> stolen;
+        {
+            std::lock_guard<std::mutex> lock(queues[victim]->lock);
+            std::deque<T>& items = queues[victim]->items;
+            size_t take = (items.size() + 1) / 2;
+            if (take == 0) {
+                return false;
+            }
+            stolen.assign(items.end() - take, items.end());
+            items.erase(items.end() - take, items.end());
+        }
+
+        std::lock_guard<std::mutex> lock(queues[worker]->lock);
+        queues[worker]->items.insert(queues[worker]->items.end(), stolen.begin(), stolen.end());
+        stealCount++;
+        return true;
+    }
+
+public:
+    explicit WorkStealingQueue(int workerCount) : stealCount(0) {
+        if (workerCount < 1) workerCount = 1;
+        for (int i = 0; i < workerCount; i++) {
+            queues.push_back(new WorkerQueue());
+        }
+    }
+
+    ~WorkStealingQueue() {
+        for (size_t i = 0; i < queues.size(); i++) {
+            delete queues[i];
+        }
+    }
+
+    // Deals items out as contiguous runs, one run per worker.
+    void distribute(const std::vector<T>& items) {
+        size_t workers = queues.size();
+        size_t perWorker = (items.size() + workers - 1) / workers;
+        for (size_t w = 0; w < workers; w++) {
+            size_t begin = w * perWorker;
+            size_t end = begin + perWorker;
+            if (begin > items.size()) begin = items.size();
+            if (end > items.size()) end = items.size();
+
+            std::lock_guard<std::mutex> lock(queues[w]->lock);
+            queues[w]->items.insert(queues[w]->items.end(), items.begin() + begin, items.begin() + end);
+        }
+    }
+
+    // Returns false once every queue is empty.
+    bool next(int worker, T* item) {
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(queues[worker]->lock);
+                if (!queues[worker]->items.empty()) {
+                    *item = queues[worker]->items.front();
+                    queues[worker]->items.pop_front();
+                    return true;
+                }
+            }
+            if (!stealInto(worker)) {
+                return false;
+            }
+        }
+    }
+
+    int workerCount() const { return (int)queues.size(); }
+    size_t steals() const { return stealCount.load(); }
+};
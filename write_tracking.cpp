@@ -0,0 +1,116 @@
+#include "write_tracking.h"
+#include "logging.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace {
+
+const size_t WRITE_QUERY_GAP_PAGES = 16;    // Values this many pages apart share a query
+const size_t WRITE_QUERY_MAX_PAGES = 4096;
+
+// Steps run one at a time, so the record's owner needs no lock.
+bool g_trackingActive = false;
+DWORD g_trackedProcess = 0;
+size_t g_lastWritten = 0;
+size_t g_lastChecked = 0;
+DWORD g_unsupportedProcess = 0;             // Last process told it has no tracking
+
+}
+
+bool beginWriteTracking(MemorySource* memory) {
+    bool started = memory && memory->resetWrittenPages();
+    g_trackingActive = started;
+    g_trackedProcess = started ? memory->processId() : 0;
+    g_lastWritten = 0;
+    g_lastChecked = 0;
+    if (!started && memory && g_unsupportedProcess != memory->processId()) {
+        g_unsupportedProcess = memory->processId();
+        LOG_INFO("Write tracking unavailable for process %lu, next scans read every value", memory->processId());
+    }
+    return started;
+}
+
+void endWriteTracking() {
+    g_trackingActive = false;
+    g_trackedProcess = 0;
+}
+
+bool startIncrementalStep(MemorySource* memory) {
+    if (g_trackingActive && g_trackedProcess == memory->processId()) {
+        if (g_lastWritten * 2 <= g_lastChecked || g_lastChecked == 0) {
+            return true;
+        }
+        LOG_DEBUG("%zu of %zu checked were written, restarting write tracking", g_lastWritten, g_lastChecked);
+    }
+    beginWriteTracking(memory);
+    return false;
+}
+
+void noteWrittenShare(size_t written, size_t checked) {
+    g_lastWritten = written;
+    g_lastChecked = checked;
+}
+
+bool queryWrittenPages(MemorySource* memory, const std::vector<MemoryRegion>& regions, uintptr_t address,
+                       size_t pageCount, BYTE* written) {
+    if (!memory->queryWrittenPages(address, pageCount, written)) {
+        return false;
+    }
+
+    const uintptr_t end = address + pageCount * RESIDENCY_PAGE_SIZE;
+    std::vector<MemoryRegion>::const_iterator it = std::upper_bound(
+        regions.begin(), regions.end(), address,
+        [](uintptr_t value, const MemoryRegion& r) { return value < r.base; });
+    if (it != regions.begin()) {
+        --it;
+    }
+    for (; it != regions.end() && it->base < end; ++it) {
+        if (it->state == MEM_COMMIT && it->type != MEM_MAPPED) {
+            continue;
+        }
+        uintptr_t from = std::max(it->base, address);
+        uintptr_t to = std::min(it->base + it->size, end);
+        if (from >= to) {
+            continue;
+        }
+        size_t first = (from - address) / RESIDENCY_PAGE_SIZE;
+        size_t last = (to - address + RESIDENCY_PAGE_SIZE - 1) / RESIDENCY_PAGE_SIZE;
+        memset(written + first, 1, last - first);
+    }
+    return true;
+}
+
+bool findWrittenValues(MemorySource* memory, const std::vector<MemoryRegion>& regions, uintptr_t base,
+                       const uint32_t* offsets, size_t count, SIZE_T size, BYTE* written,
+                       std::vector<BYTE>& pageFlags) {
+    size_t first = 0;
+    while (first < count) {
+        uintptr_t firstPage = (base + offsets[first]) / RESIDENCY_PAGE_SIZE;
+        uintptr_t lastPage = (base + offsets[first] + size - 1) / RESIDENCY_PAGE_SIZE;
+        size_t end = first + 1;
+        for (; end < count; end++) {
+            uintptr_t start = (base + offsets[end]) / RESIDENCY_PAGE_SIZE;
+            uintptr_t stop = (base + offsets[end] + size - 1) / RESIDENCY_PAGE_SIZE;
+            if (start > lastPage + WRITE_QUERY_GAP_PAGES || stop - firstPage >= WRITE_QUERY_MAX_PAGES) {
+                break;
+            }
+            lastPage = std::max(lastPage, stop);
+        }
+
+        size_t pageCount = lastPage - firstPage + 1;
+        pageFlags.resize(pageCount);
+        if (!queryWrittenPages(memory, regions, firstPage * RESIDENCY_PAGE_SIZE, pageCount, pageFlags.data())) {
+            memset(written, 1, count);
+            return false;
+        }
+        // Values are at most 8 bytes, so they span one page or two.
+        for (size_t i = first; i < end; i++) {
+            uintptr_t address = base + offsets[i];
+            written[i] = pageFlags[address / RESIDENCY_PAGE_SIZE - firstPage] |
+                         pageFlags[(address + size - 1) / RESIDENCY_PAGE_SIZE - firstPage];
+        }
+        first = end;
+    }
+    return true;
+}
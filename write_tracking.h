@@ -0,0 +1,49 @@
+#pragma once
+
+#include "platform.h"
+#include <stdint.h>
+#include <vector>
+
+#include "memory_source.h"
+
+// Incremental next scans. Once the target's record of written pages has
+// been reset (soft-dirty bits on Linux), a page it has not written since
+// still holds what any read made after the reset returned. Next scan steps
+// reuse the stored values of such pages instead of reading them again, and
+// only re-read pages written since. The record is reset right before a
+// step that reads every value it keeps: a first scan, the snapshot capture,
+// or a next scan that found most of its pages written last time. Shared
+// mappings can be written by other processes without the target's record
+// noticing, so their pages always count as written.
+
+// Starts a fresh record for memory's process. Values read after this stay
+// reusable until the next reset. Returns false when the source cannot track
+// writes, in which case nothing is reused.
+bool beginWriteTracking(MemorySource* memory);
+
+// Forgets the record, e.g. when a step that reset it kept older values.
+void endWriteTracking();
+
+// Called at the start of a next scan step. Returns true when stored values
+// of unwritten pages may be reused; otherwise starts a fresh record for the
+// reads this step makes.
+bool startIncrementalStep(MemorySource* memory);
+
+// How many of the values or pages a step checked were on written pages.
+// Once most were, the next step starts over instead of reusing.
+void noteWrittenShare(size_t written, size_t checked);
+
+// Sets written[i] to 1 for each of pageCount pages from the page-aligned
+// address that may have changed since the record was reset, treating pages
+// outside private and image regions as written. Returns false when the
+// source cannot tell.
+bool queryWrittenPages(MemorySource* memory, const std::vector<MemoryRegion>& regions, uintptr_t address,
+                       size_t pageCount, BYTE* written);
+
+// Same for count values of size bytes at base + offsets[i] (ascending):
+// written[i] is 1 when a page under the value may have changed. Nearby
+// values share one query. Returns false, with every value marked written,
+// when the source cannot tell.
+bool findWrittenValues(MemorySource* memory, const std::vector<MemoryRegion>& regions, uintptr_t base,
+                       const uint32_t* offsets, size_t count, SIZE_T size, BYTE* written,
+                       std::vector<BYTE>& pageFlags);